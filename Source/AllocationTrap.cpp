@@ -0,0 +1,289 @@
+#include "Headers.h"
+
+#if SOUNDOFLIFE_TRAP_ALLOCATIONS
+ #include <cstddef>
+ #include <cstdlib>
+ #include <new>
+#endif
+
+#if SOUNDOFLIFE_TRAP_ALLOCATIONS && JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+#if SOUNDOFLIFE_TRAP_MALLOC
+// glibc's own allocators, which the replacements below forward to.
+extern "C" void* __libc_malloc (std::size_t size);
+extern "C" void* __libc_calloc (std::size_t count, std::size_t size);
+extern "C" void* __libc_realloc (void* data, std::size_t size);
+extern "C" void* __libc_memalign (std::size_t alignment, std::size_t size);
+extern "C" void __libc_free (void* data);
+#endif
+
+
+//================================================//
+// Scoped guard which traps heap allocations on the current thread.
+
+#if SOUNDOFLIFE_TRAP_ALLOCATIONS
+
+namespace
+{
+   #if SOUNDOFLIFE_TRAP_MALLOC
+    // Initial exec, so that reading it from malloc never allocates thread local storage itself.
+    __attribute__ ((tls_model ("initial-exec")))
+   #endif
+    thread_local bool isTrapActive = false;                         // Whether a guard is alive on this thread.
+    std::atomic<int> numTrappedAllocations { 0 };                   // Allocations made while any guard was alive.
+    
+    /**
+        Allocates without going through the trap.
+        @param size Number of bytes.
+        @param alignment Alignment in bytes, a power of two.
+     */
+    
+    void* allocateUntrapped (std::size_t size, std::size_t alignment)
+    {
+        size = size == 0 ? 1 : size;
+       
+       #if SOUNDOFLIFE_TRAP_MALLOC
+        return alignment <= alignof (std::max_align_t) ? __libc_malloc (size) : __libc_memalign (alignment, size);
+       #elif JUCE_WINDOWS
+        return alignment <= alignof (std::max_align_t) ? std::malloc (size) : _aligned_malloc (size, alignment);
+       #else
+        void* data = nullptr;
+        
+        if (alignment <= alignof (std::max_align_t))
+            return std::malloc (size);
+        
+        return posix_memalign (&data, alignment, size) == 0 ? data : nullptr;
+       #endif
+    }
+    
+    /**
+        Frees memory from allocateUntrapped.
+        @param data Memory to free.
+        @param alignment Alignment it was allocated with.
+     */
+    
+    void freeUntrapped (void* data, std::size_t alignment)
+    {
+       #if SOUNDOFLIFE_TRAP_MALLOC
+        juce::ignoreUnused (alignment);
+        __libc_free (data);
+       #elif JUCE_WINDOWS
+        if (alignment <= alignof (std::max_align_t))
+            std::free (data);
+        else
+            _aligned_free (data);
+       #else
+        juce::ignoreUnused (alignment);
+        std::free (data);
+       #endif
+    }
+    
+    /**
+        Counts and makes an allocation for operator new, throwing if it fails.
+        @param size Number of bytes.
+        @param alignment Alignment in bytes, a power of two.
+     */
+    
+    void* allocate (std::size_t size, std::size_t alignment)
+    {
+        AllocationTrap::onAllocation();
+        
+        if (void* data = allocateUntrapped (size, alignment))
+            return data;
+        
+        throw std::bad_alloc();
+    }
+}
+
+/**
+    Starts trapping allocations made on the calling thread.
+    @param scopeName Name of the guarded scope, used when reporting.
+    @param assertOnAllocation Whether allocations are reported and asserted on when the guard dies, false only counting them.
+ */
+
+AllocationTrap::AllocationTrap (const char* scopeName, bool assertOnAllocation)
+    :   m_ScopeName (scopeName),
+        m_NumAllocationsAtStart (numTrappedAllocations.load()),
+        m_WasActive (isTrapActive),
+        m_AssertOnAllocation (assertOnAllocation)
+{
+    isTrapActive = true;
+}
+
+/**
+    Stops trapping and reports any allocation made since the guard was created.
+    Reporting allocates, so it only happens once the trap is off.
+ */
+
+AllocationTrap::~AllocationTrap()
+{
+    isTrapActive = m_WasActive;
+    
+    int numAllocations = numTrappedAllocations.load() - m_NumAllocationsAtStart;
+    
+    if (numAllocations > 0 && ! m_WasActive && m_AssertOnAllocation)
+    {
+        DBG (juce::String (m_ScopeName) + " allocated on the heap " + juce::String (numAllocations) + " times");
+        jassertfalse;
+    }
+}
+
+/**
+    Called by every trapped allocator, counts the allocation if the calling thread is trapped.
+ */
+
+void AllocationTrap::onAllocation()
+{
+    if (isTrapActive)
+        ++numTrappedAllocations;
+}
+
+int AllocationTrap::getNumTrappedAllocations()                      { return numTrappedAllocations.load(); }
+
+
+//================================================//
+// Global allocation operators, replaced so every allocation goes through the trap.
+
+void* operator new (std::size_t size)                                           { return allocate (size, alignof (std::max_align_t)); }
+void* operator new[] (std::size_t size)                                         { return allocate (size, alignof (std::max_align_t)); }
+void* operator new (std::size_t size, std::align_val_t alignment)               { return allocate (size, (std::size_t) alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)             { return allocate (size, (std::size_t) alignment); }
+
+void operator delete (void* data) noexcept                                      { freeUntrapped (data, alignof (std::max_align_t)); }
+void operator delete[] (void* data) noexcept                                    { freeUntrapped (data, alignof (std::max_align_t)); }
+void operator delete (void* data, std::size_t) noexcept                         { freeUntrapped (data, alignof (std::max_align_t)); }
+void operator delete[] (void* data, std::size_t) noexcept                       { freeUntrapped (data, alignof (std::max_align_t)); }
+void operator delete (void* data, std::align_val_t alignment) noexcept          { freeUntrapped (data, (std::size_t) alignment); }
+void operator delete[] (void* data, std::align_val_t alignment) noexcept        { freeUntrapped (data, (std::size_t) alignment); }
+void operator delete (void* data, std::size_t, std::align_val_t alignment) noexcept     { freeUntrapped (data, (std::size_t) alignment); }
+void operator delete[] (void* data, std::size_t, std::align_val_t alignment) noexcept   { freeUntrapped (data, (std::size_t) alignment); }
+
+
+#if SOUNDOFLIFE_TRAP_MALLOC
+
+//================================================//
+// C allocators, interposed so that juce::HeapBlock and anything else using them is trapped too.
+
+extern "C"
+{
+    void* malloc (std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        return __libc_malloc (size);
+    }
+    
+    void* calloc (std::size_t count, std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        return __libc_calloc (count, size);
+    }
+    
+    void* realloc (void* data, std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        return __libc_realloc (data, size);
+    }
+    
+    void* memalign (std::size_t alignment, std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        return __libc_memalign (alignment, size);
+    }
+    
+    void* aligned_alloc (std::size_t alignment, std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        return __libc_memalign (alignment, size);
+    }
+    
+    int posix_memalign (void** data, std::size_t alignment, std::size_t size)
+    {
+        AllocationTrap::onAllocation();
+        *data = __libc_memalign (alignment, size);
+        return *data != nullptr ? 0 : ENOMEM;
+    }
+    
+    void free (void* data)
+    {
+        __libc_free (data);
+    }
+}
+
+#endif
+
+#else
+
+AllocationTrap::AllocationTrap (const char*, bool) {}
+
+AllocationTrap::~AllocationTrap() {}
+
+int AllocationTrap::getNumTrappedAllocations()                      { return 0; }
+
+#endif
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS && SOUNDOFLIFE_TRAP_ALLOCATIONS
+
+/// Checks that the allocations the audio thread could make are caught, and that code which doesn't allocate isn't.
+
+class AllocationTrapTests : public juce::UnitTest
+{
+public:
+    AllocationTrapTests() : juce::UnitTest ("AllocationTrap", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        beginTest ("Growing an AudioBuffer");
+        
+        juce::AudioBuffer<float> buffer (2, 16);
+        
+        expectGreaterThan (countAllocations ([&buffer] { buffer.setSize (2, 1 << 16); }), 0);
+        expectEquals (countAllocations ([&buffer] { buffer.setSize (2, 16, false, false, true); }), 0);
+        
+        beginTest ("Growing an Array");
+        
+        juce::Array<float> array;
+        
+        expectGreaterThan (countAllocations ([&array] { array.resize (1 << 16); }), 0);
+        
+        beginTest ("Aligned operator new");
+        
+        expectGreaterThan (countAllocations ([] { ::operator delete (::operator new (256, std::align_val_t (64)), std::align_val_t (64)); }), 0);
+       
+       #if SOUNDOFLIFE_TRAP_MALLOC
+        beginTest ("C allocators");
+        
+        expectGreaterThan (countAllocations ([] { void* volatile data = std::malloc (256); std::free (data); }), 0);
+        expectGreaterThan (countAllocations ([] { void* volatile data = std::calloc (16, 16); std::free (data); }), 0);
+        expectGreaterThan (countAllocations ([] { juce::HeapBlock<float> block; block.malloc (256); }), 0);
+       #endif
+    }
+
+private:
+    /**
+        Returns the number of allocations trapped while running a function.
+        @param function Function to run inside a trap which only counts.
+     */
+    
+    template <typename Function>
+    int countAllocations (Function&& function)
+    {
+        int numAllocationsAtStart = AllocationTrap::getNumTrappedAllocations();
+        
+        {
+            const AllocationTrap allocationTrap ("AllocationTrapTests", false);
+            function();
+        }
+        
+        return AllocationTrap::getNumTrappedAllocations() - numAllocationsAtStart;
+    }
+};
+
+static AllocationTrapTests allocationTrapTests;
+
+#endif
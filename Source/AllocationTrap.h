@@ -0,0 +1,48 @@
+#pragma once
+
+
+// Set to 1 (for example in the Projucer preprocessor definitions) to count every heap
+// allocation made while an AllocationTrap is in scope.
+#ifndef SOUNDOFLIFE_TRAP_ALLOCATIONS
+ #define SOUNDOFLIFE_TRAP_ALLOCATIONS 0
+#endif
+
+// Whether malloc, calloc, realloc and the aligned C allocators are trapped as well as operator new.
+// They are replaced by interposition, which only glibc supports, and which only takes effect when the
+// trap is linked into the executable itself, such as the standalone, the offline renderer or the benchmarks.
+// Elsewhere juce::HeapBlock, and so juce::AudioBuffer and juce::Array, allocate without being trapped.
+#if SOUNDOFLIFE_TRAP_ALLOCATIONS && defined (__GLIBC__)
+ #define SOUNDOFLIFE_TRAP_MALLOC 1
+#else
+ #define SOUNDOFLIFE_TRAP_MALLOC 0
+#endif
+
+
+//================================================//
+/// Scoped guard which traps heap allocations made on the current thread while it is alive.
+/// Used around the audio callback to make sure it never allocates. Every form of operator new
+/// is trapped, including the aligned ones, and the malloc family too where SOUNDOFLIFE_TRAP_MALLOC is set.
+/// When trapping is disabled at compile time the guard does nothing and costs nothing.
+
+class AllocationTrap
+{
+public:
+    AllocationTrap (const char* scopeName, bool assertOnAllocation = true);
+    ~AllocationTrap();
+    
+    // Getter methods.
+    static int getNumTrappedAllocations();
+    
+   #if SOUNDOFLIFE_TRAP_ALLOCATIONS
+    // Trap methods.
+    static void onAllocation();
+    
+private:
+    const char* m_ScopeName;                                        // Name of the guarded scope, used when reporting.
+    int m_NumAllocationsAtStart;                                    // Trapped allocation count when the guard was created.
+    bool m_WasActive;                                               // Whether an outer guard was already active on this thread.
+    bool m_AssertOnAllocation;                                      // Whether allocations are reported and asserted on, rather than only counted.
+   #endif
+    
+    JUCE_DECLARE_NON_COPYABLE (AllocationTrap)
+};
@@ -0,0 +1,269 @@
+#include "Headers.h"
+
+
+//================================================//
+// Bit-packed grid which stores one cell per bit and updates 64 cells at a time.
+
+BitGrid::BitGrid() {}
+
+BitGrid::~BitGrid() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Allocates storage for a grid of the given size and clears all cells.
+    @param numRows Number of rows.
+    @param numColumns Number of columns.
+ */
+
+void BitGrid::setSize (int numRows, int numColumns)
+{
+    m_NumRows = numRows;
+    m_NumColumns = numColumns;
+    m_NumWords = (numColumns + 63) / 64;
+    
+    // Bits past the last column are kept dead so they never count as neighbours.
+    int numUsedBits = numColumns - (m_NumWords - 1) * 64;
+    m_LastWordMask = numUsedBits == 64 ? ~(juce::uint64) 0 : (((juce::uint64) 1 << numUsedBits) - 1);
+    
+    m_Words.calloc ((size_t) (m_NumRows * m_NumWords));
+    m_NextWords.calloc ((size_t) (m_NumRows * m_NumWords));
+    m_EmptyRow.calloc ((size_t) m_NumWords);
+    
+    m_NumTileRows = (m_NumRows + Variables::tileNumRows - 1) / Variables::tileNumRows;
+    m_NumTileColumns = (m_NumWords + Variables::tileNumWords - 1) / Variables::tileNumWords;
+    
+    m_TileChanged.calloc ((size_t) getNumTiles());
+    m_NextTileChanged.calloc ((size_t) getNumTiles());
+    setAllTilesChanged();
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the state of a cell to alive or dead.
+    @param row Row index of the cell.
+    @param column Column index of the cell.
+    @param isAlive State of the cell.
+ */
+
+void BitGrid::setCellIsAlive (int row, int column, bool isAlive)
+{
+    juce::uint64& word = getRow (row)[column >> 6];
+    juce::uint64 bit = (juce::uint64) 1 << (column & 63);
+    
+    if (isAlive)
+        word |= bit;
+    
+    else
+        word &= ~bit;
+    
+    // The next generation buffer no longer matches this tile, so it can't be skipped.
+    m_TileChanged[(row / Variables::tileNumRows) * m_NumTileColumns + (column >> 6) / Variables::tileNumWords] = true;
+}
+
+
+//================================================//
+// Getter methods.
+
+/**
+    Returns boolean representing the state of the cell.
+    @param row Row index of the cell.
+    @param column Column index of the cell.
+ */
+
+bool BitGrid::getCellIsAlive (int row, int column)
+{
+    return (getRow (row)[column >> 6] >> (column & 63)) & 1;
+}
+
+int BitGrid::getNumRows()                                           { return m_NumRows; }
+int BitGrid::getNumColumns()                                        { return m_NumColumns; }
+int BitGrid::getNumWords()                                          { return m_NumWords; }
+int BitGrid::getNumTiles()                                          { return m_NumTileRows * m_NumTileColumns; }
+int BitGrid::getNumTileRows()                                       { return m_NumTileRows; }
+int BitGrid::getNumTileColumns()                                    { return m_NumTileColumns; }
+bool BitGrid::getTileChanged (int tileIndex)                        { return m_TileChanged[tileIndex]; }
+int BitGrid::getNumSkippedTiles()                                   { return m_NumSkippedTiles; }
+
+/**
+    Returns pointer to the first word of a row.
+    @param row Row index.
+ */
+
+juce::uint64* BitGrid::getRow (int row)
+{
+    return m_Words + (size_t) row * (size_t) m_NumWords;
+}
+
+
+//================================================//
+// Grid state methods.
+
+/**
+    Updates the state of the entire grid on the calling thread.
+ */
+
+void BitGrid::updateGridState()
+{
+    for (int tileIndex = 0; tileIndex < getNumTiles(); ++tileIndex)
+        updateTileState (tileIndex);
+    
+    swapGenerations();
+}
+
+/**
+    Computes the next generation of a single tile.
+    Tiles only read the current generation and only write their own part of the next one,
+    so the rows bordering a tile act as its halo and tiles can be updated concurrently.
+    Tiles whose neighbourhood had no births or deaths in the last generation are skipped:
+    they can't change, and the next generation buffer already holds the same cells.
+    @param tileIndex Index of the tile, in row-major order.
+ */
+
+void BitGrid::updateTileState (int tileIndex)
+{
+    int tileRow = tileIndex / m_NumTileColumns;
+    int tileColumn = tileIndex % m_NumTileColumns;
+    
+    if (! isTileActive (tileRow, tileColumn))
+    {
+        m_NextTileChanged[tileIndex] = false;
+        return;
+    }
+    
+    int startRow = tileRow * Variables::tileNumRows;
+    int endRow = juce::jmin (startRow + Variables::tileNumRows, m_NumRows);
+    
+    int startWord = tileColumn * Variables::tileNumWords;
+    int endWord = juce::jmin (startWord + Variables::tileNumWords, m_NumWords);
+    
+    juce::uint64 changes = 0;
+    
+    for (int row = startRow; row < endRow; ++row)
+    {
+        const juce::uint64* above = row > 0 ? getRow (row - 1) : m_EmptyRow.get();
+        const juce::uint64* below = row < m_NumRows - 1 ? getRow (row + 1) : m_EmptyRow.get();
+        
+        changes |= updateRowState (above, getRow (row), below, m_NextWords + (size_t) row * (size_t) m_NumWords, startWord, endWord);
+    }
+    
+    m_NextTileChanged[tileIndex] = changes != 0;
+}
+
+/**
+    Makes the generation computed by updateTileState the current one, without copying.
+ */
+
+void BitGrid::swapGenerations()
+{
+    m_NumSkippedTiles = 0;
+    
+    for (int tileIndex = 0; tileIndex < getNumTiles(); ++tileIndex)
+        if (! isTileActive (tileIndex / m_NumTileColumns, tileIndex % m_NumTileColumns))
+            ++m_NumSkippedTiles;
+    
+    m_Words.swapWith (m_NextWords);
+    m_TileChanged.swapWith (m_NextTileChanged);
+}
+
+/**
+    Marks every tile as changed, so the next generation is computed for the whole grid.
+    Needed whenever the current generation is written directly.
+ */
+
+void BitGrid::setAllTilesChanged()
+{
+    for (int tileIndex = 0; tileIndex < getNumTiles(); ++tileIndex)
+        m_TileChanged[tileIndex] = true;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Computes the next state of a row, 64 cells per word, using bitwise adders to count neighbours.
+    @param above Row above the one being updated.
+    @param current Row being updated.
+    @param below Row below the one being updated.
+    @param next Destination for the new row state.
+    @param startWord First word to update.
+    @param endWord Word after the last one to update.
+    Returns a mask of the bits which changed in any of the updated words.
+ */
+
+juce::uint64 BitGrid::updateRowState (const juce::uint64* above, const juce::uint64* current, const juce::uint64* below, juce::uint64* next, int startWord, int endWord)
+{
+    juce::uint64 changes = 0;
+    
+    for (int word = startWord; word < endWord; ++word)
+    {
+        const bool hasLeft = word > 0;
+        const bool hasRight = word < m_NumWords - 1;
+        
+        // Neighbours to the left and right are obtained by shifting in the bits of the adjacent words.
+        juce::uint64 a = above[word];
+        juce::uint64 aLeft = (a << 1) | (hasLeft ? above[word - 1] >> 63 : 0);
+        juce::uint64 aRight = (a >> 1) | (hasRight ? above[word + 1] << 63 : 0);
+        
+        juce::uint64 c = current[word];
+        juce::uint64 cLeft = (c << 1) | (hasLeft ? current[word - 1] >> 63 : 0);
+        juce::uint64 cRight = (c >> 1) | (hasRight ? current[word + 1] << 63 : 0);
+        
+        juce::uint64 b = below[word];
+        juce::uint64 bLeft = (b << 1) | (hasLeft ? below[word - 1] >> 63 : 0);
+        juce::uint64 bRight = (b >> 1) | (hasRight ? below[word + 1] << 63 : 0);
+        
+        // Full adders for the rows above and below, half adder for the current row.
+        juce::uint64 aOnes = aLeft ^ a ^ aRight;
+        juce::uint64 aTwos = (aLeft & a) | (aRight & (aLeft ^ a));
+        
+        juce::uint64 bOnes = bLeft ^ b ^ bRight;
+        juce::uint64 bTwos = (bLeft & b) | (bRight & (bLeft ^ b));
+        
+        juce::uint64 cOnes = cLeft ^ cRight;
+        juce::uint64 cTwos = cLeft & cRight;
+        
+        // Sum the partial counts into a 3 bit neighbour count (a count of 8 wraps to 0, which is dead either way).
+        juce::uint64 ones = aOnes ^ bOnes ^ cOnes;
+        juce::uint64 onesCarry = (aOnes & bOnes) | (cOnes & (aOnes ^ bOnes));
+        
+        juce::uint64 twosSum = aTwos ^ bTwos ^ cTwos;
+        juce::uint64 twosCarry = (aTwos & bTwos) | (cTwos & (aTwos ^ bTwos));
+        
+        juce::uint64 twos = twosSum ^ onesCarry;
+        juce::uint64 fours = twosCarry ^ (twosSum & onesCarry);
+        
+        // A cell is alive next generation with exactly 3 neighbours, or with 2 neighbours if already alive.
+        juce::uint64 result = twos & ~fours & (ones | c);
+        
+        if (word == m_NumWords - 1)
+            result &= m_LastWordMask;
+        
+        next[word] = result;
+        changes |= result ^ c;
+    }
+    
+    return changes;
+}
+
+/**
+    Returns true if the tile or any of its neighbours changed in the last generation.
+    @param tileRow Row of the tile.
+    @param tileColumn Column of the tile.
+ */
+
+bool BitGrid::isTileActive (int tileRow, int tileColumn)
+{
+    for (int row = juce::jmax (0, tileRow - 1); row <= juce::jmin (m_NumTileRows - 1, tileRow + 1); ++row)
+        for (int column = juce::jmax (0, tileColumn - 1); column <= juce::jmin (m_NumTileColumns - 1, tileColumn + 1); ++column)
+            if (m_TileChanged[row * m_NumTileColumns + column])
+                return true;
+    
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+
+//================================================//
+/// Bit-packed grid which stores one cell per bit and updates 64 cells at a time.
+
+class BitGrid
+{
+public:
+    BitGrid();
+    ~BitGrid();
+    
+    // Init methods.
+    void setSize (int numRows, int numColumns);
+    
+    // Setter methods.
+    void setCellIsAlive (int row, int column, bool isAlive);
+    
+    // Getter methods.
+    bool getCellIsAlive (int row, int column);
+    int getNumRows();
+    int getNumColumns();
+    int getNumWords();
+    juce::uint64* getRow (int row);
+    int getNumTiles();
+    int getNumTileRows();
+    int getNumTileColumns();
+    bool getTileChanged (int tileIndex);
+    int getNumSkippedTiles();
+    
+    // Grid state methods.
+    void updateGridState();
+    void updateTileState (int tileIndex);
+    void swapGenerations();
+    void setAllTilesChanged();
+
+private:
+    // Helper methods.
+    juce::uint64 updateRowState (const juce::uint64* above, const juce::uint64* current, const juce::uint64* below, juce::uint64* next, int startWord, int endWord);
+    bool isTileActive (int tileRow, int tileColumn);
+    
+    juce::HeapBlock<juce::uint64> m_Words;                                  // Current generation, one bit per cell, stored row by row.
+    juce::HeapBlock<juce::uint64> m_NextWords;                              // Generation being computed, swapped with the current one after each update.
+    juce::HeapBlock<juce::uint64> m_EmptyRow;                               // Row of dead cells used outside the grid edges.
+    
+    int m_NumRows = 0;                                                      // Number of rows.
+    int m_NumColumns = 0;                                                   // Number of columns.
+    int m_NumWords = 0;                                                     // Number of 64 bit words per row.
+    juce::uint64 m_LastWordMask = 0;                                        // Mask of valid bits in the last word of each row.
+    int m_NumTileRows = 0;                                                  // Number of tiles along the rows.
+    int m_NumTileColumns = 0;                                               // Number of tiles along the columns.
+    juce::HeapBlock<bool> m_TileChanged;                                    // Whether each tile had births or deaths in the last generation.
+    juce::HeapBlock<bool> m_NextTileChanged;                                // Whether each tile has births or deaths in the generation being computed.
+    int m_NumSkippedTiles = 0;                                              // Number of tiles skipped during the last generation.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BitGrid)
+};
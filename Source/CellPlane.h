@@ -0,0 +1,135 @@
+#pragma once
+
+
+//================================================//
+/// View of a contiguous run of cell values, usually one row of a CellPlane.
+/// Does not own the values, and stays valid until the plane is resized.
+
+template <typename Type>
+class CellSpan
+{
+public:
+    CellSpan (Type* data, int size)
+        :   m_Data (data),
+            m_Size (size)
+    {}
+    
+    // Getter methods.
+    Type* data() const                                              { return m_Data; }
+    int size() const                                                { return m_Size; }
+    Type* begin() const                                             { return m_Data; }
+    Type* end() const                                               { return m_Data + m_Size; }
+    Type& operator[] (int index) const                              { return m_Data[index]; }
+    
+    /**
+        Returns a view of part of the span.
+        @param start Index of the first value.
+        @param end Index after the last value.
+     */
+    
+    CellSpan subspan (int start, int end) const
+    {
+        jassert (start >= 0 && start <= end && end <= m_Size);
+        return CellSpan (m_Data + start, end - start);
+    }
+
+private:
+    Type* m_Data;                                                   // First value of the span.
+    int m_Size;                                                     // Number of values in the span.
+};
+
+
+//================================================//
+/// Contiguous plane storing one value per cell, row by row.
+/// Rows start on a Variables::cellPlaneAlignment byte boundary, so every row can be walked
+/// linearly with aligned vector loads. Padding values past the last column are kept at zero.
+
+template <typename Type>
+class CellPlane
+{
+public:
+    CellPlane() {}
+    ~CellPlane() {}
+    
+    // Init methods.
+    
+    /**
+        Allocates storage for a grid of the given size and clears all values.
+        @param numRows Number of rows.
+        @param numColumns Number of columns.
+     */
+    
+    void setSize (int numRows, int numColumns)
+    {
+        static_assert (Variables::cellPlaneAlignment % sizeof (Type) == 0, "Alignment must hold a whole number of values");
+        
+        const int valuesPerAlignment = Variables::cellPlaneAlignment / (int) sizeof (Type);
+        
+        m_NumRows = numRows;
+        m_NumColumns = numColumns;
+        m_Stride = (numColumns + valuesPerAlignment - 1) / valuesPerAlignment * valuesPerAlignment;
+        
+        m_Storage.calloc ((size_t) (m_NumRows * m_Stride) * sizeof (Type) + Variables::cellPlaneAlignment);
+        
+        // HeapBlock only guarantees malloc alignment, so the first row is moved up to the next boundary.
+        auto address = reinterpret_cast<juce::pointer_sized_uint> (m_Storage.get());
+        auto offset = (Variables::cellPlaneAlignment - address % Variables::cellPlaneAlignment) % Variables::cellPlaneAlignment;
+        m_Data = reinterpret_cast<Type*> (m_Storage.get() + offset);
+    }
+    
+    // Getter methods.
+    int getNumRows() const                                          { return m_NumRows; }
+    int getNumColumns() const                                       { return m_NumColumns; }
+    int getStride() const                                           { return m_Stride; }
+    Type* getData()                                                 { return m_Data; }
+    const Type* getData() const                                     { return m_Data; }
+    
+    /**
+        Returns a view of the cells of a row.
+        @param row Row index.
+     */
+    
+    CellSpan<Type> getRow (int row)
+    {
+        return CellSpan<Type> (m_Data + (size_t) row * (size_t) m_Stride, m_NumColumns);
+    }
+    
+    CellSpan<const Type> getRow (int row) const
+    {
+        return CellSpan<const Type> (m_Data + (size_t) row * (size_t) m_Stride, m_NumColumns);
+    }
+    
+    // State methods.
+    
+    /**
+        Copies every value from another plane of the same size.
+        @param other Plane to copy from.
+     */
+    
+    void copyFrom (const CellPlane& other)
+    {
+        jassert (other.m_NumRows == m_NumRows && other.m_NumColumns == m_NumColumns);
+        std::memcpy (m_Data, other.m_Data, sizeof (Type) * (size_t) (m_NumRows * m_Stride));
+    }
+    
+    /**
+        Exchanges the values of two planes of the same size without copying.
+        @param other Plane to swap with.
+     */
+    
+    void swapWith (CellPlane& other)
+    {
+        jassert (other.m_NumRows == m_NumRows && other.m_NumColumns == m_NumColumns);
+        m_Storage.swapWith (other.m_Storage);
+        std::swap (m_Data, other.m_Data);
+    }
+
+private:
+    juce::HeapBlock<char> m_Storage;                                // Allocated storage, including room for alignment.
+    Type* m_Data = nullptr;                                         // First value of the first row, aligned.
+    int m_NumRows = 0;                                              // Number of rows.
+    int m_NumColumns = 0;                                           // Number of columns.
+    int m_Stride = 0;                                               // Number of values between the start of two rows.
+    
+    JUCE_DECLARE_NON_COPYABLE (CellPlane)
+};
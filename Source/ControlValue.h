@@ -0,0 +1,80 @@
+#pragma once
+
+
+//================================================//
+/// Value computed once per control period and smoothed sample by sample in between.
+/// Linear smoothing reaches each new target exactly at the end of its control period, so
+/// a value which itself moves linearly comes out the same as if it were computed every sample.
+/// One-pole smoothing instead eases towards the target with a fixed time constant.
+
+class ControlValue
+{
+public:
+    ControlValue() {}
+    ~ControlValue() {}
+    
+    // Init methods.
+    
+    /**
+        Sets the smoothing used and jumps straight to a value.
+        @param sampleRate Sample rate to be used.
+        @param value Value to start from.
+     */
+    
+    void prepareToPlay (float sampleRate, float value)
+    {
+        m_UseOnePole = Variables::useOnePoleSmoothing;
+        m_OnePoleCoefficient = 1.0f - std::exp (-1.0f / (Variables::onePoleSmoothingTime * sampleRate));
+        m_Current = value;
+        m_Target = value;
+        m_Step = 0.0f;
+        m_NumSamplesLeft = 0;
+    }
+    
+    // Setter methods.
+    
+    /**
+        Sets the value to move towards over the next control period.
+        @param target Value at the end of the control period.
+        @param numSamples Number of samples in the control period.
+     */
+    
+    void setTarget (float target, int numSamples)
+    {
+        m_Target = target;
+        m_NumSamplesLeft = numSamples;
+        m_Step = numSamples > 0 ? (target - m_Current) / (float) numSamples : 0.0f;
+        
+        if (numSamples <= 0)
+            m_Current = target;
+    }
+    
+    // Getter methods.
+    float getTarget() const                                         { return m_Target; }
+    
+    /**
+        Returns the value for the current sample and moves on to the next one.
+     */
+    
+    float getNextValue()
+    {
+        float value = m_Current;
+        
+        if (m_UseOnePole)
+            m_Current += (m_Target - m_Current) * m_OnePoleCoefficient;
+        
+        // The target is set exactly at the end of the period so rounding errors don't build up.
+        else if (m_NumSamplesLeft > 0)
+            m_Current = --m_NumSamplesLeft == 0 ? m_Target : m_Current + m_Step;
+        
+        return value;
+    }
+    
+private:
+    float m_Current = 0.0f;                                         // Value of the current sample.
+    float m_Target = 0.0f;                                          // Value at the end of the control period.
+    float m_Step = 0.0f;                                            // Linear increment per sample.
+    int m_NumSamplesLeft = 0;                                       // Samples left in the control period.
+    bool m_UseOnePole = false;                                      // Whether one-pole smoothing is used instead of linear smoothing.
+    float m_OnePoleCoefficient = 1.0f;                              // Fraction of the distance to the target covered each sample.
+};
@@ -0,0 +1,628 @@
+#include "Headers.h"
+
+
+//================================================//
+// Partitioned convolution reverb.
+
+ConvolutionReverb::ConvolutionReverb()
+    :   m_Loader (*this),
+        m_TailWorker (*this)
+{
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    m_Loader.stopThread (2000);
+    m_TailWorker.stopThread (2000);
+    
+    clearEngines();
+}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Prepares the reverb for a sample rate, starting its threads. Any impulse response loaded so far
+    is loaded again at the new sample rate, and only used once it is ready.
+    Must not be called while audio is being processed.
+    @param sampleRate Sample rate to use.
+ */
+
+void ConvolutionReverb::prepareToPlay (float sampleRate)
+{
+    m_Loader.stopThread (2000);
+    m_TailWorker.stopThread (2000);
+    
+    clearEngines();
+    m_SampleRate = sampleRate;
+    
+    {
+        const juce::ScopedLock lock (m_RequestLock);
+        m_RequestedSampleRate = sampleRate;
+        m_HasRequest = m_RequestedFile != juce::File();
+    }
+    
+    if (m_IsNonRealtime.load (std::memory_order_relaxed))
+        loadRequestedImpulseResponse();
+    
+    m_Loader.startThread (juce::Thread::Priority::low);
+    m_TailWorker.startThread (juce::Thread::Priority::high);
+}
+
+/**
+    Requests an impulse response, which is read, resampled and partitioned on the loader thread, then
+    replaces the current one from the next block after it is ready. Files which can't be read are
+    ignored. When rendering offline, the file is loaded before returning, so no block misses it.
+    Can be called from any thread but the audio thread.
+    @param file Audio file holding a mono or stereo impulse response.
+ */
+
+void ConvolutionReverb::loadImpulseResponse (const juce::File& file)
+{
+    {
+        const juce::ScopedLock lock (m_RequestLock);
+        m_RequestedFile = file;
+        m_HasRequest = m_RequestedSampleRate > 0.0f;
+    }
+    
+    if (m_IsNonRealtime.load (std::memory_order_relaxed))
+        loadRequestedImpulseResponse();
+    
+    else
+        m_Loader.notify();
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets whether the audio is rendered offline, in which case the audio thread convolves the tail
+    itself instead of leaving it to the tail thread, so the tail is never late however fast blocks come.
+    @param isNonRealtime True when rendering offline.
+ */
+
+void ConvolutionReverb::setNonRealtime (bool isNonRealtime)
+{
+    m_IsNonRealtime.store (isNonRealtime, std::memory_order_relaxed);
+}
+
+
+//================================================//
+// Getter methods.
+
+bool ConvolutionReverb::isLoaded()                                  { return m_ActiveEngine.load (std::memory_order_acquire) != nullptr; }
+int ConvolutionReverb::getNumUnderruns()                            { return m_NumUnderruns.load (std::memory_order_relaxed); }
+
+/**
+    Returns the impulse response requested last, whether or not it has been loaded yet.
+    Must not be called from the audio thread.
+ */
+
+juce::File ConvolutionReverb::getImpulseResponseFile()
+{
+    const juce::ScopedLock lock (m_RequestLock);
+    return m_RequestedFile;
+}
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Adds the convolved signal to a stereo pair of buffers in place, or leaves them untouched while
+    no impulse response is loaded. Picks up impulse responses the loader has finished since the
+    last call, never blocking or freeing memory.
+    @param left Left channel.
+    @param right Right channel.
+    @param numSamples Number of samples.
+ */
+
+void ConvolutionReverb::processStereo (float* left, float* right, int numSamples)
+{
+    // Engines are only swapped once the tail thread has freed the previous one.
+    if (m_RetiredEngine.load (std::memory_order_acquire) == nullptr)
+        if (Engine* pending = m_PendingEngine.exchange (nullptr, std::memory_order_acq_rel))
+            m_RetiredEngine.store (m_ActiveEngine.exchange (pending, std::memory_order_acq_rel), std::memory_order_release);
+    
+    Engine* engine = m_ActiveEngine.load (std::memory_order_relaxed);
+    
+    if (engine == nullptr)
+        return;
+    
+    float* channels[2] = { left, right };
+    
+    for (int start = 0; start < numSamples;)
+    {
+        int numToProcess = juce::jmin (numSamples - start, headSize - engine->headPosition);
+        
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            float* samples = channels[channel] + start;
+            float* input = engine->headInput[channel] + headSize + engine->headPosition;
+            const float* output = engine->headOutput[channel] + engine->headPosition;
+            
+            for (int i = 0; i < numToProcess; ++i)
+            {
+                input[i] = samples[i];
+                samples[i] += Variables::convolutionWetLevel * output[i];
+            }
+        }
+        
+        start += numToProcess;
+        engine->headPosition += numToProcess;
+        
+        if (engine->headPosition == headSize)
+        {
+            processHeadBlock (*engine);
+            engine->headPosition = 0;
+        }
+    }
+}
+
+
+//================================================//
+// Loading methods.
+
+/**
+    Builds an engine for the requested impulse response, if there is a request, and hands it to the
+    audio thread. Called by the loader thread, or by the caller when rendering offline.
+ */
+
+void ConvolutionReverb::loadRequestedImpulseResponse()
+{
+    juce::File file;
+    float sampleRate = 0.0f;
+    
+    {
+        const juce::ScopedLock lock (m_RequestLock);
+        
+        if (! m_HasRequest)
+            return;
+        
+        file = m_RequestedFile;
+        sampleRate = m_RequestedSampleRate;
+        m_HasRequest = false;
+    }
+    
+    if (std::unique_ptr<Engine> engine = createEngine (file, sampleRate))
+        publishEngine (engine.release());
+}
+
+/**
+    Reads an impulse response and builds an engine for it. The impulse response is truncated to
+    Variables::convolutionMaxLength, fading out over its last tail partition, resampled to the
+    sample rate, and scaled so a signal keeps about the same power through it.
+    Returns nullptr if the file can't be read or is silent.
+    @param file Audio file holding a mono or stereo impulse response.
+    @param sampleRate Sample rate the impulse response is resampled to.
+ */
+
+std::unique_ptr<ConvolutionReverb::Engine> ConvolutionReverb::createEngine (const juce::File& file, float sampleRate)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+    
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (file));
+    
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0 || reader->numChannels == 0)
+        return nullptr;
+    
+    double ratio = reader->sampleRate / sampleRate;
+    int maxLength = (int) (Variables::convolutionMaxLength * sampleRate);
+    int numSourceSamples = (int) juce::jmin (reader->lengthInSamples, (juce::int64) std::ceil (maxLength * ratio));
+    int numSamples = juce::jmin (maxLength, (int) std::ceil (numSourceSamples / ratio));
+    bool isTruncated = reader->lengthInSamples > numSourceSamples;
+    
+    juce::AudioBuffer<float> source ((int) juce::jmin (2, (int) reader->numChannels), numSourceSamples);
+    reader->read (&source, 0, numSourceSamples, 0, true, true);
+    
+    // Mono impulse responses are used for both channels.
+    juce::AudioBuffer<float> impulseResponse (2, numSamples);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        const float* input = source.getReadPointer (juce::jmin (channel, source.getNumChannels() - 1));
+        
+        if (ratio == 1.0)
+        {
+            impulseResponse.copyFrom (channel, 0, input, numSamples);
+            continue;
+        }
+        
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process (ratio, input, impulseResponse.getWritePointer (channel), numSamples, numSourceSamples, 0);
+    }
+    
+    if (isTruncated)
+        for (int channel = 0; channel < 2; ++channel)
+            impulseResponse.applyGainRamp (channel, juce::jmax (0, numSamples - tailSize), juce::jmin (numSamples, tailSize), 1.0f, 0.0f);
+    
+    double energy = 0.0;
+    
+    for (int channel = 0; channel < 2; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            energy += (double) impulseResponse.getSample (channel, i) * impulseResponse.getSample (channel, i);
+    
+    if (energy <= 0.0)
+        return nullptr;
+    
+    impulseResponse.applyGain ((float) (1.0 / std::sqrt (energy / 2.0)));
+    
+    return std::make_unique<Engine> (impulseResponse);
+}
+
+/**
+    Hands an engine to the audio thread, freeing the one already waiting if the audio thread
+    hasn't picked it up, since the audio thread never saw it.
+    @param engine Engine to hand over, owned by the reverb from now on.
+ */
+
+void ConvolutionReverb::publishEngine (Engine* engine)
+{
+    delete m_PendingEngine.exchange (engine, std::memory_order_acq_rel);
+}
+
+/**
+    Frees every engine. Must only be called while no other thread uses them.
+ */
+
+void ConvolutionReverb::clearEngines()
+{
+    delete m_ActiveEngine.exchange (nullptr);
+    delete m_PendingEngine.exchange (nullptr);
+    delete m_RetiredEngine.exchange (nullptr);
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Convolves the head block which was just filled, queues it for the tail, and mixes the head
+    and the tail into the next wet block. Called by the audio thread every headSize samples.
+    @param engine Active engine.
+ */
+
+void ConvolutionReverb::processHeadBlock (Engine& engine)
+{
+    const int spectrumSize = 2 * engine.numHeadBins;
+    const int ringSize = numRingBlocks * tailSize;
+    
+    juce::int64 inputStart = engine.numHeadBlocks * headSize;
+    int ringPosition = (int) (inputStart % ringSize);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        float* input = engine.headInput[channel];
+        float* frame = engine.headFrame;
+        float* sum = engine.headSum[channel];
+        
+        // The latest spectrum goes into the delay line slot of the oldest one.
+        std::copy (input, input + 2 * headSize, frame);
+        engine.headFFT.performRealOnlyForwardTransform (frame, true);
+        
+        float* slot = engine.headDelayLine[channel] + engine.headSlot * spectrumSize;
+        
+        for (int bin = 0; bin <= headSize; ++bin)
+        {
+            slot[bin] = frame[2 * bin];
+            slot[engine.numHeadBins + bin] = frame[2 * bin + 1];
+        }
+        
+        std::fill (sum, sum + spectrumSize, 0.0f);
+        
+        for (int partition = 0; partition < engine.numHeadPartitions; ++partition)
+        {
+            int delay = (engine.headSlot - partition + engine.numHeadPartitions) % engine.numHeadPartitions;
+            multiplyAccumulate (engine.headDelayLine[channel] + delay * spectrumSize, engine.headSpectra[channel] + partition * spectrumSize, sum, engine.numHeadBins);
+        }
+        
+        for (int bin = 0; bin <= headSize; ++bin)
+        {
+            frame[2 * bin] = sum[bin];
+            frame[2 * bin + 1] = sum[engine.numHeadBins + bin];
+        }
+        
+        // Overlap-save keeps the second half, the first one being wrapped around.
+        engine.headFFT.performRealOnlyInverseTransform (frame);
+        std::copy (frame + headSize, frame + 2 * headSize, engine.headOutput[channel]);
+        
+        std::copy (input + headSize, input + 2 * headSize, engine.inputRing[channel] + ringPosition);
+        std::copy (input + headSize, input + 2 * headSize, input);
+    }
+    
+    engine.headSlot = (engine.headSlot + 1) % engine.numHeadPartitions;
+    ++engine.numHeadBlocks;
+    
+    if (engine.numTailPartitions == 0)
+        return;
+    
+    if ((engine.numHeadBlocks * headSize) % tailSize == 0)
+    {
+        engine.numInputBlocks.store (engine.numHeadBlocks * headSize / tailSize, std::memory_order_release);
+        
+        if (m_IsNonRealtime.load (std::memory_order_relaxed))
+            processTailBlocks (engine);
+    }
+    
+    // The tail starts where the head ends, so its blocks are due headLength samples after their input.
+    if (inputStart < headLength)
+        return;
+    
+    juce::int64 tailBlock = (inputStart - headLength) / tailSize;
+    int offset = (int) ((inputStart - headLength) % tailSize);
+    int ringBlock = (int) (tailBlock % numRingBlocks);
+    
+    if (engine.outputBlocks[ringBlock].load (std::memory_order_acquire) != tailBlock)
+    {
+        if (offset == 0)
+            m_NumUnderruns.fetch_add (1, std::memory_order_relaxed);
+        
+        return;
+    }
+    
+    for (int channel = 0; channel < 2; ++channel)
+        juce::FloatVectorOperations::add (engine.headOutput[channel], engine.outputRing[channel] + ringBlock * tailSize + offset, headSize);
+}
+
+/**
+    Convolves every tail block whose input is complete. Blocks the tail thread fell too far behind
+    on are skipped rather than read while the audio thread overwrites them, and come out silent.
+    Returns straight away if another thread is already convolving the tail.
+    @param engine Active engine.
+ */
+
+void ConvolutionReverb::processTailBlocks (Engine& engine)
+{
+    if (engine.isConvolvingTail.exchange (true, std::memory_order_acquire))
+        return;
+    
+    const int spectrumSize = 2 * engine.numTailBins;
+    
+    while (engine.nextTailBlock < engine.numInputBlocks.load (std::memory_order_acquire))
+    {
+        juce::int64 numInputBlocks = engine.numInputBlocks.load (std::memory_order_acquire);
+        
+        if (numInputBlocks - engine.nextTailBlock > numRingBlocks - 2)
+            engine.nextTailBlock = numInputBlocks - 1;
+        
+        int ringBlock = (int) (engine.nextTailBlock % numRingBlocks);
+        engine.outputBlocks[ringBlock].store (-1, std::memory_order_release);
+        
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            const float* input = engine.inputRing[channel] + ringBlock * tailSize;
+            float* previous = engine.tailPrevious[channel];
+            float* frame = engine.tailFrame;
+            float* sum = engine.tailSum[channel];
+            
+            std::copy (previous, previous + tailSize, frame);
+            std::copy (input, input + tailSize, frame + tailSize);
+            std::copy (input, input + tailSize, previous);
+            engine.tailFFT.performRealOnlyForwardTransform (frame, true);
+            
+            float* slot = engine.tailDelayLine[channel] + engine.tailSlot * spectrumSize;
+            
+            for (int bin = 0; bin <= tailSize; ++bin)
+            {
+                slot[bin] = frame[2 * bin];
+                slot[engine.numTailBins + bin] = frame[2 * bin + 1];
+            }
+            
+            std::fill (sum, sum + spectrumSize, 0.0f);
+            
+            for (int partition = 0; partition < engine.numTailPartitions; ++partition)
+            {
+                int delay = (engine.tailSlot - partition + engine.numTailPartitions) % engine.numTailPartitions;
+                multiplyAccumulate (engine.tailDelayLine[channel] + delay * spectrumSize, engine.tailSpectra[channel] + partition * spectrumSize, sum, engine.numTailBins);
+            }
+            
+            for (int bin = 0; bin <= tailSize; ++bin)
+            {
+                frame[2 * bin] = sum[bin];
+                frame[2 * bin + 1] = sum[engine.numTailBins + bin];
+            }
+            
+            engine.tailFFT.performRealOnlyInverseTransform (frame);
+            std::copy (frame + tailSize, frame + 2 * tailSize, engine.outputRing[channel] + ringBlock * tailSize);
+        }
+        
+        engine.outputBlocks[ringBlock].store (engine.nextTailBlock, std::memory_order_release);
+        engine.tailSlot = (engine.tailSlot + 1) % engine.numTailPartitions;
+        ++engine.nextTailBlock;
+    }
+    
+    engine.isConvolvingTail.store (false, std::memory_order_release);
+}
+
+/**
+    Transforms consecutive partitions of an impulse response, each zero padded to twice its size
+    as overlap-save needs, and stores their spectra real parts first.
+    @param fft Transform of twice the partition size.
+    @param frame Scratch frame of four times the partition size.
+    @param impulseResponse First sample of the first partition.
+    @param numSamples Samples left in the impulse response from the first partition on.
+    @param partitionSize Samples per partition.
+    @param numPartitions Number of partitions to transform.
+    @param numBins Bins of each stored spectrum, at least partitionSize + 1.
+    @param spectra Array receiving the spectra, numPartitions * 2 * numBins values.
+ */
+
+void ConvolutionReverb::transformPartitions (juce::dsp::FFT& fft, float* frame, const float* impulseResponse, int numSamples,
+                                             int partitionSize, int numPartitions, int numBins, float* spectra)
+{
+    for (int partition = 0; partition < numPartitions; ++partition)
+    {
+        int start = partition * partitionSize;
+        int length = juce::jlimit (0, partitionSize, numSamples - start);
+        
+        std::fill (frame, frame + 4 * partitionSize, 0.0f);
+        std::copy (impulseResponse + start, impulseResponse + start + length, frame);
+        fft.performRealOnlyForwardTransform (frame, true);
+        
+        float* spectrum = spectra + partition * 2 * numBins;
+        
+        for (int bin = 0; bin <= partitionSize; ++bin)
+        {
+            spectrum[bin] = frame[2 * bin];
+            spectrum[numBins + bin] = frame[2 * bin + 1];
+        }
+    }
+}
+
+/**
+    Multiplies two spectra and adds the product to a sum. Spectra hold their real parts followed
+    by their imaginary parts, so whole registers of bins are multiplied at once.
+    @param spectrum Spectrum of an input block.
+    @param partition Spectrum of an impulse response partition.
+    @param sum Spectrum the product is added to.
+    @param numBins Bins of each spectrum, a multiple of the register size.
+ */
+
+void ConvolutionReverb::multiplyAccumulate (const float* spectrum, const float* partition, float* sum, int numBins)
+{
+    constexpr int numLanes = (int) Register::SIMDNumElements;
+    
+    const float* spectrumImaginary = spectrum + numBins;
+    const float* partitionImaginary = partition + numBins;
+    float* sumImaginary = sum + numBins;
+    
+    for (int bin = 0; bin < numBins; bin += numLanes)
+    {
+        Register real = Register::fromRawArray (spectrum + bin);
+        Register imaginary = Register::fromRawArray (spectrumImaginary + bin);
+        Register partitionReal = Register::fromRawArray (partition + bin);
+        Register partitionIm = Register::fromRawArray (partitionImaginary + bin);
+        
+        (Register::fromRawArray (sum + bin) + real * partitionReal - imaginary * partitionIm).copyToRawArray (sum + bin);
+        (Register::fromRawArray (sumImaginary + bin) + real * partitionIm + imaginary * partitionReal).copyToRawArray (sumImaginary + bin);
+    }
+}
+
+
+//================================================//
+// Engine.
+
+/**
+    Partitions an impulse response and allocates everything needed to convolve it.
+    @param impulseResponse Stereo impulse response at the sample rate it is used at.
+ */
+
+ConvolutionReverb::Engine::Engine (const juce::AudioBuffer<float>& impulseResponse)
+    :   headFFT (juce::roundToInt (std::log2 (2 * headSize))),
+        tailFFT (juce::roundToInt (std::log2 (2 * tailSize)))
+{
+    const int numLanes = (int) Register::SIMDNumElements;
+    const int numSamples = impulseResponse.getNumSamples();
+    
+    numHeadBins = (headSize + numLanes) / numLanes * numLanes;
+    numTailBins = (tailSize + numLanes) / numLanes * numLanes;
+    numHeadPartitions = juce::jmax (1, (juce::jmin (numSamples, headLength) + headSize - 1) / headSize);
+    numTailPartitions = juce::jmax (0, (numSamples - headLength + tailSize - 1) / tailSize);
+    
+    int headSpectraSize = numHeadPartitions * 2 * numHeadBins;
+    int tailSpectraSize = numTailPartitions * 2 * numTailBins;
+    int numPerChannel = 2 * headSpectraSize + 3 * headSize + 2 * numHeadBins
+                      + 2 * tailSpectraSize + tailSize + 2 * numTailBins + 2 * numRingBlocks * tailSize;
+    
+    storage.calloc ((size_t) (2 * numPerChannel + 4 * headSize + 4 * tailSize + numLanes));
+    
+    headFrame = allocate (4 * headSize);
+    tailFrame = allocate (4 * tailSize);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        headSpectra[channel] = allocate (headSpectraSize);
+        headDelayLine[channel] = allocate (headSpectraSize);
+        headInput[channel] = allocate (2 * headSize);
+        headOutput[channel] = allocate (headSize);
+        headSum[channel] = allocate (2 * numHeadBins);
+        
+        tailSpectra[channel] = allocate (tailSpectraSize);
+        tailDelayLine[channel] = allocate (tailSpectraSize);
+        tailPrevious[channel] = allocate (tailSize);
+        tailSum[channel] = allocate (2 * numTailBins);
+        
+        inputRing[channel] = allocate (numRingBlocks * tailSize);
+        outputRing[channel] = allocate (numRingBlocks * tailSize);
+        
+        const float* samples = impulseResponse.getReadPointer (channel);
+        
+        transformPartitions (headFFT, headFrame, samples, numSamples, headSize, numHeadPartitions, numHeadBins, headSpectra[channel]);
+        transformPartitions (tailFFT, tailFrame, samples + headLength, numSamples - headLength, tailSize, numTailPartitions, numTailBins, tailSpectra[channel]);
+    }
+    
+    for (auto& outputBlock : outputBlocks)
+        outputBlock.store (-1, std::memory_order_relaxed);
+}
+
+/**
+    Hands out the next values of the storage, aligned for SIMD loads.
+    @param numValues Number of values, a multiple of the register size.
+ */
+
+float* ConvolutionReverb::Engine::allocate (int numValues)
+{
+    float* values = Register::getNextSIMDAlignedPtr (storage.get()) + numAllocated;
+    numAllocated += numValues;
+    
+    return values;
+}
+
+
+//================================================//
+// Loader thread.
+
+ConvolutionReverb::Loader::Loader (ConvolutionReverb& reverb)
+    :   juce::Thread ("Convolution Loader"),
+        m_Reverb (reverb)
+{
+}
+
+/**
+    Inherited from juce::Thread class.
+    Sleeps until an impulse response is requested, then builds an engine for it.
+ */
+
+void ConvolutionReverb::Loader::run()
+{
+    while (! threadShouldExit())
+    {
+        m_Reverb.loadRequestedImpulseResponse();
+        wait (-1);
+    }
+}
+
+
+//================================================//
+// Tail thread.
+
+ConvolutionReverb::TailWorker::TailWorker (ConvolutionReverb& reverb)
+    :   juce::Thread ("Convolution Tail"),
+        m_Reverb (reverb)
+{
+}
+
+/**
+    Inherited from juce::Thread class.
+    Frees the engine the audio thread retired, then convolves the tail blocks of the active engine.
+    A tail block is due a tail partition after its input is complete, so polling every
+    millisecond leaves the thread nearly all of that time to convolve it.
+ */
+
+void ConvolutionReverb::TailWorker::run()
+{
+    while (! threadShouldExit())
+    {
+        delete m_Reverb.m_RetiredEngine.exchange (nullptr, std::memory_order_acq_rel);
+        
+        Engine* engine = m_Reverb.m_ActiveEngine.load (std::memory_order_acquire);
+        
+        if (engine != nullptr && engine->numTailPartitions > 0 && ! m_Reverb.m_IsNonRealtime.load (std::memory_order_relaxed))
+            processTailBlocks (*engine);
+        
+        sleep (1);
+    }
+}
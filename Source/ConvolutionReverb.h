@@ -0,0 +1,155 @@
+#pragma once
+
+
+//================================================//
+/// Stereo convolution reverb for long impulse responses, such as the ten seconds or more of a cathedral.
+/// The impulse response is split into two sizes of partitions, each convolved by overlap-save with a
+/// frequency domain delay line. The first partitions are small and convolved on the audio thread, one
+/// partition per Variables::convolutionHeadSize samples, which is all the delay the wet signal gets.
+/// The rest of the impulse response uses partitions of Variables::convolutionTailSize samples, convolved
+/// on a background thread, which has the time of a whole tail partition to deliver each block of it.
+/// Impulse responses are read, resampled and transformed on a loader thread, and handed to the audio
+/// thread without locking. Impulse responses longer than Variables::convolutionMaxLength are truncated,
+/// so memory stays bounded whatever file is loaded.
+
+class ConvolutionReverb
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    
+    static constexpr int headSize = Variables::convolutionHeadSize;         // Samples per head partition.
+    static constexpr int tailSize = Variables::convolutionTailSize;         // Samples per tail partition.
+    static constexpr int headLength = 2 * tailSize;                         // Samples of the impulse response covered by the head.
+    static constexpr int numRingBlocks = 4;                                 // Tail blocks buffered between the audio thread and the tail thread.
+    
+    static_assert (tailSize % headSize == 0, "Tail partitions must hold whole head partitions.");
+    
+    ConvolutionReverb();
+    ~ConvolutionReverb();
+    
+    // Init methods.
+    void prepareToPlay (float sampleRate);
+    void loadImpulseResponse (const juce::File& file);
+    
+    // Setter methods.
+    void setNonRealtime (bool isNonRealtime);
+    
+    // Getter methods.
+    bool isLoaded();
+    juce::File getImpulseResponseFile();
+    int getNumUnderruns();
+    
+    // DSP methods.
+    void processStereo (float* left, float* right, int numSamples);
+
+private:
+    //================================================//
+    /// Partitioned impulse response along with the state convolving it. Built by the loader thread,
+    /// then only used by the audio thread and the tail thread until it is retired.
+    
+    struct Engine
+    {
+        Engine (const juce::AudioBuffer<float>& impulseResponse);
+        
+        float* allocate (int numValues);
+        
+        juce::HeapBlock<float> storage;                                     // Storage for every array below, plus room for alignment.
+        int numAllocated = 0;                                               // Values of the storage handed out so far.
+        
+        // Head, used by the audio thread only.
+        juce::dsp::FFT headFFT;                                             // Transform of two head partitions.
+        int numHeadBins = 0;                                                // Bins of a head spectrum, rounded up to whole registers.
+        int numHeadPartitions = 0;                                          // Partitions of the impulse response in the head.
+        float* headSpectra[2] = {};                                         // Spectrum of every head partition, per channel.
+        float* headDelayLine[2] = {};                                       // Spectrum of the latest input blocks, one per head partition.
+        float* headInput[2] = {};                                           // Previous and current input blocks.
+        float* headOutput[2] = {};                                          // Wet block being played.
+        float* headFrame = nullptr;                                         // Scratch frame transformed in place.
+        float* headSum[2] = {};                                             // Spectrum summed over the head partitions, real then imaginary.
+        int headSlot = 0;                                                   // Delay line slot holding the latest input block.
+        int headPosition = 0;                                               // Sample of the current block played next.
+        juce::int64 numHeadBlocks = 0;                                      // Head blocks convolved so far.
+        
+        // Tail, used by the tail thread, or by the audio thread when rendering offline.
+        juce::dsp::FFT tailFFT;                                             // Transform of two tail partitions.
+        int numTailBins = 0;                                                // Bins of a tail spectrum, rounded up to whole registers.
+        int numTailPartitions = 0;                                          // Partitions of the impulse response in the tail.
+        float* tailSpectra[2] = {};                                         // Spectrum of every tail partition, per channel.
+        float* tailDelayLine[2] = {};                                       // Spectrum of the latest input blocks, one per tail partition.
+        float* tailPrevious[2] = {};                                        // Input block before the latest one.
+        float* tailFrame = nullptr;                                         // Scratch frame transformed in place.
+        float* tailSum[2] = {};                                             // Spectrum summed over the tail partitions, real then imaginary.
+        int tailSlot = 0;                                                   // Delay line slot holding the latest input block.
+        juce::int64 nextTailBlock = 0;                                      // Tail block convolved next.
+        std::atomic<bool> isConvolvingTail { false };                       // Whether a thread is convolving the tail right now.
+        
+        // Blocks passed between the audio thread and the tail thread.
+        float* inputRing[2] = {};                                           // Input blocks waiting to be convolved by the tail.
+        float* outputRing[2] = {};                                          // Convolved tail blocks waiting to be played.
+        std::atomic<juce::int64> numInputBlocks { 0 };                      // Input blocks written to the ring so far.
+        std::atomic<juce::int64> outputBlocks[numRingBlocks];               // Tail block held by each slot of the output ring.
+        
+        JUCE_DECLARE_NON_COPYABLE (Engine)
+    };
+    
+    //================================================//
+    /// Thread which reads, resamples and partitions requested impulse responses.
+    
+    class Loader : public juce::Thread
+    {
+    public:
+        Loader (ConvolutionReverb& reverb);
+        
+        // Thread class methods.
+        void run() override;
+    
+    private:
+        ConvolutionReverb& m_Reverb;                                        // Reverb the engines are built for.
+    };
+    
+    //================================================//
+    /// Thread which convolves the tail of the active engine, and frees retired engines.
+    
+    class TailWorker : public juce::Thread
+    {
+    public:
+        TailWorker (ConvolutionReverb& reverb);
+        
+        // Thread class methods.
+        void run() override;
+    
+    private:
+        ConvolutionReverb& m_Reverb;                                        // Reverb whose tail is convolved.
+    };
+    
+    // Loading methods.
+    void loadRequestedImpulseResponse();
+    std::unique_ptr<Engine> createEngine (const juce::File& file, float sampleRate);
+    void publishEngine (Engine* engine);
+    void clearEngines();
+    
+    // Helper methods.
+    void processHeadBlock (Engine& engine);
+    static void processTailBlocks (Engine& engine);
+    static void transformPartitions (juce::dsp::FFT& fft, float* frame, const float* impulseResponse, int numSamples,
+                                     int partitionSize, int numPartitions, int numBins, float* spectra);
+    static void multiplyAccumulate (const float* spectrum, const float* partition, float* sum, int numBins);
+    
+    std::atomic<Engine*> m_ActiveEngine { nullptr };                        // Engine convolving the audio, only swapped by the audio thread.
+    std::atomic<Engine*> m_PendingEngine { nullptr };                       // Engine built by the loader, waiting for the audio thread.
+    std::atomic<Engine*> m_RetiredEngine { nullptr };                       // Engine replaced by the audio thread, waiting for the tail thread to free it.
+    
+    juce::CriticalSection m_RequestLock;                                    // Protects the request, never taken by the audio thread.
+    juce::File m_RequestedFile;                                             // Impulse response the loader should load.
+    float m_RequestedSampleRate = 0.0f;                                     // Sample rate the loader should resample to.
+    bool m_HasRequest = false;                                              // Whether the loader has a request to handle.
+    
+    std::atomic<bool> m_IsNonRealtime { false };                            // Whether the audio thread convolves the tail itself.
+    std::atomic<int> m_NumUnderruns { 0 };                                  // Tail blocks which were not ready in time.
+    float m_SampleRate = 0.0f;                                              // Sample rate.
+    
+    Loader m_Loader;                                                        // Thread loading impulse responses.
+    TailWorker m_TailWorker;                                                // Thread convolving the tail.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ConvolutionReverb)
+};
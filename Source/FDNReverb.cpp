@@ -0,0 +1,309 @@
+#include "Headers.h"
+
+
+//================================================//
+// Feedback delay network reverb with modulated delay lines.
+
+FDNReverb::FDNReverb() {}
+
+FDNReverb::~FDNReverb() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Allocates the delay lines for the largest room size, and sets up the lines for the current
+    room size and decay time without gliding towards them.
+    @param sampleRate Sample rate to use.
+ */
+
+void FDNReverb::prepareToPlay (float sampleRate)
+{
+    const int numLanes = (int) Register::SIMDNumElements;
+    
+    m_SampleRate = sampleRate;
+    m_SmoothingCoefficient = 1.0f - std::exp (-1.0f / (Variables::reverbSmoothingTime * sampleRate));
+    m_DampingCoefficient = 1.0f - std::exp (-2.0f * juce::MathConstants<float>::pi * Variables::reverbDampingFrequency / sampleRate);
+    m_ModulationDepth = Variables::reverbModulationDepth * sampleRate;
+    
+    // Lines are long enough for the largest room plus the modulation, rounded up so positions wrap with a mask.
+    float maxDelay = maxRoomSize * Variables::reverbMaxDelay * sampleRate + m_ModulationDepth + 2.0f;
+    m_LineLength = juce::nextPowerOfTwo ((int) std::ceil (maxDelay));
+    
+    m_LineStorage.calloc ((size_t) (m_LineLength * numLines + numLanes));
+    m_Lines = Register::getNextSIMDAlignedPtr (m_LineStorage.get());
+    
+    m_Storage.calloc ((size_t) (numFields * numLines + numLanes));
+    m_Fields = Register::getNextSIMDAlignedPtr (m_Storage.get());
+    
+    // Each input feeds half the lines and each output taps every line with a different sign pattern,
+    // so the two channels stay decorrelated and the network neither gains nor loses energy on the way in.
+    float inputGain = 1.0f / std::sqrt (numLines / 2.0f);
+    float outputGain = 1.0f / std::sqrt ((float) numLines);
+    
+    for (int line = 0; line < numLines; ++line)
+    {
+        float inputSign = (line / 2) % 2 == 0 ? 1.0f : -1.0f;
+        
+        getField (leftInputs)[line] = line % 2 == 0 ? inputSign * inputGain : 0.0f;
+        getField (rightInputs)[line] = line % 2 == 1 ? inputSign * inputGain : 0.0f;
+        getField (leftOutputs)[line] = (line % 2 == 0 ? 1.0f : -1.0f) * outputGain;
+        getField (rightOutputs)[line] = ((line / 2) % 2 == 0 ? 1.0f : -1.0f) * outputGain;
+        
+        // Lines start their modulation spread around the circle, each at its own rate.
+        float phase = 2.0f * juce::MathConstants<float>::pi * line / numLines;
+        float rate = Variables::reverbModulationRate * (0.5f + (float) line / numLines);
+        float increment = 2.0f * juce::MathConstants<float>::pi * rate / sampleRate;
+        
+        getField (modulationReal)[line] = std::cos (phase);
+        getField (modulationImaginary)[line] = std::sin (phase);
+        getField (rotationReal)[line] = std::cos (increment);
+        getField (rotationImaginary)[line] = std::sin (increment);
+    }
+    
+    updateTargets (getRoomSize(), getDecayTime());
+    
+    for (int line = 0; line < numLines; ++line)
+    {
+        getField (delays)[line] = getField (delayTargets)[line];
+        getField (gains)[line] = getField (gainTargets)[line];
+    }
+    
+    m_WetGain = m_WetGainTarget;
+    
+    reset();
+}
+
+/**
+    Clears the delay lines and the damping filters, silencing the tail.
+ */
+
+void FDNReverb::reset()
+{
+    if (m_Lines != nullptr)
+        std::fill (m_Lines, m_Lines + m_LineLength * numLines, 0.0f);
+    
+    if (m_Fields != nullptr)
+        std::fill (getField (dampingStates), getField (dampingStates) + numLines, 0.0f);
+    
+    m_WritePosition = 0;
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the room size, which scales the length of every delay line. Can be called from any thread.
+    Changes glide in over Variables::reverbSmoothingTime, which bends the pitch of the tail while it glides.
+    @param roomSize Room size in range [minRoomSize, maxRoomSize], 1 uses the delays in Variables.
+ */
+
+void FDNReverb::setRoomSize (float roomSize)
+{
+    m_RoomSize.store (juce::jlimit (minRoomSize, maxRoomSize, roomSize), std::memory_order_relaxed);
+}
+
+/**
+    Sets the time the tail takes to decay by 60 dB at low frequencies. Can be called from any thread.
+    @param decayTime Decay time in seconds, in range [minDecayTime, maxDecayTime].
+ */
+
+void FDNReverb::setDecayTime (float decayTime)
+{
+    m_DecayTime.store (juce::jlimit (minDecayTime, maxDecayTime, decayTime), std::memory_order_relaxed);
+}
+
+
+//================================================//
+// Getter methods.
+
+float FDNReverb::getRoomSize()                                      { return m_RoomSize.load (std::memory_order_relaxed); }
+float FDNReverb::getDecayTime()                                     { return m_DecayTime.load (std::memory_order_relaxed); }
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Adds reverb to a stereo pair of buffers in place. The tail carries on from the previous call.
+    @param left Left channel.
+    @param right Right channel.
+    @param numSamples Number of samples.
+ */
+
+void FDNReverb::processStereo (float* left, float* right, int numSamples)
+{
+    constexpr int numLanes = (int) Register::SIMDNumElements;
+    constexpr int numRegisters = numLines / numLanes;
+    
+    float roomSize = getRoomSize();
+    float decayTime = getDecayTime();
+    
+    if (roomSize != m_AppliedRoomSize || decayTime != m_AppliedDecayTime)
+        updateTargets (roomSize, decayTime);
+    
+    float* delayField = getField (delays);
+    float* delayTargetField = getField (delayTargets);
+    float* gainField = getField (gains);
+    float* gainTargetField = getField (gainTargets);
+    float* dampingField = getField (dampingStates);
+    float* realField = getField (modulationReal);
+    float* imaginaryField = getField (modulationImaginary);
+    float* rotationRealField = getField (rotationReal);
+    float* rotationImaginaryField = getField (rotationImaginary);
+    float* leftInputField = getField (leftInputs);
+    float* rightInputField = getField (rightInputs);
+    float* leftOutputField = getField (leftOutputs);
+    float* rightOutputField = getField (rightOutputs);
+    float* readField = getField (reads);
+    
+    const int mask = m_LineLength - 1;
+    const float mixGain = -2.0f / numLines;
+    const Register smoothing = Register::expand (m_SmoothingCoefficient);
+    const Register damping = Register::expand (m_DampingCoefficient);
+    const Register depth = Register::expand (m_ModulationDepth);
+    
+    Register currentGains[numRegisters];
+    Register feedback[numRegisters];
+    
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        // Delays and gains glide towards their targets, and the modulation phasors rotate.
+        for (int r = 0; r < numRegisters; ++r)
+        {
+            const int offset = r * numLanes;
+            
+            Register delay = Register::fromRawArray (delayField + offset);
+            delay += (Register::fromRawArray (delayTargetField + offset) - delay) * smoothing;
+            delay.copyToRawArray (delayField + offset);
+            
+            Register gain = Register::fromRawArray (gainField + offset);
+            gain += (Register::fromRawArray (gainTargetField + offset) - gain) * smoothing;
+            gain.copyToRawArray (gainField + offset);
+            currentGains[r] = gain;
+            
+            Register real = Register::fromRawArray (realField + offset);
+            Register imaginary = Register::fromRawArray (imaginaryField + offset);
+            Register rotationRe = Register::fromRawArray (rotationRealField + offset);
+            Register rotationIm = Register::fromRawArray (rotationImaginaryField + offset);
+            
+            Register nextReal = real * rotationRe - imaginary * rotationIm;
+            Register nextImaginary = real * rotationIm + imaginary * rotationRe;
+            nextReal.copyToRawArray (realField + offset);
+            nextImaginary.copyToRawArray (imaginaryField + offset);
+            
+            (delay + nextImaginary * depth).copyToRawArray (readField + offset);
+        }
+        
+        // Each line is read at its own fractional delay, interpolated linearly. Delays are split
+        // before they are subtracted from the write position, which keeps their fraction precise.
+        for (int line = 0; line < numLines; ++line)
+        {
+            float delay = readField[line];
+            int wholeDelay = (int) delay;
+            float fraction = delay - (float) wholeDelay;
+            
+            float a = m_Lines[((m_WritePosition - wholeDelay) & mask) * numLines + line];
+            float b = m_Lines[((m_WritePosition - wholeDelay - 1) & mask) * numLines + line];
+            readField[line] = a + fraction * (b - a);
+        }
+        
+        // Damped, decayed lines are mixed by the Householder matrix I - 2/N, which only needs their sum.
+        Register sum = Register::expand (0.0f);
+        Register wetLeft = Register::expand (0.0f);
+        Register wetRight = Register::expand (0.0f);
+        
+        for (int r = 0; r < numRegisters; ++r)
+        {
+            const int offset = r * numLanes;
+            Register read = Register::fromRawArray (readField + offset);
+            
+            wetLeft += read * Register::fromRawArray (leftOutputField + offset);
+            wetRight += read * Register::fromRawArray (rightOutputField + offset);
+            
+            Register state = Register::fromRawArray (dampingField + offset);
+            state += (read - state) * damping;
+            state.copyToRawArray (dampingField + offset);
+            
+            feedback[r] = state * currentGains[r];
+            sum += feedback[r];
+        }
+        
+        const Register mix = Register::expand (sum.sum() * mixGain);
+        const Register inputLeft = Register::expand (left[sample]);
+        const Register inputRight = Register::expand (right[sample]);
+        float* row = m_Lines + m_WritePosition * numLines;
+        
+        for (int r = 0; r < numRegisters; ++r)
+        {
+            const int offset = r * numLanes;
+            
+            Register input = inputLeft * Register::fromRawArray (leftInputField + offset)
+                           + inputRight * Register::fromRawArray (rightInputField + offset);
+            
+            (feedback[r] + mix + input).copyToRawArray (row + offset);
+        }
+        
+        m_WetGain += (m_WetGainTarget - m_WetGain) * m_SmoothingCoefficient;
+        
+        left[sample] = Variables::reverbDryLevel * left[sample] + m_WetGain * wetLeft.sum();
+        right[sample] = Variables::reverbDryLevel * right[sample] + m_WetGain * wetRight.sum();
+        
+        m_WritePosition = (m_WritePosition + 1) & mask;
+    }
+    
+    // Rotating the phasors slowly changes their length, so they are put back on the unit circle.
+    for (int line = 0; line < numLines; ++line)
+    {
+        float length = std::sqrt (realField[line] * realField[line] + imaginaryField[line] * imaginaryField[line]);
+        realField[line] /= length;
+        imaginaryField[line] /= length;
+    }
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Computes the delays and gains the lines glide towards. Delays are spaced geometrically between
+    Variables::reverbMinDelay and Variables::reverbMaxDelay, so no two lines share a common period,
+    and each gain takes its line down by 60 dB over the decay time, so every line decays alike.
+    The wet gain makes up for the energy the tail builds up, so the level barely moves with the decay time.
+    @param roomSize Room size.
+    @param decayTime Decay time in seconds.
+ */
+
+void FDNReverb::updateTargets (float roomSize, float decayTime)
+{
+    m_AppliedRoomSize = roomSize;
+    m_AppliedDecayTime = decayTime;
+    
+    float ratio = Variables::reverbMaxDelay / Variables::reverbMinDelay;
+    float loss = 0.0f;
+    
+    for (int line = 0; line < numLines; ++line)
+    {
+        float delay = roomSize * Variables::reverbMinDelay * std::pow (ratio, (float) line / (numLines - 1)) * m_SampleRate;
+        float gain = std::pow (10.0f, -3.0f * delay / (decayTime * m_SampleRate));
+        
+        getField (delayTargets)[line] = delay;
+        getField (gainTargets)[line] = gain;
+        
+        loss += 1.0f - gain * gain;
+    }
+    
+    m_WetGainTarget = Variables::reverbWetLevel * std::sqrt (loss / numLines);
+}
+
+/**
+    Returns the start of a per-line field.
+    @param fieldIndex Index of the field.
+ */
+
+float* FDNReverb::getField (int fieldIndex)
+{
+    return m_Fields + fieldIndex * numLines;
+}
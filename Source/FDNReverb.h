@@ -0,0 +1,89 @@
+#pragma once
+
+
+//================================================//
+/// Stereo feedback delay network reverb, built for tails far longer than juce::Reverb can hold.
+/// Every sample, each delay line is read at a slowly modulated position, damped by a one-pole low pass
+/// and scaled so the tail falls by 60 dB over the decay time, and the lines are mixed by a Householder
+/// matrix before being written back. The lines are stored interleaved, so all the per-line maths and the
+/// writes run a SIMD register of lines at a time, and only the modulated reads are done line by line.
+/// Room size and decay time can be set from any thread, and take effect smoothly from the next block.
+
+class FDNReverb
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    
+    static constexpr int numLines = Variables::reverbNumLines;              // Number of delay lines.
+    static constexpr float minRoomSize = 0.25f;                             // Smallest room size.
+    static constexpr float maxRoomSize = 2.0f;                              // Largest room size, which sets the memory used.
+    static constexpr float minDecayTime = 0.1f;                             // Shortest decay time in seconds.
+    static constexpr float maxDecayTime = 120.0f;                           // Longest decay time in seconds.
+    
+    FDNReverb();
+    ~FDNReverb();
+    
+    // Init methods.
+    void prepareToPlay (float sampleRate);
+    void reset();
+    
+    // Setter methods.
+    void setRoomSize (float roomSize);
+    void setDecayTime (float decayTime);
+    
+    // Getter methods.
+    float getRoomSize();
+    float getDecayTime();
+    
+    // DSP methods.
+    void processStereo (float* left, float* right, int numSamples);
+
+private:
+    // Helper methods.
+    void updateTargets (float roomSize, float decayTime);
+    float* getField (int fieldIndex);
+    
+    /// Per-line values, each stored as one aligned array of numLines values.
+    enum Field
+    {
+        delays,                                                             // Current delay in samples.
+        delayTargets,                                                       // Delay the current delay moves towards.
+        gains,                                                              // Current feedback gain.
+        gainTargets,                                                        // Feedback gain the current gain moves towards.
+        dampingStates,                                                      // State of the damping low pass.
+        modulationReal,                                                     // Cosine of the phase of the delay modulation.
+        modulationImaginary,                                                // Sine of the phase of the delay modulation.
+        rotationReal,                                                       // Cosine of the phase the modulation moves by each sample.
+        rotationImaginary,                                                  // Sine of the phase the modulation moves by each sample.
+        leftInputs,                                                         // Gain of the left input into each line.
+        rightInputs,                                                        // Gain of the right input into each line.
+        leftOutputs,                                                        // Gain of each line in the left output.
+        rightOutputs,                                                       // Gain of each line in the right output.
+        reads,                                                              // Modulated delay of each line, then the sample read from it.
+        numFields
+    };
+    
+    static_assert (numLines % (int) Register::SIMDNumElements == 0, "Delay lines must fill whole SIMD registers.");
+    
+    juce::HeapBlock<float> m_Storage;                                       // Storage for every field, plus room for alignment.
+    float* m_Fields = nullptr;                                              // First field, aligned for SIMD loads.
+    
+    juce::HeapBlock<float> m_LineStorage;                                   // Storage for the delay lines, plus room for alignment.
+    float* m_Lines = nullptr;                                               // Delay lines interleaved, numLines values per sample.
+    int m_LineLength = 0;                                                   // Samples held by each delay line, a power of two.
+    int m_WritePosition = 0;                                                // Sample of the delay lines written next.
+    
+    std::atomic<float> m_RoomSize { Variables::reverbRoomSize };            // Room size set by the caller.
+    std::atomic<float> m_DecayTime { Variables::reverbDecayTime };          // Decay time set by the caller.
+    float m_AppliedRoomSize = 0.0f;                                         // Room size the targets were computed for.
+    float m_AppliedDecayTime = 0.0f;                                        // Decay time the targets were computed for.
+    
+    float m_WetGain = 0.0f;                                                 // Current gain of the wet signal.
+    float m_WetGainTarget = 0.0f;                                           // Gain of the wet signal the current gain moves towards.
+    float m_SmoothingCoefficient = 1.0f;                                    // Fraction of the distance to the targets covered each sample.
+    float m_DampingCoefficient = 1.0f;                                      // Coefficient of the damping low pass.
+    float m_ModulationDepth = 0.0f;                                         // Depth of the delay modulation in samples.
+    float m_SampleRate = 44100.0f;                                          // Sample rate.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FDNReverb)
+};
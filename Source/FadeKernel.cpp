@@ -0,0 +1,116 @@
+#include "Headers.h"
+
+#if defined (__AVX2__) || defined (__SSE2__) || defined (_M_X64)
+ #include <immintrin.h>
+#endif
+
+
+//================================================//
+// Branch-free fade update kernels.
+
+/**
+    Updates the fades of a range of columns using the widest vector unit available.
+    The range is split into a scalar head up to a multiple of the vector width, a vector
+    body, and a scalar tail, so liveness bits can be read a whole lane group at a time.
+    @param fades Fade values of the row.
+    @param words Liveness bits of the row, one bit per column.
+    @param startColumn First column to update.
+    @param endColumn Column after the last one to update.
+    @param fadeAmount Amount each fade moves by.
+    @return Sum of the changes of the fades.
+ */
+
+float FadeKernel::updateFades (float* fades, const juce::uint64* words, int startColumn, int endColumn, float fadeAmount)
+{
+   #if defined (__AVX2__)
+    const int numLanes = 8;
+   #elif defined (__SSE2__) || defined (_M_X64)
+    const int numLanes = 4;
+   #else
+    const int numLanes = 1;
+   #endif
+    
+    int vectorStart = juce::jmin (endColumn, (startColumn + numLanes - 1) / numLanes * numLanes);
+    int vectorEnd = juce::jmax (vectorStart, endColumn / numLanes * numLanes);
+    
+    float change = updateFadesScalar (fades, words, startColumn, vectorStart, fadeAmount);
+   
+   #if defined (__AVX2__)
+    const __m256i laneBits = _mm256_setr_epi32 (1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256 up = _mm256_set1_ps (fadeAmount);
+    const __m256 down = _mm256_set1_ps (-fadeAmount);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps (1.0f);
+    __m256 changes = zero;
+    
+    for (int column = vectorStart; column < vectorEnd; column += 8)
+    {
+        // Spreads 8 liveness bits over 8 lanes, giving an all ones lane for every live cell.
+        int bits = (int) ((words[column >> 6] >> (column & 63)) & 0xff);
+        __m256i isAlive = _mm256_cmpeq_epi32 (_mm256_and_si256 (_mm256_set1_epi32 (bits), laneBits), laneBits);
+        
+        __m256 step = _mm256_blendv_ps (down, up, _mm256_castsi256_ps (isAlive));
+        __m256 oldFade = _mm256_loadu_ps (fades + column);
+        __m256 fade = _mm256_min_ps (_mm256_max_ps (_mm256_add_ps (oldFade, step), zero), one);
+        _mm256_storeu_ps (fades + column, fade);
+        changes = _mm256_add_ps (changes, _mm256_sub_ps (fade, oldFade));
+    }
+    
+    // Lanes are added up once per range rather than once per group.
+    __m128 halves = _mm_add_ps (_mm256_castps256_ps128 (changes), _mm256_extractf128_ps (changes, 1));
+    halves = _mm_add_ps (halves, _mm_movehl_ps (halves, halves));
+    change += _mm_cvtss_f32 (_mm_add_ss (halves, _mm_shuffle_ps (halves, halves, 1)));
+   #elif defined (__SSE2__) || defined (_M_X64)
+    const __m128i laneBits = _mm_setr_epi32 (1, 2, 4, 8);
+    const __m128 up = _mm_set1_ps (fadeAmount);
+    const __m128 down = _mm_set1_ps (-fadeAmount);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps (1.0f);
+    __m128 changes = zero;
+    
+    for (int column = vectorStart; column < vectorEnd; column += 4)
+    {
+        int bits = (int) ((words[column >> 6] >> (column & 63)) & 0xf);
+        __m128 isAlive = _mm_castsi128_ps (_mm_cmpeq_epi32 (_mm_and_si128 (_mm_set1_epi32 (bits), laneBits), laneBits));
+        
+        // SSE2 has no blend, so the step is selected with and/andnot.
+        __m128 step = _mm_or_ps (_mm_and_ps (isAlive, up), _mm_andnot_ps (isAlive, down));
+        __m128 oldFade = _mm_loadu_ps (fades + column);
+        __m128 fade = _mm_min_ps (_mm_max_ps (_mm_add_ps (oldFade, step), zero), one);
+        _mm_storeu_ps (fades + column, fade);
+        changes = _mm_add_ps (changes, _mm_sub_ps (fade, oldFade));
+    }
+    
+    changes = _mm_add_ps (changes, _mm_movehl_ps (changes, changes));
+    change += _mm_cvtss_f32 (_mm_add_ss (changes, _mm_shuffle_ps (changes, changes, 1)));
+   #endif
+    
+    return change + updateFadesScalar (fades, words, vectorEnd, endColumn, fadeAmount);
+}
+
+/**
+    Updates the fades of a range of columns one at a time. Used for the ends of each range
+    and on targets without vector units, and gives the same results as the vector loops.
+    @param fades Fade values of the row.
+    @param words Liveness bits of the row, one bit per column.
+    @param startColumn First column to update.
+    @param endColumn Column after the last one to update.
+    @param fadeAmount Amount each fade moves by.
+    @return Sum of the changes of the fades.
+ */
+
+float FadeKernel::updateFadesScalar (float* fades, const juce::uint64* words, int startColumn, int endColumn, float fadeAmount)
+{
+    float change = 0.0f;
+    
+    for (int column = startColumn; column < endColumn; ++column)
+    {
+        bool isAlive = (words[column >> 6] >> (column & 63)) & 1;
+        float fade = juce::jlimit (0.0f, 1.0f, fades[column] + (isAlive ? fadeAmount : -fadeAmount));
+        
+        change += fade - fades[column];
+        fades[column] = fade;
+    }
+    
+    return change;
+}
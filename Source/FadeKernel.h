@@ -0,0 +1,16 @@
+#pragma once
+
+
+//================================================//
+/// Moves a row of fade values towards the liveness bits of the same row, without branches.
+/// Live cells fade in and dead cells fade out by a fixed amount, clamped to [0,1].
+/// Returns how much the fades of the range add up to more than before, so sums of fades can be kept up to date.
+/// Uses AVX2 or SSE2 when the compiler targets them, otherwise a scalar loop.
+
+class FadeKernel
+{
+public:
+    // State methods.
+    static float updateFades (float* fades, const juce::uint64* words, int startColumn, int endColumn, float fadeAmount);
+    static float updateFadesScalar (float* fades, const juce::uint64* words, int startColumn, int endColumn, float fadeAmount);
+};
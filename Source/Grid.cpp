@@ -6,38 +6,55 @@
 
 Grid::Grid()
 {
-    // Starts the timer used to refresh update grid state.
-    startTimer (Variables::gridRefreshRate);
+    // Sets up the threads used to update large grids, started the first time the bitwise engine needs them.
+    setNumWorkers (Variables::numGridWorkers, Variables::useGridWorkerAffinity);
     
-    // Init cells.
-    m_Cells.ensureStorageAllocated(Variables::numRows * Variables::numColumns);
+    m_Profiler.setDeadline (Variables::gridRefreshRate / 1000.0);
     
-    for (int i = 0; i < Variables::numRows * Variables::numColumns; ++i)
-        m_Cells.add(new Cell());
+    // Init cells.
+    setSize (Variables::numRows, Variables::numColumns);
     
-    for (int row = 0; row < Variables::numRows; ++row)
-    {
-        for (int column = 0; column < Variables::numColumns; ++column)
-        {
-            // Generates a random number between [n,1].
-            int random = m_Random.nextInt (juce::Range<int> (Variables::lowRandomRange, 2));
-            
-            // This constrains the random number to [0,1].
-            // It is used to increase the chances random is 0.
-            if (random < 0)
-                random = 0;
-        
-            setCellIsAlive (row, column, random);
-        }
-    }
+    // Starts stepping the grid once it has cells.
+    startStepping();
 }
 
-Grid::~Grid() {}
+Grid::~Grid()
+{
+    stopStepping();
+}
 
 
 //================================================//
 // Setter methods.
 
+/**
+    Resizes the grid, allocating all cells up front, and initialises it to a random state.
+    @param numRows Number of rows.
+    @param numColumns Number of columns.
+ */
+
+void Grid::setSize (int numRows, int numColumns)
+{
+    const juce::ScopedLock lock (m_Lock);
+    
+    jassert (numRows > 0 && numRows <= Variables::maxNumRows);
+    jassert (numColumns > 0 && numColumns <= Variables::maxNumColumns);
+    
+    m_NumRows = numRows;
+    m_NumColumns = numColumns;
+    
+    m_Cells.setSize (numRows, numColumns);
+    m_NextCells.setSize (numRows, numColumns);
+    m_BitGrid.setSize (numRows, numColumns);
+    
+    for (int i = 0; i < 3; ++i)
+        m_Snapshots.getBuffer (i).setSize (numRows, numColumns, false);
+    
+    m_Generation = 0;
+    randomise();
+    publishSnapshot();
+}
+
 /**
     Sets the state of a cell to alive or dead.
     @param row Row index of the cell.
@@ -47,22 +64,92 @@ Grid::~Grid() {}
 
 void Grid::setCellIsAlive (int row, int column, bool isAlive)
 {
-    getCell (row, column)->setIsAlive(isAlive);
+    m_Cells.getRow (row)[column] = isAlive;
+    m_BitGrid.setCellIsAlive (row, column, isAlive);
+    m_HashLifeIsStale = true;
+}
+
+/**
+    Sets the engine used to update the grid.
+    @param engine Engine to use.
+ */
+
+void Grid::setEngine (Engine engine)
+{
+    const juce::ScopedLock lock (m_Lock);
+    
+    // Each engine only keeps its own storage up to date, so the other one is refreshed on switching.
+    if (engine != Engine::Cells && m_Engine == Engine::Cells)
+        for (int row = 0; row < m_NumRows; ++row)
+            for (int column = 0; column < m_NumColumns; ++column)
+                m_BitGrid.setCellIsAlive (row, column, m_Cells.getRow (row)[column] != 0);
+    
+    else if (engine == Engine::Cells && m_Engine != Engine::Cells)
+        for (int row = 0; row < m_NumRows; ++row)
+            for (int column = 0; column < m_NumColumns; ++column)
+                m_Cells.getRow (row)[column] = m_BitGrid.getCellIsAlive (row, column);
+    
+    // The quadtree is rebuilt from the board the next time it is used.
+    if (engine != m_Engine)
+        m_HashLifeIsStale = true;
+    
+    m_Engine = engine;
+}
+
+/**
+    Sets the number of threads helping to update the grid.
+    @param numWorkers Number of worker threads, or -1 to use one per spare core.
+    @param useAffinity If true each worker is pinned to its own core.
+ */
+
+void Grid::setNumWorkers (int numWorkers, bool useAffinity)
+{
+    const juce::ScopedLock lock (m_Lock);
+    
+    if (numWorkers < 0)
+        numWorkers = juce::jmax (0, juce::SystemStats::getNumCpus() - 1);
+    
+    m_WorkerPool.setNumWorkers (numWorkers, useAffinity);
+}
+
+/**
+    Seeds the random numbers used by randomise, so that the same seed gives the same cells.
+    @param seed Seed to use.
+ */
+
+void Grid::setRandomSeed (juce::int64 seed)
+{
+    m_Random.setSeed (seed);
+}
+
+/**
+    Sets how many generations per second the simulation thread computes. Can be called from any thread,
+    and takes effect from the next generation. Has no effect on the legacy timer.
+    @param stepRate Generations per second, above 0.
+ */
+
+void Grid::setStepRate (double stepRate)
+{
+    m_StepRate.store (juce::jmax (1.0e-3, stepRate), std::memory_order_relaxed);
+    m_SimulationThread.notify();
 }
 
 
 //================================================//
 // Getter methods.
 
+int Grid::getNumRows()                                              { return m_NumRows; }
+int Grid::getNumColumns()                                           { return m_NumColumns; }
+
 /**
-    Returns pointer to a cell object.
-    @param row Row index of the cell.
-    @param column Column index of the cell.
+    Returns a view of the cell states of a row, one byte per cell.
+    Only up to date while the cell engine is used.
+    @param row Row index.
  */
 
-Cell* Grid::getCell (int row, int column)
+CellSpan<const juce::uint8> Grid::getCellRow (int row)
 {
-    return m_Cells[row * Variables::numColumns + column];
+    return static_cast<const CellPlane<juce::uint8>&> (m_Cells).getRow (row);
 }
 
 /**
@@ -74,13 +161,41 @@ Cell* Grid::getCell (int row, int column)
 bool Grid::getCellIsAlive (int row, int column)
 {
     // Used to make sure row and column values actually point to existing cell.
-    if (row < 0 || column < 0 || row == Variables::numRows || column == Variables::numColumns)
+    if (row < 0 || column < 0 || row >= m_NumRows || column >= m_NumColumns)
         return 0;
     
+    else if (m_Engine != Engine::Cells)
+        return m_BitGrid.getCellIsAlive (row, column);
+    
     else
-        return getCell (row, column)->getIsAlive();
+        return m_Cells.getRow (row)[column] != 0;
+}
+
+Grid::Engine Grid::getEngine()                                      { return m_Engine; }
+juce::int64 Grid::getGeneration()                                   { return m_Generation; }
+
+/**
+    Returns the most recently published snapshot of the grid.
+    Never blocks, but must only be called from a single reader thread (the audio thread).
+ */
+
+GridSnapshot& Grid::getSnapshot()
+{
+    return m_Snapshots.getReadBuffer();
 }
 
+/**
+    Returns the profiler timing each generation computed by the timer.
+    Its statistics must only be read from a single reader thread (the message thread).
+ */
+
+Profiler& Grid::getProfiler()
+{
+    return m_Profiler;
+}
+
+double Grid::getStepRate()                                          { return m_StepRate.load (std::memory_order_relaxed); }
+
 
 //================================================//
 // Grid logic methods.
@@ -114,6 +229,7 @@ int Grid::getNumAlive(int row, int column)
     @param row Row index of the cell.
     @param column Column index of the cell.
     @param numAlive Number of live cells.
+    The result is written to the next generation, which becomes current once the whole grid is updated.
  */
 
 void Grid::updateCellState(int row, int column, int numAlive)
@@ -123,22 +239,48 @@ void Grid::updateCellState(int row, int column, int numAlive)
     // 3) Any live cell with more than three live neighbours dies, as if by overpopulation.
     // 4) Any dead cell with exactly three live neighbours becomes a live cell, as if by reproduction.
     
-    if (getCellIsAlive (row, column))
+    bool isAlive = getCellIsAlive (row, column);
+    
+    if (isAlive)
     {
         // Rule 1
         if (numAlive < 2)
-            setCellIsAlive (row, column, false);
+            isAlive = false;
         
         // Rule 3
         else if (numAlive > 3)
-            setCellIsAlive (row, column, false);
+            isAlive = false;
     }
     
     // Rule 4
     else if (numAlive == 3)
-        setCellIsAlive (row, column, true);
+        isAlive = true;
     
-    getCell (row, column)->updateFade();
+    // The new state is written to the next generation so neighbours still read the current one.
+    m_NextCells.getRow (row)[column] = isAlive;
+}
+
+/**
+    Sets every cell to a random state.
+ */
+
+void Grid::randomise()
+{
+    for (int row = 0; row < m_NumRows; ++row)
+    {
+        for (int column = 0; column < m_NumColumns; ++column)
+        {
+            // Generates a random number between [n,1].
+            int random = m_Random.nextInt (juce::Range<int> (Variables::lowRandomRange, 2));
+            
+            // This constrains the random number to [0,1].
+            // It is used to increase the chances random is 0.
+            if (random < 0)
+                random = 0;
+            
+            setCellIsAlive (row, column, random);
+        }
+    }
 }
 
 /**
@@ -147,9 +289,177 @@ void Grid::updateCellState(int row, int column, int numAlive)
 
 void Grid::updateGridState()
 {
-    for (int row = 0; row < Variables::numRows; ++row)
-        for (int column = 0; column < Variables::numColumns; ++column)
-            updateCellState (row, column, getNumAlive (row, column));
+    if (m_Engine == Engine::Bitwise)
+        updateGridStateBitwise();
+    
+    else if (m_Engine == Engine::HashLife)
+        updateGridStateHashLife (0);
+    
+    else
+    {
+        for (int row = 0; row < m_NumRows; ++row)
+            for (int column = 0; column < m_NumColumns; ++column)
+                updateCellState (row, column, getNumAlive (row, column));
+        
+        // Next generation becomes the current one without copying any cells.
+        m_Cells.swapWith (m_NextCells);
+    }
+    
+    ++m_Generation;
+    publishSnapshot();
+}
+
+/**
+    Updates the state of the entire grid using the bit-packed engine.
+    Tiles are shared between the worker threads, and the byte per cell states are only
+    brought up to date when switching back to the cell engine.
+ */
+
+void Grid::updateGridStateBitwise()
+{
+    m_WorkerPool.run (*this, m_BitGrid.getNumTiles());
+    m_BitGrid.swapGenerations();
+}
+
+/**
+    Advances the board by 2^log2Generations generations using the HashLife engine, then clips
+    the pattern to the grid and copies it into the bit-packed grid. Cells beyond the edges die
+    at the end of each step, so single generations match the other engines.
+    @param log2Generations Base 2 logarithm of the number of generations.
+ */
+
+void Grid::updateGridStateHashLife (int log2Generations)
+{
+    if (m_HashLifeIsStale)
+    {
+        m_HashLife.loadFrom (m_BitGrid);
+        m_HashLifeIsStale = false;
+    }
+    
+    m_HashLife.advance (log2Generations);
+    m_HashLife.clip (m_BitGrid.getNumRows(), m_BitGrid.getNumColumns());
+    m_HashLife.storeTo (m_BitGrid);
+}
+
+/**
+    Advances the grid by 2^log2Generations generations and publishes the result, returning the
+    number of generations actually advanced. The HashLife engine does this in a single step, up to
+    2^Variables::hashLifeMaxStepLog generations. Other engines step one generation at a time while
+    holding the lock, so they are clamped to 2^Variables::maxSteppedFastForwardLog generations.
+    @param log2Generations Base 2 logarithm of the number of generations.
+ */
+
+juce::int64 Grid::fastForward (int log2Generations)
+{
+    const juce::ScopedLock lock (m_Lock);
+    
+    if (m_Engine == Engine::HashLife)
+    {
+        log2Generations = juce::jlimit (0, Variables::hashLifeMaxStepLog, log2Generations);
+        
+        updateGridStateHashLife (log2Generations);
+        m_Generation += (juce::int64) 1 << log2Generations;
+        publishSnapshot();
+    }
+    
+    else
+    {
+        log2Generations = juce::jlimit (0, Variables::maxSteppedFastForwardLog, log2Generations);
+        
+        for (int i = 0; i < (1 << log2Generations); ++i)
+            updateGridState();
+    }
+    
+    return (juce::int64) 1 << log2Generations;
+}
+
+/**
+    Copies the current generation into a snapshot and publishes it to the audio thread.
+ */
+
+void Grid::publishSnapshot()
+{
+    GridSnapshot& snapshot = m_Snapshots.getWriteBuffer();
+    
+    if (m_Engine != Engine::Cells)
+    {
+        for (int row = 0; row < m_NumRows; ++row)
+            std::memcpy (snapshot.getRow (row), m_BitGrid.getRow (row), sizeof (juce::uint64) * (size_t) m_BitGrid.getNumWords());
+    }
+    
+    else
+    {
+        for (int row = 0; row < m_NumRows; ++row)
+        {
+            CellSpan<const juce::uint8> cells = getCellRow (row);
+            juce::uint64* words = snapshot.getRow (row);
+            
+            // Packs 64 cells into each word, walking the row linearly.
+            for (int word = 0; word < snapshot.getNumWords(); ++word)
+            {
+                juce::uint64 bits = 0;
+                int endColumn = juce::jmin (64, m_NumColumns - word * 64);
+                
+                for (int bit = 0; bit < endColumn; ++bit)
+                    bits |= (juce::uint64) (cells[word * 64 + bit] != 0) << bit;
+                
+                words[word] = bits;
+            }
+        }
+    }
+    
+    // Only the bitwise engine tracks which tiles changed, other engines report every tile.
+    for (int tileIndex = 0; tileIndex < m_BitGrid.getNumTiles(); ++tileIndex)
+        snapshot.setTileChanged (tileIndex, m_Engine != Engine::Bitwise || m_BitGrid.getTileChanged (tileIndex));
+    
+    snapshot.setGeneration (m_Generation);
+    m_Snapshots.publish();
+}
+
+
+//================================================//
+// Stepping methods.
+
+/**
+    Starts stepping the grid, on the simulation thread or with Variables::useSimulationThread off,
+    on the legacy message thread timer. Must be called from the message thread.
+ */
+
+void Grid::startStepping()
+{
+    if (Variables::useSimulationThread)
+        m_SimulationThread.startThread();
+    
+    else
+        startTimer (Variables::gridRefreshRate);
+}
+
+/**
+    Stops stepping the grid, waiting for a generation in progress to finish. Used by tools which
+    step the grid themselves. Must be called from the message thread.
+ */
+
+void Grid::stopStepping()
+{
+    stopTimer();
+    m_SimulationThread.stopThread (-1);
+}
+
+/**
+    Computes and publishes the next generation, timing it with the profiler.
+    Called by the simulation thread or the timer, only one of which ever runs.
+ */
+
+void Grid::step()
+{
+    const juce::ScopedLock lock (m_Lock);
+    
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::gridStep);
+        updateGridState();
+    }
+    
+    m_Profiler.finishTask();
 }
 
 
@@ -158,10 +468,71 @@ void Grid::updateGridState()
 
 /**
     Inherited from juce::Timer class.
-    This is used to regularly update the grid based on a set time interval.
+    Steps the grid at the legacy cadence when the simulation thread isn't used.
  */
 
 void Grid::timerCallback()
 {
-    updateGridState();
+    step();
+}
+
+
+//================================================//
+// Simulation thread.
+
+Grid::SimulationThread::SimulationThread (Grid& grid)
+    :   juce::Thread ("Grid Simulation"),
+        m_Grid (grid)
+{
+}
+
+/**
+    Inherited from juce::Thread class.
+    Steps the grid on a fixed schedule. A generation which overruns its period isn't caught up on,
+    so a grid too large for its step rate slows down instead of stepping in bursts. Changing the
+    step rate wakes the thread, which then starts a new period.
+ */
+
+void Grid::SimulationThread::run()
+{
+    double appliedStepRate = 0.0;
+    double nextStepTime = 0.0;
+    
+    while (! threadShouldExit())
+    {
+        double stepRate = m_Grid.getStepRate();
+        double now = juce::Time::getMillisecondCounterHiRes();
+        
+        // The profiler is only ever written by this thread, so its deadline is changed here too.
+        if (stepRate != appliedStepRate)
+        {
+            appliedStepRate = stepRate;
+            nextStepTime = now + 1000.0 / stepRate;
+            m_Grid.m_Profiler.setDeadline (1.0 / stepRate);
+        }
+        
+        if (now < nextStepTime)
+        {
+            wait ((int) std::ceil (nextStepTime - now));
+            continue;
+        }
+        
+        m_Grid.step();
+        nextStepTime = juce::jmax (nextStepTime + 1000.0 / stepRate, juce::Time::getMillisecondCounterHiRes());
+    }
+}
+
+
+//================================================//
+// WorkerPool::Job methods.
+
+/**
+    Computes the next generation of one tile of the bitwise engine.
+    Called by updateGridStateBitwise, possibly from a grid worker thread.
+    @param tileIndex Index of the tile.
+ */
+
+void Grid::processTask (int tileIndex)
+{
+    m_BitGrid.updateTileState (tileIndex);
 }
@@ -3,34 +3,100 @@
 
 //================================================//
 /// Grid class containing all cells and logic for game of life algorithm.
+/// Generations are stepped by a simulation thread of its own at a rate which can be changed at any time,
+/// or with Variables::useSimulationThread off, by a message thread timer at the legacy cadence.
+/// Each generation is published to the audio thread through a TripleBuffer.
 
-class Grid : public juce::Timer
+class Grid : public juce::Timer, private WorkerPool::Job
 {
 public:
+    /// Engines available to compute the next generation.
+    enum class Engine
+    {
+        Cells,                                                              // Updates each cell individually, one byte per cell.
+        Bitwise,                                                            // Updates 64 cells at a time using a bit-packed grid.
+        HashLife                                                            // Updates a memoised quadtree of an unbounded board, see HashLife.
+    };
+    
     Grid();
     ~Grid();
     
     // Setter methods.
+    void setSize (int numRows, int numColumns);
     void setCellIsAlive (int row, int column, bool isAlive);
+    void setEngine (Engine engine);
+    void setNumWorkers (int numWorkers, bool useAffinity);
+    void setRandomSeed (juce::int64 seed);
+    void setStepRate (double stepRate);
     
     // Getter methods.
-    Cell* getCell (int row, int column);
+    int getNumRows();
+    int getNumColumns();
+    CellSpan<const juce::uint8> getCellRow (int row);
     bool getCellIsAlive (int row, int column);
+    Engine getEngine();
+    juce::int64 getGeneration();
+    GridSnapshot& getSnapshot();
+    Profiler& getProfiler();
+    double getStepRate();
     
     // Grid logic methods.
     int getNumAlive (int row, int column);
     
     // Grid state methods.
+    void randomise();
     void updateCellState (int row, int column, int numAlive);
     void updateGridState();
+    void updateGridStateBitwise();
+    void updateGridStateHashLife (int log2Generations);
+    juce::int64 fastForward (int log2Generations);
+    void publishSnapshot();
+    
+    // Stepping methods.
+    void startStepping();
+    void stopStepping();
+    void step();
     
     // Timer class methods.
     void timerCallback() override;
-    
+
 private:
-    juce::OwnedArray<Cell> m_Cells;                                         // Array containing cell objects.
-    int m_NumCells = Variables::numRows * Variables::numColumns;            // Number of cells.
+    //================================================//
+    /// Thread stepping the grid at its step rate, away from the message thread.
+    
+    class SimulationThread : public juce::Thread
+    {
+    public:
+        SimulationThread (Grid& grid);
+        
+        // Thread class methods.
+        void run() override;
+    
+    private:
+        Grid& m_Grid;                                                       // Grid stepped by the thread.
+    };
+    
+    // WorkerPool::Job methods.
+    void processTask (int tileIndex) override;
+    
+    CellPlane<juce::uint8> m_Cells;                                         // Cell states of the current generation, one byte per cell.
+    CellPlane<juce::uint8> m_NextCells;                                     // Cell states of the generation being computed.
+    BitGrid m_BitGrid;                                                      // Bit-packed copy of the cell states used by the bitwise and HashLife engines.
+    WorkerPool m_WorkerPool;                                                // Threads sharing the tiles of the bitwise engine.
+    HashLife m_HashLife;                                                    // Quadtree used by the HashLife engine.
+    bool m_HashLifeIsStale = true;                                          // True when cells were changed outside the HashLife engine.
+    Engine m_Engine = Variables::useBitwiseEngine ? Engine::Bitwise : Engine::Cells;    // Engine used to update the grid.
+    int m_NumRows = 0;                                                      // Number of rows.
+    int m_NumColumns = 0;                                                   // Number of columns.
+    juce::int64 m_Generation = 0;                                           // Number of generations computed since the grid was initialised.
     juce::Random m_Random;                                                  // Random object used to generate random values.
     
+    TripleBuffer<GridSnapshot> m_Snapshots;                                 // Snapshots published to the audio thread after each generation.
+    Profiler m_Profiler;                                                    // Timing of the generations computed by the timer.
+    juce::CriticalSection m_Lock;                                           // Serialises resizing and updates, never taken by the audio thread.
+    
+    std::atomic<double> m_StepRate { Variables::gridStepRate };             // Generations per second computed by the simulation thread.
+    SimulationThread m_SimulationThread { *this };                          // Thread stepping the grid, unless the legacy timer is used.
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Grid)
 };
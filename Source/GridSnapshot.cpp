@@ -0,0 +1,137 @@
+#include "Headers.h"
+
+
+//================================================//
+// Immutable copy of the grid state handed between threads.
+
+GridSnapshot::GridSnapshot() {}
+
+GridSnapshot::~GridSnapshot() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Allocates storage for a grid of the given size and clears all cells.
+    @param numRows Number of rows.
+    @param numColumns Number of columns.
+    @param useFades Whether to allocate storage for fade values.
+ */
+
+void GridSnapshot::setSize (int numRows, int numColumns, bool useFades)
+{
+    m_NumRows = numRows;
+    m_NumColumns = numColumns;
+    m_NumWords = (numColumns + 63) / 64;
+    m_UseFades = useFades;
+    m_Generation = 0;
+    
+    m_NumTileRows = (m_NumRows + Variables::tileNumRows - 1) / Variables::tileNumRows;
+    m_NumTileColumns = (m_NumWords + Variables::tileNumWords - 1) / Variables::tileNumWords;
+    
+    m_Words.calloc ((size_t) (m_NumRows * m_NumWords));
+    m_TileChanged.calloc ((size_t) (m_NumTileRows * m_NumTileColumns));
+    
+    // Snapshots without fades keep an empty plane.
+    m_Fades.setSize (useFades ? numRows : 0, useFades ? numColumns : 0);
+}
+
+
+//================================================//
+// Setter methods.
+
+void GridSnapshot::setGeneration (juce::int64 generation)           { m_Generation = generation; }
+void GridSnapshot::setTileChanged (int tileIndex, bool hasChanged)  { m_TileChanged[tileIndex] = hasChanged; }
+
+/**
+    Sets the state of a cell to alive or dead.
+    @param row Row index of the cell.
+    @param column Column index of the cell.
+    @param isAlive State of the cell.
+ */
+
+void GridSnapshot::setCellIsAlive (int row, int column, bool isAlive)
+{
+    juce::uint64& word = getRow (row)[column >> 6];
+    juce::uint64 bit = (juce::uint64) 1 << (column & 63);
+    
+    if (isAlive)
+        word |= bit;
+    
+    else
+        word &= ~bit;
+}
+
+
+//================================================//
+// Getter methods.
+
+int GridSnapshot::getNumRows() const                                { return m_NumRows; }
+int GridSnapshot::getNumColumns() const                             { return m_NumColumns; }
+int GridSnapshot::getNumWords() const                               { return m_NumWords; }
+juce::int64 GridSnapshot::getGeneration() const                     { return m_Generation; }
+CellPlane<float>& GridSnapshot::getFades()                          { return m_Fades; }
+const CellPlane<float>& GridSnapshot::getFades() const              { return m_Fades; }
+int GridSnapshot::getNumTileRows() const                            { return m_NumTileRows; }
+int GridSnapshot::getNumTileColumns() const                         { return m_NumTileColumns; }
+bool GridSnapshot::getTileChanged (int tileIndex) const             { return m_TileChanged[tileIndex]; }
+
+/**
+    Returns boolean representing the state of the cell.
+    @param row Row index of the cell.
+    @param column Column index of the cell.
+ */
+
+bool GridSnapshot::getCellIsAlive (int row, int column) const
+{
+    return (getRow (row)[column >> 6] >> (column & 63)) & 1;
+}
+
+/**
+    Returns the fade value of a cell, or its state if fades are not stored.
+    @param row Row index of the cell.
+    @param column Column index of the cell.
+ */
+
+float GridSnapshot::getFade (int row, int column) const
+{
+    if (! m_UseFades)
+        return getCellIsAlive (row, column) ? 1.0f : 0.0f;
+    
+    return m_Fades.getRow (row)[column];
+}
+
+/**
+    Returns pointer to the first word of a row.
+    @param row Row index.
+ */
+
+juce::uint64* GridSnapshot::getRow (int row)
+{
+    return m_Words + (size_t) row * (size_t) m_NumWords;
+}
+
+const juce::uint64* GridSnapshot::getRow (int row) const
+{
+    return m_Words + (size_t) row * (size_t) m_NumWords;
+}
+
+
+//================================================//
+// State methods.
+
+/**
+    Copies cell states, tile changes and generation from another snapshot of the same size.
+    Fade values are left untouched.
+    @param other Snapshot to copy from.
+ */
+
+void GridSnapshot::copyFrom (const GridSnapshot& other)
+{
+    jassert (other.m_NumRows == m_NumRows && other.m_NumColumns == m_NumColumns);
+    
+    std::memcpy (m_Words, other.m_Words, sizeof (juce::uint64) * (size_t) (m_NumRows * m_NumWords));
+    std::memcpy (m_TileChanged, other.m_TileChanged, sizeof (bool) * (size_t) (m_NumTileRows * m_NumTileColumns));
+    m_Generation = other.m_Generation;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+
+//================================================//
+/// Immutable copy of the grid state handed between threads through a TripleBuffer.
+/// Cell states are bit-packed in the same layout as BitGrid, and tiles match BitGrid's tiles. Fade values are optional.
+
+class GridSnapshot
+{
+public:
+    GridSnapshot();
+    ~GridSnapshot();
+    
+    // Init methods.
+    void setSize (int numRows, int numColumns, bool useFades);
+    
+    // Setter methods.
+    void setGeneration (juce::int64 generation);
+    void setCellIsAlive (int row, int column, bool isAlive);
+    void setTileChanged (int tileIndex, bool hasChanged);
+    
+    // Getter methods.
+    int getNumRows() const;
+    int getNumColumns() const;
+    int getNumWords() const;
+    juce::int64 getGeneration() const;
+    bool getCellIsAlive (int row, int column) const;
+    float getFade (int row, int column) const;
+    juce::uint64* getRow (int row);
+    const juce::uint64* getRow (int row) const;
+    CellPlane<float>& getFades();
+    const CellPlane<float>& getFades() const;
+    int getNumTileRows() const;
+    int getNumTileColumns() const;
+    bool getTileChanged (int tileIndex) const;
+    
+    // State methods.
+    void copyFrom (const GridSnapshot& other);
+    
+private:
+    juce::HeapBlock<juce::uint64> m_Words;                                  // Cell states, one bit per cell, stored row by row.
+    CellPlane<float> m_Fades;                                               // Fade values, one per cell, stored row by row.
+    juce::HeapBlock<bool> m_TileChanged;                                    // Whether each tile had births or deaths since the previous generation.
+    
+    int m_NumRows = 0;                                                      // Number of rows.
+    int m_NumColumns = 0;                                                   // Number of columns.
+    int m_NumWords = 0;                                                     // Number of 64 bit words per row.
+    int m_NumTileRows = 0;                                                  // Number of tiles along the rows.
+    int m_NumTileColumns = 0;                                               // Number of tiles along the columns.
+    bool m_UseFades = false;                                                // Whether fade values are stored.
+    juce::int64 m_Generation = 0;                                           // Generation the snapshot was taken from.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GridSnapshot)
+};
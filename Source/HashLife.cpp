@@ -0,0 +1,657 @@
+#include "Headers.h"
+
+
+//================================================//
+// HashLife engine which stores the board as a canonicalised quadtree.
+
+HashLife::HashLife()
+{
+    clearNodes();
+}
+
+HashLife::~HashLife() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Replaces the current pattern with the cells of a bit-packed grid.
+    @param bitGrid Grid to load, placed with its first cell at the origin.
+ */
+
+void HashLife::loadFrom (BitGrid& bitGrid)
+{
+    clearNodes();
+    
+    // The smallest root centred on the origin which still covers the whole grid.
+    int level = 3;
+    
+    while (((juce::int64) 1 << (level - 1)) < juce::jmax (bitGrid.getNumRows(), bitGrid.getNumColumns()))
+        ++level;
+    
+    juce::int64 half = (juce::int64) 1 << (level - 1);
+    m_Root = buildNode (bitGrid, level, -half, -half);
+}
+
+
+//================================================//
+// Getter methods.
+
+int HashLife::getNumNodes()                                         { return (int) m_Nodes.size(); }
+int HashLife::getMaxNodes()                                         { return m_MaxNodes; }
+
+
+//================================================//
+// State methods.
+
+/**
+    Advances the pattern by 2^log2Generations generations.
+    @param log2Generations Base 2 logarithm of the number of generations.
+ */
+
+void HashLife::advance (int log2Generations)
+{
+    jassert (log2Generations >= 0 && log2Generations <= Variables::hashLifeMaxStepLog);
+    
+    // Results of nodes above the lower of the two step sizes were computed for a different step.
+    if (log2Generations != m_StepLog)
+    {
+        clearResults (juce::jmin (log2Generations, m_StepLog) + 3);
+        m_StepLog = log2Generations;
+    }
+    
+    // Pads the pattern with enough empty space that it cannot reach the edge of the result.
+    while (m_Nodes[m_Root].level < m_StepLog + 2 || ! isCentred (m_Root))
+        m_Root = expand (m_Root);
+    
+    m_Root = getSuccessor (expand (m_Root));
+    
+    // Memory is bounded between steps by dropping the nodes nothing refers to any more.
+    if (m_Nodes.size() > (size_t) m_MaxNodes)
+        garbageCollect();
+}
+
+/**
+    Kills every cell outside the window of a grid, as the dead edges of the other engines do.
+    Only the nodes crossing the edges of the window are rebuilt, so memoised results are kept.
+    @param numRows Number of rows of the window, starting at the origin.
+    @param numColumns Number of columns of the window, starting at the origin.
+ */
+
+void HashLife::clip (int numRows, int numColumns)
+{
+    juce::int64 half = (juce::int64) 1 << (m_Nodes[m_Root].level - 1);
+    m_Root = clipNode (m_Root, -half, -half, numRows, numColumns);
+}
+
+/**
+    Writes the part of the pattern which falls inside a bit-packed grid.
+    @param bitGrid Grid to write to, with its first cell at the origin.
+ */
+
+void HashLife::storeTo (BitGrid& bitGrid)
+{
+    for (int row = 0; row < bitGrid.getNumRows(); ++row)
+        std::fill (bitGrid.getRow (row), bitGrid.getRow (row) + bitGrid.getNumWords(), (juce::uint64) 0);
+    
+    bitGrid.setAllTilesChanged();
+    
+    juce::int64 half = (juce::int64) 1 << (m_Nodes[m_Root].level - 1);
+    storeNode (bitGrid, m_Root, -half, -half);
+}
+
+/**
+    Drops the nodes which can no longer be reached from the root, the empty nodes or the memoised
+    results of reachable nodes, and compacts the pool. Reachable nodes keep their results.
+    If the reachable nodes fill more than half of the pool's budget, the results are dropped too so the
+    pattern alone is kept. If even that fills more than half of the budget, the budget is doubled,
+    since collecting again after every step would only waste time.
+ */
+
+void HashLife::garbageCollect()
+{
+    bool keepResults = true;
+    std::vector<bool> isReachable;
+    int numReachable = markReachable (isReachable, keepResults);
+    
+    if (numReachable > m_MaxNodes / 2)
+    {
+        keepResults = false;
+        numReachable = markReachable (isReachable, keepResults);
+    }
+    
+    // Nodes keep their order, so a node never moves above one it hasn't been copied from yet.
+    // Results can be newer than their nodes, so every new index is known before anything moves.
+    std::vector<juce::uint32> remap (m_Nodes.size(), noNode);
+    juce::uint32 numKept = 0;
+    
+    for (juce::uint32 node = 0; node < (juce::uint32) m_Nodes.size(); ++node)
+        if (isReachable[node])
+            remap[node] = numKept++;
+    
+    for (juce::uint32 node = 0; node < (juce::uint32) m_Nodes.size(); ++node)
+    {
+        if (! isReachable[node])
+            continue;
+        
+        Node n = m_Nodes[node];
+        
+        if (n.level > 0)
+        {
+            n.nw = remap[n.nw];
+            n.ne = remap[n.ne];
+            n.sw = remap[n.sw];
+            n.se = remap[n.se];
+        }
+        
+        n.result = keepResults && n.result != noResult ? remap[n.result] : noResult;
+        m_Nodes[remap[node]] = n;
+    }
+    
+    m_Nodes.resize (numKept);
+    m_Root = remap[m_Root];
+    
+    for (auto& emptyNode : m_EmptyNodes)
+        emptyNode = remap[emptyNode];
+    
+    rehash ((int) m_Buckets.size());
+    
+    if (numReachable > m_MaxNodes / 2)
+    {
+        jassert (m_MaxNodes <= std::numeric_limits<int>::max() / 2);
+        m_MaxNodes *= 2;
+    }
+}
+
+
+//================================================//
+// Node methods.
+
+/**
+    Returns the canonical node with the given children, creating it if needed.
+    @param nw North-west child.
+    @param ne North-east child.
+    @param sw South-west child.
+    @param se South-east child.
+ */
+
+juce::uint32 HashLife::getNode (juce::uint32 nw, juce::uint32 ne, juce::uint32 sw, juce::uint32 se)
+{
+    juce::uint32 bucket = getHash (nw, ne, sw, se) & (juce::uint32) (m_Buckets.size() - 1);
+    
+    for (juce::uint32 node = m_Buckets[bucket]; node != noNode; node = m_Nodes[node].next)
+    {
+        const Node& candidate = m_Nodes[node];
+        
+        if (candidate.nw == nw && candidate.ne == ne && candidate.sw == sw && candidate.se == se)
+            return node;
+    }
+    
+    auto node = (juce::uint32) m_Nodes.size();
+    m_Nodes.push_back ({ nw, ne, sw, se, noResult, m_Buckets[bucket], m_Nodes[nw].level + 1 });
+    m_Buckets[bucket] = node;
+    
+    if (m_Nodes.size() > m_Buckets.size())
+        rehash ((int) m_Buckets.size() * 2);
+    
+    return node;
+}
+
+/**
+    Returns the node of a given level with no live cells.
+    @param level Level of the node.
+ */
+
+juce::uint32 HashLife::getEmptyNode (int level)
+{
+    while ((int) m_EmptyNodes.size() <= level)
+    {
+        juce::uint32 child = m_EmptyNodes.back();
+        m_EmptyNodes.push_back (getNode (child, child, child, child));
+    }
+    
+    return m_EmptyNodes[(size_t) level];
+}
+
+/**
+    Returns the centre quarter of a node, one level down, without stepping.
+    @param node Node of level 2 or more.
+ */
+
+juce::uint32 HashLife::getCentre (juce::uint32 node)
+{
+    Node n = m_Nodes[node];
+    
+    return getNode (m_Nodes[n.nw].se, m_Nodes[n.ne].sw, m_Nodes[n.sw].ne, m_Nodes[n.se].nw);
+}
+
+/**
+    Returns the centre quarter of a node, one level down, stepped into the future.
+    Nodes up to level m_StepLog + 2 advance 2^(level - 2) generations, larger nodes advance 2^m_StepLog.
+    Results are memoised in the node, and nodes are copied rather than referenced because the pool can grow.
+    @param node Node of level 2 or more.
+ */
+
+juce::uint32 HashLife::getSuccessor (juce::uint32 node)
+{
+    Node n = m_Nodes[node];
+    
+    if (n.result != noResult)
+        return n.result;
+    
+    juce::uint32 result;
+    
+    if (n.level == 2)
+        result = getBaseSuccessor (node);
+    
+    else
+    {
+        Node nw = m_Nodes[n.nw];
+        Node ne = m_Nodes[n.ne];
+        Node sw = m_Nodes[n.sw];
+        Node se = m_Nodes[n.se];
+        
+        // Nine overlapping sub-nodes, one level down.
+        juce::uint32 n00 = n.nw;
+        juce::uint32 n01 = getNode (nw.ne, ne.nw, nw.se, ne.sw);
+        juce::uint32 n02 = n.ne;
+        juce::uint32 n10 = getNode (nw.sw, nw.se, sw.nw, sw.ne);
+        juce::uint32 n11 = getNode (nw.se, ne.sw, sw.ne, se.nw);
+        juce::uint32 n12 = getNode (ne.sw, ne.se, se.nw, se.ne);
+        juce::uint32 n20 = n.sw;
+        juce::uint32 n21 = getNode (sw.ne, se.nw, sw.se, se.sw);
+        juce::uint32 n22 = n.se;
+        
+        // At full speed both halves of the step advance, otherwise only the second one does.
+        bool isFullSpeed = n.level - 2 <= m_StepLog;
+        
+        auto step = [this, isFullSpeed] (juce::uint32 subNode)
+        {
+            return isFullSpeed ? getSuccessor (subNode) : getCentre (subNode);
+        };
+        
+        juce::uint32 r00 = step (n00), r01 = step (n01), r02 = step (n02);
+        juce::uint32 r10 = step (n10), r11 = step (n11), r12 = step (n12);
+        juce::uint32 r20 = step (n20), r21 = step (n21), r22 = step (n22);
+        
+        juce::uint32 resultNW = getSuccessor (getNode (r00, r01, r10, r11));
+        juce::uint32 resultNE = getSuccessor (getNode (r01, r02, r11, r12));
+        juce::uint32 resultSW = getSuccessor (getNode (r10, r11, r20, r21));
+        juce::uint32 resultSE = getSuccessor (getNode (r11, r12, r21, r22));
+        
+        result = getNode (resultNW, resultNE, resultSW, resultSE);
+    }
+    
+    m_Nodes[node].result = result;
+    return result;
+}
+
+/**
+    Returns the centre 2x2 cells of a level 2 node after one generation.
+    @param node Node of level 2.
+ */
+
+juce::uint32 HashLife::getBaseSuccessor (juce::uint32 node)
+{
+    Node n = m_Nodes[node];
+    Node nw = m_Nodes[n.nw];
+    Node ne = m_Nodes[n.ne];
+    Node sw = m_Nodes[n.sw];
+    Node se = m_Nodes[n.se];
+    
+    // Level 0 nodes 0 and 1 double as the cell states.
+    juce::uint32 cells[4][4] =
+    {
+        { nw.nw, nw.ne, ne.nw, ne.ne },
+        { nw.sw, nw.se, ne.sw, ne.se },
+        { sw.nw, sw.ne, se.nw, se.ne },
+        { sw.sw, sw.se, se.sw, se.se }
+    };
+    
+    auto getNextState = [&cells] (int row, int column)
+    {
+        juce::uint32 numAlive = 0;
+        
+        for (int y = row - 1; y <= row + 1; ++y)
+            for (int x = column - 1; x <= column + 1; ++x)
+                numAlive += cells[y][x];
+        
+        numAlive -= cells[row][column];
+        
+        return (juce::uint32) (numAlive == 3 || (numAlive == 2 && cells[row][column] == 1));
+    };
+    
+    return getNode (getNextState (1, 1), getNextState (1, 2), getNextState (2, 1), getNextState (2, 2));
+}
+
+/**
+    Returns a node one level up with the given node in its centre.
+    @param node Node to expand.
+ */
+
+juce::uint32 HashLife::expand (juce::uint32 node)
+{
+    Node n = m_Nodes[node];
+    juce::uint32 empty = getEmptyNode (n.level - 1);
+    
+    juce::uint32 nw = getNode (empty, empty, empty, n.nw);
+    juce::uint32 ne = getNode (empty, empty, n.ne, empty);
+    juce::uint32 sw = getNode (empty, n.sw, empty, empty);
+    juce::uint32 se = getNode (n.se, empty, empty, empty);
+    
+    return getNode (nw, ne, sw, se);
+}
+
+/**
+    Returns true if every live cell lies in the centre half of the node along both axes.
+    @param node Node to check, of level 2 or more.
+ */
+
+bool HashLife::isCentred (juce::uint32 node)
+{
+    Node n = m_Nodes[node];
+    juce::uint32 empty = getEmptyNode (n.level - 2);
+    
+    Node nw = m_Nodes[n.nw];
+    Node ne = m_Nodes[n.ne];
+    Node sw = m_Nodes[n.sw];
+    Node se = m_Nodes[n.se];
+    
+    return nw.nw == empty && nw.ne == empty && nw.sw == empty
+        && ne.nw == empty && ne.ne == empty && ne.se == empty
+        && sw.nw == empty && sw.sw == empty && sw.se == empty
+        && se.ne == empty && se.sw == empty && se.se == empty;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Returns a hash of a node's children.
+ */
+
+juce::uint32 HashLife::getHash (juce::uint32 nw, juce::uint32 ne, juce::uint32 sw, juce::uint32 se)
+{
+    juce::uint64 hash = nw;
+    hash = hash * 0x9e3779b97f4a7c15ULL + ne;
+    hash = hash * 0x9e3779b97f4a7c15ULL + sw;
+    hash = hash * 0x9e3779b97f4a7c15ULL + se;
+    
+    return (juce::uint32) (hash ^ (hash >> 29));
+}
+
+/**
+    Builds the node covering a square of a bit-packed grid. Cells outside the grid are dead.
+    @param bitGrid Grid to read.
+    @param level Level of the node.
+    @param column Column of the node's first cell.
+    @param row Row of the node's first cell.
+ */
+
+juce::uint32 HashLife::buildNode (BitGrid& bitGrid, int level, juce::int64 column, juce::int64 row)
+{
+    juce::int64 size = (juce::int64) 1 << level;
+    
+    if (column + size <= 0 || row + size <= 0 || column >= bitGrid.getNumColumns() || row >= bitGrid.getNumRows())
+        return getEmptyNode (level);
+    
+    if (level == 0)
+        return bitGrid.getCellIsAlive ((int) row, (int) column) ? 1 : 0;
+    
+    juce::int64 half = size / 2;
+    
+    juce::uint32 nw = buildNode (bitGrid, level - 1, column, row);
+    juce::uint32 ne = buildNode (bitGrid, level - 1, column + half, row);
+    juce::uint32 sw = buildNode (bitGrid, level - 1, column, row + half);
+    juce::uint32 se = buildNode (bitGrid, level - 1, column + half, row + half);
+    
+    return getNode (nw, ne, sw, se);
+}
+
+/**
+    Writes the live cells of a node which fall inside a bit-packed grid.
+    @param bitGrid Grid to write to.
+    @param node Node to write.
+    @param column Column of the node's first cell.
+    @param row Row of the node's first cell.
+ */
+
+void HashLife::storeNode (BitGrid& bitGrid, juce::uint32 node, juce::int64 column, juce::int64 row)
+{
+    Node n = m_Nodes[node];
+    juce::int64 size = (juce::int64) 1 << n.level;
+    
+    if (column + size <= 0 || row + size <= 0 || column >= bitGrid.getNumColumns() || row >= bitGrid.getNumRows())
+        return;
+    
+    if (node == getEmptyNode (n.level))
+        return;
+    
+    if (n.level == 0)
+    {
+        bitGrid.setCellIsAlive ((int) row, (int) column, true);
+        return;
+    }
+    
+    juce::int64 half = size / 2;
+    
+    storeNode (bitGrid, n.nw, column, row);
+    storeNode (bitGrid, n.ne, column + half, row);
+    storeNode (bitGrid, n.sw, column, row + half);
+    storeNode (bitGrid, n.se, column + half, row + half);
+}
+
+/**
+    Returns a node with every cell outside a window killed.
+    @param node Node to clip.
+    @param column Column of the node's first cell.
+    @param row Row of the node's first cell.
+    @param numRows Number of rows of the window, starting at the origin.
+    @param numColumns Number of columns of the window, starting at the origin.
+ */
+
+juce::uint32 HashLife::clipNode (juce::uint32 node, juce::int64 column, juce::int64 row, int numRows, int numColumns)
+{
+    Node n = m_Nodes[node];
+    juce::int64 size = (juce::int64) 1 << n.level;
+    
+    if (column >= 0 && row >= 0 && column + size <= numColumns && row + size <= numRows)
+        return node;
+    
+    if (column + size <= 0 || row + size <= 0 || column >= numColumns || row >= numRows || node == getEmptyNode (n.level))
+        return getEmptyNode (n.level);
+    
+    // Single cells are either inside or outside, so only nodes of level 1 or more get here.
+    juce::int64 half = size / 2;
+    
+    juce::uint32 nw = clipNode (n.nw, column, row, numRows, numColumns);
+    juce::uint32 ne = clipNode (n.ne, column + half, row, numRows, numColumns);
+    juce::uint32 sw = clipNode (n.sw, column, row + half, numRows, numColumns);
+    juce::uint32 se = clipNode (n.se, column + half, row + half, numRows, numColumns);
+    
+    return getNode (nw, ne, sw, se);
+}
+
+/**
+    Marks a node and every node it refers to as reachable, returning the number newly marked.
+    @param isReachable Whether each node of the pool has been marked.
+    @param node Node to mark, or noNode.
+    @param keepResults Whether memoised results are followed as well as children.
+ */
+
+int HashLife::markNode (std::vector<bool>& isReachable, juce::uint32 node, bool keepResults)
+{
+    if (node == noNode || isReachable[node])
+        return 0;
+    
+    isReachable[node] = true;
+    
+    // Children and results are a level lower, so the recursion is no deeper than the root's level.
+    Node n = m_Nodes[node];
+    int numMarked = 1;
+    
+    if (n.level > 0)
+    {
+        numMarked += markNode (isReachable, n.nw, keepResults);
+        numMarked += markNode (isReachable, n.ne, keepResults);
+        numMarked += markNode (isReachable, n.sw, keepResults);
+        numMarked += markNode (isReachable, n.se, keepResults);
+    }
+    
+    if (keepResults)
+        numMarked += markNode (isReachable, n.result, keepResults);
+    
+    return numMarked;
+}
+
+/**
+    Marks the nodes reachable from the root and the empty nodes, returning how many there are.
+    The dead and live cells are always kept, since they double as the cell states.
+    @param isReachable Filled with whether each node of the pool is reachable.
+    @param keepResults Whether memoised results are followed as well as children.
+ */
+
+int HashLife::markReachable (std::vector<bool>& isReachable, bool keepResults)
+{
+    isReachable.assign (m_Nodes.size(), false);
+    
+    int numMarked = markNode (isReachable, 0, keepResults) + markNode (isReachable, 1, keepResults);
+    numMarked += markNode (isReachable, m_Root, keepResults);
+    
+    for (auto emptyNode : m_EmptyNodes)
+        numMarked += markNode (isReachable, emptyNode, keepResults);
+    
+    return numMarked;
+}
+
+/**
+    Empties the pool, leaving only the dead and live cells.
+ */
+
+void HashLife::clearNodes()
+{
+    m_Nodes.clear();
+    m_Nodes.push_back ({ noNode, noNode, noNode, noNode, noResult, noNode, 0 });
+    m_Nodes.push_back ({ noNode, noNode, noNode, noNode, noResult, noNode, 0 });
+    
+    m_EmptyNodes.assign (1, 0);
+    m_Buckets.assign ((size_t) Variables::hashLifeNumBuckets, noNode);
+    m_MaxNodes = Variables::hashLifeMaxNodes;
+    m_Root = getEmptyNode (3);
+}
+
+/**
+    Resizes the hash table and reinserts every node.
+    @param numBuckets New number of buckets, a power of two.
+ */
+
+void HashLife::rehash (int numBuckets)
+{
+    m_Buckets.assign ((size_t) numBuckets, noNode);
+    
+    for (juce::uint32 node = 2; node < (juce::uint32) m_Nodes.size(); ++node)
+    {
+        Node& n = m_Nodes[node];
+        juce::uint32 bucket = getHash (n.nw, n.ne, n.sw, n.se) & (juce::uint32) (numBuckets - 1);
+        
+        n.next = m_Buckets[bucket];
+        m_Buckets[bucket] = node;
+    }
+}
+
+/**
+    Forgets the memoised results of every node from a given level up.
+    @param minLevel Lowest level to clear.
+ */
+
+void HashLife::clearResults (int minLevel)
+{
+    for (auto& node : m_Nodes)
+        if (node.level >= minLevel)
+            node.result = noResult;
+}
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS
+
+/// Checks HashLife against the bitwise engine, with the pool collected after every step.
+
+class HashLifeTests : public juce::UnitTest
+{
+public:
+    HashLifeTests() : juce::UnitTest ("HashLife", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        beginTest ("Clipped single generations match the bitwise engine");
+        
+        juce::Random random (0x4a5e);
+        BitGrid bitGrid;
+        BitGrid hashLifeGrid;
+        bitGrid.setSize (40, 70);
+        hashLifeGrid.setSize (40, 70);
+        
+        for (int row = 0; row < bitGrid.getNumRows(); ++row)
+            for (int column = 0; column < bitGrid.getNumColumns(); ++column)
+                bitGrid.setCellIsAlive (row, column, random.nextInt (3) == 0);
+        
+        HashLife hashLife;
+        hashLife.loadFrom (bitGrid);
+        
+        int numWrong = 0;
+        
+        for (int generation = 0; generation < 60; ++generation)
+        {
+            bitGrid.updateGridState();
+            
+            hashLife.advance (0);
+            hashLife.clip (hashLifeGrid.getNumRows(), hashLifeGrid.getNumColumns());
+            hashLife.garbageCollect();
+            hashLife.storeTo (hashLifeGrid);
+            
+            for (int row = 0; row < bitGrid.getNumRows(); ++row)
+                for (int column = 0; column < bitGrid.getNumColumns(); ++column)
+                    numWrong += bitGrid.getCellIsAlive (row, column) != hashLifeGrid.getCellIsAlive (row, column);
+        }
+        
+        expectEquals (numWrong, 0, "HashLife differs from the bitwise engine");
+        
+        beginTest ("Collection keeps the results of reachable nodes");
+        
+        int numResults = 0;
+        
+        for (auto& node : hashLife.m_Nodes)
+            numResults += node.result != HashLife::noResult;
+        
+        expectGreaterThan (numResults, 0);
+        
+        // Collecting twice in a row has nothing more to drop.
+        int numNodes = hashLife.getNumNodes();
+        hashLife.garbageCollect();
+        expectEquals (hashLife.getNumNodes(), numNodes);
+        
+        beginTest ("A pattern outgrowing the pool doubles its budget");
+        
+        hashLife.m_MaxNodes = 16;
+        hashLife.garbageCollect();
+        expectEquals (hashLife.getMaxNodes(), 32);
+        
+        hashLife.storeTo (hashLifeGrid);
+        numWrong = 0;
+        
+        for (int row = 0; row < bitGrid.getNumRows(); ++row)
+            for (int column = 0; column < bitGrid.getNumColumns(); ++column)
+                numWrong += bitGrid.getCellIsAlive (row, column) != hashLifeGrid.getCellIsAlive (row, column);
+        
+        expectEquals (numWrong, 0, "Collecting without results changed the pattern");
+    }
+};
+
+static HashLifeTests hashLifeTests;
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+
+
+//================================================//
+/// HashLife engine which stores the board as a canonicalised quadtree and memoises the future of every node.
+/// The pattern lives on an unbounded plane, and the grid only shows the window starting at row 0, column 0.
+/// Clipping to that window after each step kills the cells beyond the edges, as the other engines do, so
+/// single generations match them exactly. Within a step of 2^k generations cells outside the window still
+/// take part, and the window only matches the other engines at the end of the step.
+/// Advancing by 2^k generations costs roughly the same as advancing by one once the pattern repeats itself.
+
+class HashLife
+{
+public:
+    HashLife();
+    ~HashLife();
+
+    // Init methods.
+    void loadFrom (BitGrid& bitGrid);
+
+    // Getter methods.
+    int getNumNodes();
+    int getMaxNodes();
+
+    // State methods.
+    void advance (int log2Generations);
+    void clip (int numRows, int numColumns);
+    void storeTo (BitGrid& bitGrid);
+    void garbageCollect();
+
+private:
+    friend class HashLifeTests;
+
+    /// Quadtree node. Level 0 nodes are single cells, a level k node covers 2^k x 2^k cells.
+    struct Node
+    {
+        juce::uint32 nw, ne, sw, se;                                        // Child quadrants.
+        juce::uint32 result;                                                // Memoised centre of the node after stepping, or noResult.
+        juce::uint32 next;                                                  // Next node in the same hash bucket, or noNode.
+        int level;                                                          // Level of the node.
+    };
+
+    // Node methods.
+    juce::uint32 getNode (juce::uint32 nw, juce::uint32 ne, juce::uint32 sw, juce::uint32 se);
+    juce::uint32 getEmptyNode (int level);
+    juce::uint32 getCentre (juce::uint32 node);
+    juce::uint32 getSuccessor (juce::uint32 node);
+    juce::uint32 getBaseSuccessor (juce::uint32 node);
+    juce::uint32 expand (juce::uint32 node);
+    bool isCentred (juce::uint32 node);
+
+    // Helper methods.
+    static juce::uint32 getHash (juce::uint32 nw, juce::uint32 ne, juce::uint32 sw, juce::uint32 se);
+    juce::uint32 buildNode (BitGrid& bitGrid, int level, juce::int64 column, juce::int64 row);
+    void storeNode (BitGrid& bitGrid, juce::uint32 node, juce::int64 column, juce::int64 row);
+    juce::uint32 clipNode (juce::uint32 node, juce::int64 column, juce::int64 row, int numRows, int numColumns);
+    int markNode (std::vector<bool>& isReachable, juce::uint32 node, bool keepResults);
+    int markReachable (std::vector<bool>& isReachable, bool keepResults);
+    void clearNodes();
+    void rehash (int numBuckets);
+    void clearResults (int minLevel);
+
+    static constexpr juce::uint32 noNode = 0xffffffff;                      // Marks the end of a hash bucket.
+    static constexpr juce::uint32 noResult = 0xffffffff;                    // Marks a node whose result has not been computed.
+
+    std::vector<Node> m_Nodes;                                              // Node pool, nodes 0 and 1 are the dead and live cells.
+    std::vector<juce::uint32> m_Buckets;                                    // Hash buckets used to canonicalise nodes.
+    std::vector<juce::uint32> m_EmptyNodes;                                 // Empty node of each level, created on demand.
+
+    juce::uint32 m_Root = 0;                                                // Root node, centred on the origin.
+    int m_MaxNodes = Variables::hashLifeMaxNodes;                           // Number of nodes above which unreachable nodes are collected.
+    int m_StepLog = 0;                                                      // Results of nodes above level m_StepLog + 2 advance 2^m_StepLog generations.
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HashLife)
+};
@@ -5,10 +5,30 @@
 
 #include "Oscillator.h"
 #include "Panner.h"
+#include "ControlValue.h"
+#include "SineKernels.h"
+#include "RenderPool.h"
+#include "OscillatorBank.h"
+#include "SpectralSynthesis.h"
 
-#include "Cell.h"
+#include "AllocationTrap.h"
+#include "TripleBuffer.h"
+#include "Profiler.h"
+#include "CellPlane.h"
+#include "GridSnapshot.h"
+
+#include "WorkerPool.h"
+
+#include "BitGrid.h"
+#include "HashLife.h"
 #include "Grid.h"
 
+#include "FadeKernel.h"
+#include "StateVariableFilter.h"
+#include "Saturator.h"
+#include "FDNReverb.h"
+#include "ConvolutionReverb.h"
+#include "TruePeakLimiter.h"
 #include "Synthesis.h"
 
 #include "PluginProcessor.h"
@@ -123,36 +123,12 @@ void Oscillator::processBlock()
 
 SineOscillator::SineOscillator() {}
 
-/**
-    Outputs the sample value for the current phase based on sine wave algorithm.
-    @param phase Phase to use.
- */
-
-float SineOscillator::output (float phase)
-{
-    return std::sin(2.0f * phase * M_PI);
-}
-
 
 //================================================//
 // Square wave oscillator.
 
 SquareOscillator::SquareOscillator() {}
 
-/**
-    Outputs the sample value for the current phase based on square wave algorithm.
-    @param phase Phase to use.
- */
-
-float SquareOscillator::output (float phase)
-{
-    if (phase < 0.5f)
-        return 1.0f;
-    
-    else
-        return -1.0f;
-}
-
 
 //================================================//
 // Pulse wave oscillator.
@@ -172,61 +148,13 @@ void PulseOscillator::setPulseWidth (float pulseWidth)              { m_PulseWid
 float PulseOscillator::getPulseWidth()                              { return m_PulseWidth; }
 
 
-//================================================//
-// DSP methods.
-
-/**
-    Outputs the sample value for the current phase based on pulse wave algorithm.
-    @param phase Phase to use.
- */
-
-float PulseOscillator::output (float phase)
-{
-    if (phase < m_PulseWidth)
-        return 1.0f;
-    
-    else
-        return -1.0f;
-}
-
-
 //================================================//
 // Triangle wave oscillator.
 
 TriangleOscillator::TriangleOscillator() {}
 
 
-//================================================//
-// DSP methods.
-
-/**
-    Outputs the sample value for the current phase based on triangle wave algorithm.
-    @param phase Phase to use.
- */
-
-float TriangleOscillator::output (float phase)
-{
-    // Algorithm used to compute triangle wave in range [-1,1] --> https://wikimedia.org/api/rest_v1/media/math/render/svg/bc9fd743afd5943b7f83248e59d55d97119257b9
-    return 2.0f * std::fabs(2.0f * (phase - std::floor(phase + 0.5f))) - 1.0f;
-}
-
-
 //================================================//
 // Sawtooth wave oscillator.
 
 SawtoothOscillator::SawtoothOscillator() {}
-
-
-//================================================//
-// DSP methods.
-
-/**
-    Outputs the sample value for the current phase based on sawtooth wave algorithm.
-    @param phase Phase to use.
- */
-
-float SawtoothOscillator::output (float phase)
-{
-    // Algorithm used to compute sawtooth wave in range [-1,1] --> https://wikimedia.org/api/rest_v1/media/math/render/svg/0f07cb8c8f5850b17ad8c3415800046cd1f38967
-    return 2.0f * (phase - std::floor(0.5f + phase));
-}
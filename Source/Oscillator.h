@@ -51,15 +51,81 @@ private:
 
 
 //================================================//
-/// Square wave oscillator class.
+/// Oscillator whose waveform is known at compile time through CRTP.
+/// Derived classes provide an inline getSample (float phase), so whole blocks are rendered
+/// without a virtual call per sample and the compiler can inline the waveform into the loop.
 
-class SineOscillator : public Oscillator
+template <typename Derived>
+class BlockOscillator : public Oscillator
+{
+public:
+    BlockOscillator() {}
+    
+    // DSP methods.
+    
+    /**
+        Returns the sample value for a phase, forwarded to the derived waveform.
+        @param phase Phase to use.
+     */
+    
+    float output (float phase) override
+    {
+        return static_cast<Derived*> (this)->getSample (phase);
+    }
+    
+    /**
+        Renders a block of samples into a caller-provided buffer and updates the phase.
+        @param destination Buffer receiving numSamples samples.
+        @param numSamples Number of samples to render.
+        @param frequencyModulation Optional per-sample frequency offsets in Hz, or nullptr.
+     */
+    
+    void renderBlock (float* destination, int numSamples, const float* frequencyModulation = nullptr)
+    {
+        Derived& waveform = *static_cast<Derived*> (this);
+        
+        float phase = getPhase();
+        const float frequency = getFrequency();
+        const float sampleRate = getSampleRate();
+        const float phaseDelta = getPhaseDelta();
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            destination[i] = waveform.getSample (phase);
+            
+            phase += frequencyModulation != nullptr ? (frequency + frequencyModulation[i]) / sampleRate : phaseDelta;
+            
+            if (phase > 1.0f)
+                phase -= 1.0f;
+        }
+        
+        setPhase (phase);
+    }
+    
+private:
+    JUCE_DECLARE_NON_COPYABLE (BlockOscillator)
+};
+
+
+//================================================//
+/// Sine wave oscillator class.
+
+class SineOscillator : public BlockOscillator<SineOscillator>
 {
 public:
     SineOscillator();
     
     // DSP methods.
-    float output (float phase) override;
+    
+    /**
+        Returns the sample value for the current phase based on sine wave algorithm.
+        @param phase Phase to use.
+     */
+    
+    float getSample (float phase) const
+    {
+        return (float) std::sin (2.0f * phase * M_PI);
+    }
     
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SineOscillator)
@@ -69,13 +135,22 @@ private:
 //================================================//
 /// Square wave oscillator class.
 
-class SquareOscillator : public Oscillator
+class SquareOscillator : public BlockOscillator<SquareOscillator>
 {
 public:
     SquareOscillator();
     
     // DSP methods.
-    float output (float phase) override;
+    
+    /**
+        Returns the sample value for the current phase based on square wave algorithm.
+        @param phase Phase to use.
+     */
+    
+    float getSample (float phase) const
+    {
+        return phase < 0.5f ? 1.0f : -1.0f;
+    }
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SquareOscillator)
@@ -85,7 +160,7 @@ private:
 //================================================//
 /// Pulse wave oscillator class.
 
-class PulseOscillator : public Oscillator
+class PulseOscillator : public BlockOscillator<PulseOscillator>
 {
 public:
     PulseOscillator();
@@ -97,7 +172,16 @@ public:
     float getPulseWidth();
     
     // DSP methods.
-    float output (float phase) override;
+    
+    /**
+        Returns the sample value for the current phase based on pulse wave algorithm.
+        @param phase Phase to use.
+     */
+    
+    float getSample (float phase) const
+    {
+        return phase < m_PulseWidth ? 1.0f : -1.0f;
+    }
     
 private:
     float m_PulseWidth = 0.5f;
@@ -109,13 +193,23 @@ private:
 //================================================//
 /// Triangle wave oscillator class.
 
-class TriangleOscillator : public Oscillator
+class TriangleOscillator : public BlockOscillator<TriangleOscillator>
 {
 public:
     TriangleOscillator();
     
     // DSP methods.
-    float output (float phase) override;
+    
+    /**
+        Returns the sample value for the current phase based on triangle wave algorithm.
+        @param phase Phase to use.
+     */
+    
+    float getSample (float phase) const
+    {
+        // Algorithm used to compute triangle wave in range [-1,1] --> https://wikimedia.org/api/rest_v1/media/math/render/svg/bc9fd743afd5943b7f83248e59d55d97119257b9
+        return 2.0f * std::fabs (2.0f * (phase - std::floor (phase + 0.5f))) - 1.0f;
+    }
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TriangleOscillator)
@@ -125,13 +219,23 @@ private:
 //================================================//
 /// Sawtooth wave oscillator class.
 
-class SawtoothOscillator : public Oscillator
+class SawtoothOscillator : public BlockOscillator<SawtoothOscillator>
 {
 public:
     SawtoothOscillator();
     
     // DSP methods.
-    float output (float phase) override;
+    
+    /**
+        Returns the sample value for the current phase based on sawtooth wave algorithm.
+        @param phase Phase to use.
+     */
+    
+    float getSample (float phase) const
+    {
+        // Algorithm used to compute sawtooth wave in range [-1,1] --> https://wikimedia.org/api/rest_v1/media/math/render/svg/0f07cb8c8f5850b17ad8c3415800046cd1f38967
+        return 2.0f * (phase - std::floor (0.5f + phase));
+    }
     
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SawtoothOscillator)
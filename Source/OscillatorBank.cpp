@@ -0,0 +1,608 @@
+#include "Headers.h"
+
+
+//================================================//
+// Bank of sine partials rendered a SIMD register at a time.
+
+OscillatorBank::OscillatorBank() {}
+
+OscillatorBank::~OscillatorBank() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Allocates storage for a number of partials and resets them to silence.
+    @param numPartials Number of partials.
+    @param sampleRate Sample rate to use.
+    @param blockSize Largest number of samples rendered at once.
+    @param numPartitions Number of partitions rendered concurrently, at most one per register.
+ */
+
+void OscillatorBank::prepareToPlay (int numPartials, float sampleRate, int blockSize, int numPartitions)
+{
+    const int numLanes = (int) Register::SIMDNumElements;
+    
+    m_NumPartials = numPartials;
+    m_NumPaddedPartials = (numPartials + numLanes - 1) / numLanes * numLanes;
+    m_NumPartitions = juce::jlimit (1, juce::jmax (1, m_NumPaddedPartials / numLanes), numPartitions);
+    m_BlockSize = blockSize;
+    m_SampleRate = sampleRate;
+    m_OnePoleCoefficient = 1.0f - std::exp (-1.0f / (Variables::onePoleSmoothingTime * sampleRate));
+    
+    SineKernels::prepareWavetable();
+    
+    // Padding partials stay silent, with zero frequency and gain.
+    m_Storage.calloc ((size_t) (numFields * m_NumPaddedPartials + numLanes));
+    m_Fields = Register::getNextSIMDAlignedPtr (m_Storage.get());
+    m_Modulators.calloc ((size_t) m_NumPaddedPartials);
+    
+    // Partials start centred.
+    for (int field : { leftGains, leftGainTargets, rightGains, rightGainTargets })
+        std::fill (getField (field), getField (field) + m_NumPaddedPartials, 1.0f);
+    
+    // Each partition gets frames of its own, so partitions never write to the same memory.
+    const int framesSize = blockSize * numLanes;
+    
+    m_ScratchStorage.calloc ((size_t) (4 * framesSize * m_NumPartitions + numLanes));
+    m_Frames.calloc ((size_t) m_NumPartitions);
+    
+    float* scratch = Register::getNextSIMDAlignedPtr (m_ScratchStorage.get());
+    
+    for (int partition = 0; partition < m_NumPartitions; ++partition)
+    {
+        m_Frames[partition].modulation = scratch + (4 * partition) * framesSize;
+        m_Frames[partition].decay = scratch + (4 * partition + 1) * framesSize;
+        m_Frames[partition].left = scratch + (4 * partition + 2) * framesSize;
+        m_Frames[partition].right = scratch + (4 * partition + 3) * framesSize;
+    }
+}
+
+
+//================================================//
+// Setter methods.
+
+void OscillatorBank::setFrequency (int partial, float frequency)    { getField (frequencies)[partial] = frequency; }
+
+/**
+    Sets the sine implementation used to render partials. Can be called from any thread,
+    and takes effect from the next render call.
+    @param sineKernel Sine implementation to use.
+ */
+
+void OscillatorBank::setSineKernel (SineKernels::Type sineKernel)
+{
+    m_SineKernel.store (sineKernel, std::memory_order_relaxed);
+}
+
+/**
+    Sets how a partial's frequency is modulated.
+    @param partial Index of the partial.
+    @param modulatorIndex Index of the modulation source passed to render.
+    @param depth Frequency offset in Hz for a modulation value of 1.
+ */
+
+void OscillatorBank::setModulation (int partial, int modulatorIndex, float depth)
+{
+    m_Modulators[partial] = modulatorIndex;
+    getField (depths)[partial] = depth;
+}
+
+/**
+    Sets the gain and pan a partial reaches at the end of the next render call.
+    Partials are panned with the same law as Panner.
+    @param partial Index of the partial.
+    @param gain Gain to reach.
+    @param pan Pan to reach, in range [-1,1].
+ */
+
+void OscillatorBank::setTargets (int partial, float gain, float pan)
+{
+    getField (gainTargets)[partial] = gain;
+    getField (panTargets)[partial] = pan;
+    
+    // Negative pans turn the right channel down, positive pans the left one.
+    getField (leftGainTargets)[partial] = 1.0f - juce::jmax (pan, 0.0f);
+    getField (rightGainTargets)[partial] = 1.0f + juce::jmin (pan, 0.0f);
+}
+
+/**
+    Makes the amplitude of every partial fall with its frequency, as pink noise does. The amplitude
+    becomes the gain squared, times the reference over the partial's frequency including its modulation.
+    @param referenceFrequency Frequency at which a partial's amplitude is its gain squared, or 0 to use the gain as is.
+ */
+
+void OscillatorBank::setGainDecay (float referenceFrequency)
+{
+    m_GainDecayReference = referenceFrequency;
+}
+
+/**
+    Sets whether each pan also applies to every partial before it, as when the original 16 oscillators
+    were panned one after another. Early partials then get quieter the more partials there are,
+    so this is only meant to reproduce that mix.
+    @param useCumulativePanning True to apply each pan to every earlier partial too.
+ */
+
+void OscillatorBank::setCumulativePanning (bool useCumulativePanning)
+{
+    m_UseCumulativePanning = useCumulativePanning;
+}
+
+
+//================================================//
+// Getter methods.
+
+int OscillatorBank::getNumPartials()                                { return m_NumPartials; }
+int OscillatorBank::getNumPartitions()                              { return m_NumPartitions; }
+float OscillatorBank::getFrequency (int partial)                    { return getField (frequencies)[partial]; }
+SineKernels::Type OscillatorBank::getSineKernel()                   { return m_SineKernel.load (std::memory_order_relaxed); }
+bool OscillatorBank::isSilent()                                     { return m_IsSilent; }
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Renders every partial and adds the result to a stereo pair of buffers.
+    Gains and pan gains ramp linearly to their targets across the call, or ease towards them
+    when one-pole smoothing is enabled.
+    @param left Left channel, numSamples samples are added to it.
+    @param right Right channel, numSamples samples are added to it.
+    @param numSamples Number of samples, at most the block size given to prepareToPlay.
+    @param modulators Modulation sources, each holding numSamples values.
+    @param pool Pool sharing the partitions across threads, or nullptr to render them all here.
+ */
+
+void OscillatorBank::render (float* left, float* right, int numSamples, const float* const* modulators, RenderPool* pool)
+{
+    jassert (numSamples <= m_BlockSize);
+    
+    const int numLanes = (int) Register::SIMDNumElements;
+    
+    m_RenderNumSamples = numSamples;
+    m_RenderModulators = modulators;
+    m_RenderSineKernel = getSineKernel();
+    
+    if (m_UseCumulativePanning)
+        updateCumulativePanGains();
+    
+    if (pool != nullptr)
+        pool->run (*this, m_NumPartitions);
+    
+    else
+        for (int partition = 0; partition < m_NumPartitions; ++partition)
+            processTask (partition);
+    
+    // Partitions are summed in a fixed order, so the result doesn't depend on which thread rendered what.
+    m_IsSilent = true;
+    
+    for (int partition = 0; partition < m_NumPartitions; ++partition)
+    {
+        const Frames& frames = m_Frames[partition];
+        
+        if (frames.numRendered == 0)
+            continue;
+        
+        m_IsSilent = false;
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                left[i] += frames.left[i * numLanes + lane];
+                right[i] += frames.right[i * numLanes + lane];
+            }
+        }
+    }
+}
+
+
+//================================================//
+// RenderPool::Job methods.
+
+/**
+    Renders the registers of one partition into its own frames.
+    Called by render, possibly from a render worker thread.
+    @param partition Index of the partition.
+ */
+
+void OscillatorBank::processTask (int partition)
+{
+    const int numLanes = (int) Register::SIMDNumElements;
+    const int numRegisters = m_NumPaddedPartials / numLanes;
+    const int numSamples = m_RenderNumSamples;
+    Frames& frames = m_Frames[partition];
+    
+    frames.numRendered = 0;
+    
+    int end = (partition + 1) * numRegisters / m_NumPartitions * numLanes;
+    
+    for (int first = partition * numRegisters / m_NumPartitions * numLanes; first < end; first += numLanes)
+    {
+        if (isRegisterSilent (first))
+        {
+            skipRegister (first, numSamples);
+            continue;
+        }
+        
+        // Frames are only cleared once something is rendered into them.
+        if (frames.numRendered++ == 0)
+        {
+            std::fill (frames.left, frames.left + numSamples * numLanes, 0.0f);
+            std::fill (frames.right, frames.right + numSamples * numLanes, 0.0f);
+        }
+        
+        // Gathers the modulation of each lane once, so the sample loop only does aligned loads.
+        for (int i = 0; i < numSamples; ++i)
+            for (int lane = 0; lane < numLanes; ++lane)
+                frames.modulation[i * numLanes + lane] = m_RenderModulators[m_Modulators[first + lane]][i];
+        
+        // The decay follows the modulated frequency. Padding partials have no frequency and no gain.
+        if (m_GainDecayReference > 0.0f)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    float frequency = getField (frequencies)[first + lane] + getField (depths)[first + lane] * frames.modulation[i * numLanes + lane];
+                    frames.decay[i * numLanes + lane] = frequency > 0.0f ? m_GainDecayReference * (1.0f / frequency) : 0.0f;
+                }
+            }
+        }
+        
+        switch (m_RenderSineKernel)
+        {
+            case SineKernels::Type::standard:   renderRegister<SineKernels::Type::standard> (first, numSamples, frames);    break;
+            case SineKernels::Type::wavetable:  renderRegister<SineKernels::Type::wavetable> (first, numSamples, frames);   break;
+            case SineKernels::Type::polynomial: renderRegister<SineKernels::Type::polynomial> (first, numSamples, frames);  break;
+            case SineKernels::Type::phasor:     renderRegister<SineKernels::Type::phasor> (first, numSamples, frames);      break;
+        }
+    }
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Renders one register of partials into the mix frames of a partition, using a sine
+    implementation chosen at compile time so the sample loop has no dispatch in it.
+    @param first First partial of the register.
+    @param numSamples Number of samples.
+    @param frames Frames of the partition the register belongs to.
+ */
+
+template <SineKernels::Type kernel>
+void OscillatorBank::renderRegister (int first, int numSamples, const Frames& frames)
+{
+    const int numLanes = (int) Register::SIMDNumElements;
+    const bool useOnePole = Variables::useOnePoleSmoothing;
+    const bool useGainDecay = m_GainDecayReference > 0.0f;
+    
+    const Register one = Register::expand (1.0f);
+    const Register inverseSampleRate = Register::expand (1.0f / m_SampleRate);
+    const Register rampScale = Register::expand (numSamples > 0 ? 1.0f / (float) numSamples : 0.0f);
+    const Register onePoleCoefficient = Register::expand (m_OnePoleCoefficient);
+    
+    Register phase = Register::fromRawArray (getField (phases) + first);
+    Register frequency = Register::fromRawArray (getField (frequencies) + first);
+    Register depth = Register::fromRawArray (getField (depths) + first);
+    Register gain = Register::fromRawArray (getField (gains) + first);
+    Register gainTarget = Register::fromRawArray (getField (gainTargets) + first);
+    Register gainStep = (gainTarget - gain) * rampScale;
+    Register leftGain = Register::fromRawArray (getField (leftGains) + first);
+    Register leftGainTarget = Register::fromRawArray (getField (leftGainTargets) + first);
+    Register leftGainStep = (leftGainTarget - leftGain) * rampScale;
+    Register rightGain = Register::fromRawArray (getField (rightGains) + first);
+    Register rightGainTarget = Register::fromRawArray (getField (rightGainTargets) + first);
+    Register rightGainStep = (rightGainTarget - rightGain) * rampScale;
+    
+    // The phasor restarts from the stored phase on every call, so its rounding errors never build up.
+    // Its rotation is worked out once per call: the increment is fitted with a line through the means
+    // of both halves of the call, so the phasor follows linear modulation exactly and ends the call on
+    // the same phase as the other kernels, with a rotation that itself rotates by a fixed step.
+    Register phasorSine = SineKernels::getPolynomial (phase);
+    Register quarterPhase = phase + 0.25f;
+    Register phasorCosine = SineKernels::getPolynomial (quarterPhase - (one & Register::greaterThan (quarterPhase, one)));
+    Register rotationCosine, rotationSine, chirpCosine, chirpSine;
+    
+    if (kernel == SineKernels::Type::phasor)
+    {
+        const int numFirstHalf = numSamples / 2;
+        Register firstHalfSum = Register::expand (0.0f);
+        Register secondHalfSum = Register::expand (0.0f);
+        
+        for (int i = 0; i < numFirstHalf; ++i)
+            firstHalfSum += Register::fromRawArray (frames.modulation + i * numLanes);
+        
+        for (int i = numFirstHalf; i < numSamples; ++i)
+            secondHalfSum += Register::fromRawArray (frames.modulation + i * numLanes);
+        
+        Register meanModulation = (firstHalfSum + secondHalfSum) * rampScale;
+        Register modulationSlope = Register::expand (0.0f);
+        
+        // The centres of both halves are numSamples / 2 samples apart.
+        if (numFirstHalf > 0)
+            modulationSlope = (secondHalfSum * (1.0f / (float) (numSamples - numFirstHalf)) - firstHalfSum * (1.0f / (float) numFirstHalf)) * (2.0f / (float) numSamples);
+        
+        Register incrementSlope = depth * modulationSlope * inverseSampleRate;
+        Register firstIncrement = (frequency + depth * meanModulation) * inverseSampleRate - incrementSlope * (0.5f * (float) (numSamples - 1));
+        
+        SineKernels::getRotation (firstIncrement * juce::MathConstants<float>::twoPi, rotationCosine, rotationSine);
+        SineKernels::getRotation (incrementSlope * juce::MathConstants<float>::twoPi, chirpCosine, chirpSine);
+    }
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        Register sine;
+        
+        if (kernel == SineKernels::Type::standard)
+            sine = SineKernels::getStandard (phase);
+        
+        else if (kernel == SineKernels::Type::wavetable)
+            sine = SineKernels::getWavetable (phase);
+        
+        else if (kernel == SineKernels::Type::polynomial)
+            sine = SineKernels::getPolynomial (phase);
+        
+        else
+            sine = phasorSine;
+        
+        Register sample = sine * gain;
+        
+        if (useGainDecay)
+            sample *= gain * Register::fromRawArray (frames.decay + i * numLanes);
+        
+        Register leftFrame = Register::fromRawArray (frames.left + i * numLanes) + sample * leftGain;
+        Register rightFrame = Register::fromRawArray (frames.right + i * numLanes) + sample * rightGain;
+        leftFrame.copyToRawArray (frames.left + i * numLanes);
+        rightFrame.copyToRawArray (frames.right + i * numLanes);
+        
+        // Frequency modulation, then the phase wraps back into [0,1].
+        Register modulation = Register::fromRawArray (frames.modulation + i * numLanes);
+        Register increment = (frequency + depth * modulation) * inverseSampleRate;
+        
+        if (kernel == SineKernels::Type::phasor)
+        {
+            Register nextSine = phasorSine * rotationCosine + phasorCosine * rotationSine;
+            phasorCosine = phasorCosine * rotationCosine - phasorSine * rotationSine;
+            phasorSine = nextSine;
+            
+            Register nextRotationSine = rotationSine * chirpCosine + rotationCosine * chirpSine;
+            rotationCosine = rotationCosine * chirpCosine - rotationSine * chirpSine;
+            rotationSine = nextRotationSine;
+        }
+        
+        phase += increment;
+        phase -= one & Register::greaterThan (phase, one);
+        
+        if (useOnePole)
+        {
+            gain += (gainTarget - gain) * onePoleCoefficient;
+            leftGain += (leftGainTarget - leftGain) * onePoleCoefficient;
+            rightGain += (rightGainTarget - rightGain) * onePoleCoefficient;
+        }
+        
+        else
+        {
+            gain += gainStep;
+            leftGain += leftGainStep;
+            rightGain += rightGainStep;
+        }
+    }
+    
+    // Linear ramps end exactly on their targets so rounding errors don't build up.
+    phase.copyToRawArray (getField (phases) + first);
+    (useOnePole ? gain : gainTarget).copyToRawArray (getField (gains) + first);
+    (useOnePole ? leftGain : leftGainTarget).copyToRawArray (getField (leftGains) + first);
+    (useOnePole ? rightGain : rightGainTarget).copyToRawArray (getField (rightGains) + first);
+}
+
+/**
+    Replaces the pan gain targets with the product of each partial's own pan law and those of every
+    later partial, as when oscillators were panned one after another, each pan applying to the whole
+    mix so far. Only the targets are multiplied, once per render call, and the render loop ramps them
+    like any other pan gains. Culled partials still pan the ones before them.
+ */
+
+void OscillatorBank::updateCumulativePanGains()
+{
+    float leftGain = 1.0f;
+    float rightGain = 1.0f;
+    
+    for (int partial = m_NumPaddedPartials - 1; partial >= 0; --partial)
+    {
+        float pan = getField (panTargets)[partial];
+        
+        leftGain *= 1.0f - juce::jmax (pan, 0.0f);
+        rightGain *= 1.0f + juce::jmin (pan, 0.0f);
+        
+        getField (leftGainTargets)[partial] = leftGain;
+        getField (rightGainTargets)[partial] = rightGain;
+    }
+}
+
+/**
+    Returns true if every partial of a register stays below the silence threshold
+    for the whole of the next render call.
+    @param first First partial of the register.
+ */
+
+bool OscillatorBank::isRegisterSilent (int first)
+{
+    const float* registerGains = getField (gains) + first;
+    const float* registerGainTargets = getField (gainTargets) + first;
+    
+    for (int lane = 0; lane < (int) Register::SIMDNumElements; ++lane)
+        if (std::abs (registerGains[lane]) >= Variables::silenceThreshold || std::abs (registerGainTargets[lane]) >= Variables::silenceThreshold)
+            return false;
+    
+    return true;
+}
+
+/**
+    Moves a culled register to where rendering it would have left it. Phases advance by the
+    integral of their frequency, so the partials come back in without a discontinuity.
+    @param first First partial of the register.
+    @param numSamples Number of samples.
+ */
+
+void OscillatorBank::skipRegister (int first, int numSamples)
+{
+    for (int partial = first; partial < first + (int) Register::SIMDNumElements; ++partial)
+    {
+        const float* modulator = m_RenderModulators[m_Modulators[partial]];
+        float modulationSum = 0.0f;
+        
+        for (int i = 0; i < numSamples; ++i)
+            modulationSum += modulator[i];
+        
+        float phase = getField (phases)[partial];
+        phase += (getField (frequencies)[partial] * (float) numSamples + getField (depths)[partial] * modulationSum) / m_SampleRate;
+        
+        getField (phases)[partial] = phase - std::floor (phase);
+        getField (gains)[partial] = getField (gainTargets)[partial];
+        getField (leftGains)[partial] = getField (leftGainTargets)[partial];
+        getField (rightGains)[partial] = getField (rightGainTargets)[partial];
+    }
+}
+
+/**
+    Returns the first partial of a field.
+    @param fieldIndex Field to return.
+ */
+
+float* OscillatorBank::getField (int fieldIndex)
+{
+    return m_Fields + fieldIndex * m_NumPaddedPartials;
+}
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS
+
+/// Checks the bank against partials rendered and panned one after another, with each pan law applied
+/// to its own partial, or cumulatively to every partial before it too, the way Synthesis mixed them before the bank.
+
+class OscillatorBankTests : public juce::UnitTest
+{
+public:
+    OscillatorBankTests() : juce::UnitTest ("OscillatorBank", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        const int numPartials = 11;
+        const int blockSize = 64;
+        const float sampleRate = 44100.0f;
+        const float referenceFrequency = 110.0f;
+        
+        juce::Random random (0x0b4c);
+        
+        for (bool useCumulativePanning : { false, true })
+        {
+            for (int numPartitions : { 1, 3 })
+            {
+                beginTest (juce::String (useCumulativePanning ? "Cumulative" : "Separate") + " pans match partials mixed one after another, "
+                           + juce::String (numPartitions) + " partitions");
+                
+                OscillatorBank bank;
+                bank.prepareToPlay (numPartials, sampleRate, blockSize, numPartitions);
+                bank.setSineKernel (SineKernels::Type::standard);
+                bank.setGainDecay (referenceFrequency);
+                bank.setCumulativePanning (useCumulativePanning);
+                
+                float phases[numPartials] = {};
+                float frequencies[numPartials];
+                float depths[numPartials];
+                ControlValue gains[numPartials];
+                ControlValue leftGains[numPartials];
+                ControlValue rightGains[numPartials];
+                
+                for (int partial = 0; partial < numPartials; ++partial)
+                {
+                    frequencies[partial] = 100.0f + 2000.0f * random.nextFloat();
+                    depths[partial] = frequencies[partial] / (float) ((partial + 1) * 5);
+                    gains[partial].prepareToPlay (sampleRate, 0.0f);
+                    leftGains[partial].prepareToPlay (sampleRate, 1.0f);
+                    rightGains[partial].prepareToPlay (sampleRate, 1.0f);
+                    
+                    bank.setFrequency (partial, frequencies[partial]);
+                    bank.setModulation (partial, partial, depths[partial]);
+                }
+                
+                juce::AudioBuffer<float> modulation (numPartials, blockSize);
+                juce::AudioBuffer<float> expected (2, blockSize);
+                juce::AudioBuffer<float> rendered (2, blockSize);
+                const float* modulators[numPartials];
+                
+                for (int partial = 0; partial < numPartials; ++partial)
+                    modulators[partial] = modulation.getReadPointer (partial);
+                
+                float maxError = 0.0f;
+                
+                for (int block = 0; block < 8; ++block)
+                {
+                    float leftGain = 1.0f;
+                    float rightGain = 1.0f;
+                    
+                    // Pans are drawn from the last partial down, so cumulative pan gains can be built up as they are.
+                    for (int partial = numPartials - 1; partial >= 0; --partial)
+                    {
+                        for (int i = 0; i < blockSize; ++i)
+                            modulation.setSample (partial, i, 2.0f * random.nextFloat() - 1.0f);
+                        
+                        // Partials 4 to 7 start silent, so their register is culled while they may still pan the partials before them.
+                        float gain = partial >= 4 && partial < 8 && block < 4 ? 0.0f : random.nextFloat();
+                        float pan = 2.0f * random.nextFloat() - 1.0f;
+                        
+                        if (! useCumulativePanning)
+                            leftGain = rightGain = 1.0f;
+                        
+                        leftGain *= 1.0f - juce::jmax (pan, 0.0f);
+                        rightGain *= 1.0f + juce::jmin (pan, 0.0f);
+                        
+                        bank.setTargets (partial, gain, pan);
+                        gains[partial].setTarget (gain, blockSize);
+                        leftGains[partial].setTarget (leftGain, blockSize);
+                        rightGains[partial].setTarget (rightGain, blockSize);
+                    }
+                    
+                    expected.clear();
+                    rendered.clear();
+                    
+                    for (int partial = 0; partial < numPartials; ++partial)
+                    {
+                        for (int i = 0; i < blockSize; ++i)
+                        {
+                            float frequency = frequencies[partial] + depths[partial] * modulation.getSample (partial, i);
+                            float gain = gains[partial].getNextValue();
+                            float sample = std::sin (juce::MathConstants<float>::twoPi * phases[partial]) * gain * gain * referenceFrequency / frequency;
+                            
+                            phases[partial] += frequency / sampleRate;
+                            phases[partial] -= std::floor (phases[partial]);
+                            
+                            expected.setSample (0, i, expected.getSample (0, i) + sample * leftGains[partial].getNextValue());
+                            expected.setSample (1, i, expected.getSample (1, i) + sample * rightGains[partial].getNextValue());
+                        }
+                    }
+                    
+                    bank.render (rendered.getWritePointer (0), rendered.getWritePointer (1), blockSize, modulators);
+                    
+                    for (int channel = 0; channel < 2; ++channel)
+                        for (int i = 0; i < blockSize; ++i)
+                            maxError = juce::jmax (maxError, std::abs (rendered.getSample (channel, i) - expected.getSample (channel, i)));
+                }
+                
+                expectLessThan (maxError, 1.0e-4f, "Bank output differs from the partials mixed one after another");
+            }
+        }
+    }
+};
+
+static OscillatorBankTests oscillatorBankTests;
+
+#endif
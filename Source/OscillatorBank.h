@@ -0,0 +1,103 @@
+#pragma once
+
+
+//================================================//
+/// Bank of sine partials stored as structure-of-arrays and rendered a SIMD register of partials at a time.
+/// Each partial has a frequency, a frequency modulation source and depth, and a gain and pair of pan gains
+/// which move towards new targets over each render call. Partials are mixed straight into a stereo pair,
+/// each panned by its own pan law, or optionally by its own and those of every later partial, the way
+/// the original oscillators were panned one after another.
+/// Registers are split into partitions with their own scratch frames, which can be rendered
+/// concurrently by a RenderPool. Registers whose partials are all below Variables::silenceThreshold
+/// are culled: they are not rendered, and only their phases move on.
+
+class OscillatorBank : private RenderPool::Job
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    
+    OscillatorBank();
+    ~OscillatorBank();
+    
+    // Init methods.
+    void prepareToPlay (int numPartials, float sampleRate, int blockSize, int numPartitions = 1);
+    
+    // Setter methods.
+    void setFrequency (int partial, float frequency);
+    void setModulation (int partial, int modulatorIndex, float depth);
+    void setTargets (int partial, float gain, float pan);
+    void setGainDecay (float referenceFrequency);
+    void setCumulativePanning (bool useCumulativePanning);
+    void setSineKernel (SineKernels::Type sineKernel);
+    
+    // Getter methods.
+    int getNumPartials();
+    int getNumPartitions();
+    float getFrequency (int partial);
+    SineKernels::Type getSineKernel();
+    bool isSilent();
+    
+    // DSP methods.
+    void render (float* left, float* right, int numSamples, const float* const* modulators, RenderPool* pool = nullptr);
+
+private:
+    /// Scratch frames of a partition, each holding one register per sample.
+    struct Frames
+    {
+        float* modulation;                                                  // Modulation of the register being rendered.
+        float* decay;                                                       // Gain decay of the register being rendered.
+        float* left;                                                        // Left mix of the partition.
+        float* right;                                                       // Right mix of the partition.
+        int numRendered;                                                    // Registers rendered into the frames by the last render call.
+    };
+    
+    // RenderPool::Job methods.
+    void processTask (int partition) override;
+    
+    // Helper methods.
+    template <SineKernels::Type kernel>
+    void renderRegister (int first, int numSamples, const Frames& frames);
+    void updateCumulativePanGains();
+    bool isRegisterSilent (int first);
+    void skipRegister (int first, int numSamples);
+    float* getField (int fieldIndex);
+    
+    /// Per-partial values, each stored as one aligned array.
+    enum Field
+    {
+        phases,                                                             // Phase in range [0,1].
+        frequencies,                                                        // Frequency in Hz.
+        depths,                                                             // Frequency offset in Hz per unit of modulation.
+        gains,                                                              // Gain at the start of the next render call.
+        gainTargets,                                                        // Gain at the end of the next render call.
+        leftGains,                                                          // Left pan gain at the start of the next render call.
+        leftGainTargets,                                                    // Left pan gain at the end of the next render call.
+        rightGains,                                                         // Right pan gain at the start of the next render call.
+        rightGainTargets,                                                   // Right pan gain at the end of the next render call.
+        panTargets,                                                         // Pan at the end of the next render call.
+        numFields
+    };
+    
+    juce::HeapBlock<float> m_Storage;                                       // Storage for every field, plus room for alignment.
+    float* m_Fields = nullptr;                                              // First field, aligned for SIMD loads.
+    juce::HeapBlock<int> m_Modulators;                                      // Index of the modulation source of each partial.
+    float m_GainDecayReference = 0.0f;                                      // Frequency at which the gain decay is 1, or 0 for no decay.
+    bool m_UseCumulativePanning = false;                                    // Whether each pan also applies to every partial before it.
+    
+    juce::HeapBlock<float> m_ScratchStorage;                                // Storage for the scratch frames, plus room for alignment.
+    juce::HeapBlock<Frames> m_Frames;                                       // Scratch frames of each partition, summed when rendering ends.
+    int m_NumPartitions = 1;                                                // Number of partitions the registers are split into.
+    int m_RenderNumSamples = 0;                                             // Number of samples of the render call in progress.
+    const float* const* m_RenderModulators = nullptr;                       // Modulation sources of the render call in progress.
+    bool m_IsSilent = true;                                                 // True when every register was culled by the last render call.
+    
+    int m_NumPartials = 0;                                                  // Number of partials.
+    int m_NumPaddedPartials = 0;                                            // Number of partials rounded up to a whole register.
+    int m_BlockSize = 0;                                                    // Largest number of samples rendered at once.
+    float m_SampleRate = 44100.0f;                                          // Sample rate.
+    float m_OnePoleCoefficient = 1.0f;                                      // Fraction of the distance to the targets covered each sample with one-pole smoothing.
+    std::atomic<SineKernels::Type> m_SineKernel { SineKernels::Type::polynomial };     // Sine implementation used to render partials.
+    SineKernels::Type m_RenderSineKernel = SineKernels::Type::polynomial;   // Sine implementation of the render call in progress.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OscillatorBank)
+};
@@ -70,10 +70,10 @@ void Panner::processBlock (juce::AudioBuffer<float>& buffer)
 /**
     Adds panning to a given buffer.
     @param buffer Reference to an audio buffer which will be panned.
-    @param panValues Reference to an array of pan values to be applied on a per sample basis.
+    @param panValues Pan values to be applied on a per sample basis, one per sample of the buffer.
  */
 
-void Panner::processBlock (juce::AudioBuffer<float>& buffer, juce::Array<float>& panValues)
+void Panner::processBlock (juce::AudioBuffer<float>& buffer, const float* panValues)
 {
     if (buffer.getNumChannels() != 2)
         return;
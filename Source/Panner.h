@@ -21,7 +21,7 @@ public:
     
     // DSP methods.
     void processBlock (juce::AudioBuffer<float>& buffer);
-    void processBlock (juce::AudioBuffer<float>& buffer, juce::Array<float>& panValues);
+    void processBlock (juce::AudioBuffer<float>& buffer, const float* panValues);
     
     
 private:
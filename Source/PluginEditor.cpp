@@ -9,6 +9,7 @@ SoundOfLifeAudioProcessorEditor::SoundOfLifeAudioProcessorEditor (SoundOfLifeAud
         audioProcessor (audioProcessor)
 {
     setSize (Variables::windowWidth, Variables::windowHeight);
+    setWantsKeyboardFocus (true);
     startTimer (Variables::uiRefreshRate);
 }
 
@@ -20,45 +21,273 @@ SoundOfLifeAudioProcessorEditor::~SoundOfLifeAudioProcessorEditor() {}
 
 void SoundOfLifeAudioProcessorEditor::paint (juce::Graphics& graphics)
 {
-    Grid& grid = audioProcessor.getGrid();
+    // Latest state published by the audio thread. The lock only keeps prepareToPlay from resizing
+    // the snapshot while it is drawn, the audio thread publishes without ever taking it.
+    {
+        const juce::ScopedLock lock (audioProcessor.getSynthesis().getDisplayLock());
+        updateGridImage (audioProcessor.getSynthesis().getDisplaySnapshot());
+    }
     
-    float width = (float)Variables::windowWidth / (float)Variables::numRows;
-    float height = (float)Variables::windowHeight / (float)Variables::numColumns;
+    graphics.drawImageAt (m_GridImage, 0, 0);
     
-    juce::Colour colour;
+    if (m_ShowProfiler)
+        paintProfiler (graphics);
     
-    graphics.fillAll (juce::Colour (0, 0, 0));
+    paintLimiterMeter (graphics);
+}
+
+void SoundOfLifeAudioProcessorEditor::resized() {}
+
+/**
+    Inherited from juce::Component class.
+    P shows or hides the profiling overlay, C writes the profiling statistics to a CSV file,
+    O cycles the oversampling of the distortion through 2x, 4x and 8x, K cycles the sine implementation
+    of the oscillators, E cycles the grid engine,
+    and F fast-forwards the grid by 2^Variables::fastForwardLog generations, or fewer with engines other than HashLife.
+    @param key Key that was pressed.
+ */
+
+bool SoundOfLifeAudioProcessorEditor::keyPressed (const juce::KeyPress& key)
+{
+    if (key.getTextCharacter() == 'p' || key.getTextCharacter() == 'P')
+    {
+        m_ShowProfiler = ! m_ShowProfiler;
+        repaint();
+        return true;
+    }
     
-    for (int i = 0; i < Variables::numRows; i++)
+    if (key.getTextCharacter() == 'c' || key.getTextCharacter() == 'C')
     {
-        for (int j = 0; j < Variables::numColumns; j++)
+        writeProfilerCSV();
+        return true;
+    }
+    
+    if (key.getTextCharacter() == 'o' || key.getTextCharacter() == 'O')
+    {
+        int order = audioProcessor.getSynthesis().getSaturator().getOversamplingOrder();
+        audioProcessor.setOversamplingOrder (order % Saturator::maxOversamplingOrder + 1);
+        return true;
+    }
+    
+    if (key.getTextCharacter() == 'k' || key.getTextCharacter() == 'K')
+    {
+        OscillatorBank& bank = audioProcessor.getSynthesis().getOscillatorBank();
+        bank.setSineKernel ((SineKernels::Type) (((int) bank.getSineKernel() + 1) % SineKernels::numTypes));
+        return true;
+    }
+    
+    if (key.getTextCharacter() == 'e' || key.getTextCharacter() == 'E')
+    {
+        Grid& grid = audioProcessor.getGrid();
+        
+        if (grid.getEngine() == Grid::Engine::Cells)
+            grid.setEngine (Grid::Engine::Bitwise);
+        
+        else if (grid.getEngine() == Grid::Engine::Bitwise)
+            grid.setEngine (Grid::Engine::HashLife);
+        
+        else
+            grid.setEngine (Grid::Engine::Cells);
+        
+        return true;
+    }
+    
+    if (key.getTextCharacter() == 'f' || key.getTextCharacter() == 'F')
+    {
+        audioProcessor.getGrid().fastForward (Variables::fastForwardLog);
+        return true;
+    }
+    
+    return false;
+}
+
+
+//================================================//
+// Timer class methods.
+
+void SoundOfLifeAudioProcessorEditor::timerCallback()
+{
+    // Largest reduction since the last refresh, so short bursts of limiting aren't missed between two frames.
+    float gainReduction = audioProcessor.getSynthesis().getLimiter().getGainReduction();
+    m_GainReduction = juce::jmax (gainReduction, m_GainReduction - Variables::limiterMeterFalloff);
+    
+    repaint();
+}
+
+
+//================================================//
+// FileDragAndDropTarget class methods.
+
+/**
+    Inherited from juce::FileDragAndDropTarget class.
+    Accepts a single audio file, to be used as the impulse response of the convolution reverb.
+    @param files Paths of the files being dragged.
+ */
+
+bool SoundOfLifeAudioProcessorEditor::isInterestedInFileDrag (const juce::StringArray& files)
+{
+    return files.size() == 1 && juce::File (files[0]).hasFileExtension ("wav;aif;aiff;flac");
+}
+
+/**
+    Inherited from juce::FileDragAndDropTarget class.
+    Loads the dropped file into the convolution reverb, in the background.
+    @param files Paths of the dropped files.
+ */
+
+void SoundOfLifeAudioProcessorEditor::filesDropped (const juce::StringArray& files, int, int)
+{
+    audioProcessor.getSynthesis().getConvolutionReverb().loadImpulseResponse (juce::File (files[0]));
+}
+
+
+//================================================//
+// Drawing methods.
+
+/**
+    Draws the cells of a snapshot into the grid image, one pixel at a time, with rows
+    along x and columns along y. Each pixel shows the mean fade, or with Variables::useColour
+    off the share of live cells, of the cells it covers, or of the one cell covering it
+    when there are fewer cells than pixels. The image is only reallocated when the editor is resized.
+    @param snapshot Snapshot to draw.
+ */
+
+void SoundOfLifeAudioProcessorEditor::updateGridImage (const GridSnapshot& snapshot)
+{
+    int width = juce::jmax (1, getWidth());
+    int height = juce::jmax (1, getHeight());
+    
+    if (m_GridImage.isNull() || m_GridImage.getWidth() != width || m_GridImage.getHeight() != height)
+        m_GridImage = juce::Image (juce::Image::RGB, width, height, false);
+    
+    int numRows = snapshot.getNumRows();
+    int numColumns = snapshot.getNumColumns();
+    
+    juce::Image::BitmapData pixels (m_GridImage, juce::Image::BitmapData::writeOnly);
+    
+    for (int y = 0; y < height; ++y)
+    {
+        int startColumn = y * numColumns / height;
+        int endColumn = juce::jmax (startColumn + 1, (y + 1) * numColumns / height);
+        juce::uint8* pixel = pixels.getLinePointer (y);
+        
+        for (int x = 0; x < width; ++x, pixel += pixels.pixelStride)
         {
-            Cell& _cell = *grid.getCell (i, j);
-            
-            if (Variables::useColour)
-                colour = juce::Colour (255.0f, 255.0f, 255.0f, _cell.getFade());
+            int startRow = x * numRows / width;
+            int endRow = juce::jmax (startRow + 1, (x + 1) * numRows / width);
+            float level = 0.0f;
             
-            else
+            // Empty grids leave the image black.
+            for (int row = startRow; row < endRow && row < numRows; ++row)
             {
-                if (_cell.getIsAlive())
-                    colour = juce::Colours::white;
-                else
-                    colour = juce::Colours::black;
+                for (int column = startColumn; column < endColumn && column < numColumns; ++column)
+                {
+                    if (Variables::useColour)
+                        level += snapshot.getFade (row, column);
+                    else
+                        level += snapshot.getCellIsAlive (row, column) ? 1.0f : 0.0f;
+                }
             }
             
-            graphics.setColour(colour);
-            graphics.fillRect(i * width, j * height, width, height);
+            level /= (float) ((endRow - startRow) * (endColumn - startColumn));
+            
+            // Grey, so the order of the colour channels doesn't matter.
+            pixel[0] = pixel[1] = pixel[2] = (juce::uint8) juce::roundToInt (level * 255.0f);
         }
     }
 }
 
-void SoundOfLifeAudioProcessorEditor::resized() {}
+
+//================================================//
+// Profiling methods.
+
+/**
+    Draws the latest profiling statistics of the audio and grid threads over the grid,
+    one line per stage, relative to the deadline of each thread.
+    @param graphics Graphics context to draw with.
+ */
+
+void SoundOfLifeAudioProcessorEditor::paintProfiler (juce::Graphics& graphics)
+{
+    const Profiler::Stats* statsList[] = { &audioProcessor.getSynthesis().getProfiler().getStats(),
+                                           &audioProcessor.getGrid().getProfiler().getStats() };
+    
+    const int lineHeight = 16;
+    int y = 8;
+    
+    graphics.setColour (juce::Colours::black.withAlpha (0.75f));
+    graphics.fillRect (4, 4, 520, lineHeight * ((int) Profiler::Stage::numStages + 3) + 8);
+    graphics.setColour (juce::Colours::white);
+    graphics.setFont (juce::Font (juce::Font::getDefaultMonospacedFontName(), 12.0f, juce::Font::plain));
+    
+    for (const Profiler::Stats* stats : statsList)
+    {
+        graphics.drawText (juce::String::formatted ("%-16s %8s %8s %8s %8s  (deadline %.0f us, %.1f /s)", "stage, us", "min", "mean", "p99", "max",
+                                                    stats->deadline * 1.0e6, stats->duration > 0.0 ? stats->numTasks / stats->duration : 0.0),
+                           8, y, 512, lineHeight, juce::Justification::centredLeft);
+        y += lineHeight;
+        
+        for (int stageIndex = 0; stageIndex < (int) Profiler::Stage::numStages; ++stageIndex)
+        {
+            const Profiler::StageStats& stage = stats->stages[stageIndex];
+            
+            if (stage.count == 0)
+                continue;
+            
+            double p99 = Profiler::getPercentile (stage, stats->deadline, 0.99);
+            
+            // Stages which overran the deadline stand out.
+            graphics.setColour (stage.maximum > stats->deadline ? juce::Colours::red : juce::Colours::white);
+            graphics.drawText (juce::String::formatted ("%-16s %8.1f %8.1f %8.1f %8.1f  (p99 %.1f%%)", Profiler::getStageName ((Profiler::Stage) stageIndex),
+                                                        stage.minimum * 1.0e6, Profiler::getMean (stage) * 1.0e6, p99 * 1.0e6, stage.maximum * 1.0e6,
+                                                        100.0 * p99 / stats->deadline),
+                               8, y, 512, lineHeight, juce::Justification::centredLeft);
+            graphics.setColour (juce::Colours::white);
+            y += lineHeight;
+        }
+    }
+}
+
+/**
+    Writes the latest profiling statistics of the audio and grid threads to
+    SoundOfLifeProfile.csv in the user's documents folder, or shows a warning if the file can't be written.
+ */
+
+void SoundOfLifeAudioProcessorEditor::writeProfilerCSV()
+{
+    juce::String csv = Profiler::getCSVHeader();
+    csv << Profiler::toCSV (audioProcessor.getSynthesis().getProfiler().getStats());
+    csv << Profiler::toCSV (audioProcessor.getGrid().getProfiler().getStats());
+    
+    juce::File file = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory).getChildFile ("SoundOfLifeProfile.csv");
+    
+    if (! file.replaceWithText (csv))
+        juce::AlertWindow::showMessageBoxAsync (juce::MessageBoxIconType::WarningIcon, "Profiling statistics not saved",
+                                                "Could not write " + file.getFullPathName() + ".", {}, this);
+}
 
 
 //================================================//
-// Timer class methods.
+// Metering methods.
 
-void SoundOfLifeAudioProcessorEditor::timerCallback()
+/**
+    Draws the gain reduction of the limiter as a bar hanging from the top right corner,
+    full length at Variables::limiterMeterRange dB. Nothing is drawn while the limiter is idle.
+    @param graphics Graphics context to draw with.
+ */
+
+void SoundOfLifeAudioProcessorEditor::paintLimiterMeter (juce::Graphics& graphics)
 {
-    repaint();
+    if (m_GainReduction <= 0.0f)
+        return;
+    
+    const int meterWidth = 8;
+    const int meterHeight = 200;
+    
+    float fraction = juce::jmin (1.0f, m_GainReduction / Variables::limiterMeterRange);
+    
+    graphics.setColour (juce::Colours::black.withAlpha (0.75f));
+    graphics.fillRect (getWidth() - meterWidth - 8, 4, meterWidth + 4, meterHeight + 4);
+    graphics.setColour (juce::Colours::red);
+    graphics.fillRect ((float) (getWidth() - meterWidth - 6), 6.0f, (float) meterWidth, fraction * (float) meterHeight);
 }
@@ -3,7 +3,7 @@
 
 //================================================//
 
-class SoundOfLifeAudioProcessorEditor : public juce::AudioProcessorEditor, juce::Timer
+class SoundOfLifeAudioProcessorEditor : public juce::AudioProcessorEditor, juce::Timer, public juce::FileDragAndDropTarget
 {
 public:
     SoundOfLifeAudioProcessorEditor (SoundOfLifeAudioProcessor&);
@@ -12,12 +12,30 @@ public:
     // Component class methods.
     void paint (juce::Graphics& graphics) override;
     void resized() override;
+    bool keyPressed (const juce::KeyPress& key) override;
     
     // Timer class methods.
     void timerCallback() override;
+    
+    // FileDragAndDropTarget class methods.
+    bool isInterestedInFileDrag (const juce::StringArray& files) override;
+    void filesDropped (const juce::StringArray& files, int x, int y) override;
 
 private:
+    // Drawing methods.
+    void updateGridImage (const GridSnapshot& snapshot);
+    
+    // Profiling methods.
+    void paintProfiler (juce::Graphics& graphics);
+    void writeProfilerCSV();
+    
+    // Metering methods.
+    void paintLimiterMeter (juce::Graphics& graphics);
+    
     SoundOfLifeAudioProcessor& audioProcessor;                                              
+    juce::Image m_GridImage;                                                                // Grid drawn one pixel at a time, kept between repaints.
+    bool m_ShowProfiler = Variables::showProfiler;                                          // Whether the profiling overlay is drawn over the grid.
+    float m_GainReduction = 0.0f;                                                           // Gain reduction in dB shown by the limiter meter, falling back slowly.
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundOfLifeAudioProcessorEditor)
 };
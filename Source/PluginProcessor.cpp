@@ -15,6 +15,14 @@ SoundOfLifeAudioProcessor::SoundOfLifeAudioProcessor()
         m_Synthesis (m_Grid)
 #endif
 {
+    // Reverb parameters the host can automate, handed to the reverb at the start of every block.
+    juce::NormalisableRange<float> decayTimeRange (FDNReverb::minDecayTime, FDNReverb::maxDecayTime);
+    decayTimeRange.setSkewForCentre (Variables::reverbDecayTime);
+    
+    addParameter (m_ReverbRoomSize = new juce::AudioParameterFloat (juce::ParameterID ("reverbRoomSize", 1), "Reverb Room Size",
+                                                                    FDNReverb::minRoomSize, FDNReverb::maxRoomSize, Variables::reverbRoomSize));
+    addParameter (m_ReverbDecayTime = new juce::AudioParameterFloat (juce::ParameterID ("reverbDecayTime", 1), "Reverb Decay Time",
+                                                                     decayTimeRange, Variables::reverbDecayTime));
 }
 
 SoundOfLifeAudioProcessor::~SoundOfLifeAudioProcessor() {}
@@ -80,11 +88,28 @@ void SoundOfLifeAudioProcessor::changeProgramName (int index, const juce::String
 //==============================================================================
 void SoundOfLifeAudioProcessor::prepareToPlay(double sampleRate, int blockSize)
 {
-    m_Synthesis.prepareToPlay (sampleRate, blockSize);
+    // Grid storage is only reallocated here, before any audio is processed.
+    if (m_Grid.getNumRows() != m_NumRows || m_Grid.getNumColumns() != m_NumColumns)
+        m_Grid.setSize (m_NumRows, m_NumColumns);
+    
+    m_Synthesis.prepareToPlay (sampleRate, blockSize, getTotalNumOutputChannels());
+    setLatencySamples (m_Synthesis.getLatencySamples());
 }
 
 void SoundOfLifeAudioProcessor::releaseResources() {}
 
+/**
+    Inherited from juce::AudioProcessor class.
+    Offline renders convolve the whole impulse response on the audio thread, so its tail is never late.
+    @param isNonRealtime True when the host renders offline.
+ */
+
+void SoundOfLifeAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
+{
+    juce::AudioProcessor::setNonRealtime (isNonRealtime);
+    m_Synthesis.getConvolutionReverb().setNonRealtime (isNonRealtime);
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool SoundOfLifeAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -114,6 +139,11 @@ bool SoundOfLifeAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 void SoundOfLifeAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    
+    // The reverb picks changes up smoothly, and ignores values it already has.
+    m_Synthesis.getReverb().setRoomSize (m_ReverbRoomSize->get());
+    m_Synthesis.getReverb().setDecayTime (m_ReverbDecayTime->get());
+    
     m_Synthesis.processBlock (buffer);
 }
 
@@ -131,10 +161,36 @@ juce::AudioProcessorEditor* SoundOfLifeAudioProcessor::createEditor()
 //==============================================================================
 void SoundOfLifeAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
+    juce::XmlElement state ("SoundOfLife");
+    state.setAttribute ("numRows", m_NumRows);
+    state.setAttribute ("numColumns", m_NumColumns);
+    state.setAttribute ("oversamplingOrder", m_Synthesis.getSaturator().getOversamplingOrder());
+    state.setAttribute ("reverbRoomSize", (double) m_ReverbRoomSize->get());
+    state.setAttribute ("reverbDecayTime", (double) m_ReverbDecayTime->get());
+    state.setAttribute ("impulseResponse", m_Synthesis.getConvolutionReverb().getImpulseResponseFile().getFullPathName());
+    
+    copyXmlToBinary (state, destData);
 }
 
 void SoundOfLifeAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
+    std::unique_ptr<juce::XmlElement> state (getXmlFromBinary (data, sizeInBytes));
+    
+    if (state == nullptr || ! state->hasTagName ("SoundOfLife"))
+        return;
+    
+    setGridSize (state->getIntAttribute ("numRows", Variables::numRows),
+                 state->getIntAttribute ("numColumns", Variables::numColumns));
+    
+    setOversamplingOrder (state->getIntAttribute ("oversamplingOrder", Variables::saturationOversamplingOrder));
+    
+    *m_ReverbRoomSize = (float) state->getDoubleAttribute ("reverbRoomSize", Variables::reverbRoomSize);
+    *m_ReverbDecayTime = (float) state->getDoubleAttribute ("reverbDecayTime", Variables::reverbDecayTime);
+    
+    juce::String impulseResponse = state->getStringAttribute ("impulseResponse");
+    
+    if (impulseResponse.isNotEmpty())
+        m_Synthesis.getConvolutionReverb().loadImpulseResponse (juce::File (impulseResponse));
 }
 
 //==============================================================================
@@ -151,3 +207,31 @@ Grid& SoundOfLifeAudioProcessor::getGrid()
 {
     return m_Grid;
 }
+
+Synthesis& SoundOfLifeAudioProcessor::getSynthesis()
+{
+    return m_Synthesis;
+}
+
+/**
+    Sets the grid size to be used from the next call to prepareToPlay.
+    @param numRows Number of rows.
+    @param numColumns Number of columns.
+ */
+
+void SoundOfLifeAudioProcessor::setGridSize (int numRows, int numColumns)
+{
+    m_NumRows = juce::jlimit (1, Variables::maxNumRows, numRows);
+    m_NumColumns = juce::jlimit (1, Variables::maxNumColumns, numColumns);
+}
+
+/**
+    Sets the oversampling of the tanh distortion, and tells the host the latency that comes with it.
+    @param order Oversampling order, the factor being 2^order.
+ */
+
+void SoundOfLifeAudioProcessor::setOversamplingOrder (int order)
+{
+    m_Synthesis.getSaturator().setOversamplingOrder (order);
+    setLatencySamples (m_Synthesis.getLatencySamples());
+}
@@ -23,6 +23,7 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -48,10 +49,19 @@ public:
     void setStateInformation (const void* data, int sizeInBytes) override;
     
     Grid& getGrid();
+    Synthesis& getSynthesis();
+    void setGridSize (int numRows, int numColumns);
+    void setOversamplingOrder (int order);
 
 private:
     Grid m_Grid;                            // Grid object containing all state and logic the Game of Life simulation.
     Synthesis m_Synthesis;                  // Synthesis object containing all audio sources and processing.
+    
+    int m_NumRows = Variables::numRows;             // Number of grid rows applied on the next call to prepareToPlay.
+    int m_NumColumns = Variables::numColumns;       // Number of grid columns applied on the next call to prepareToPlay.
+    
+    juce::AudioParameterFloat* m_ReverbRoomSize;    // Room size of the FDN reverb, automatable by the host and owned by the processor.
+    juce::AudioParameterFloat* m_ReverbDecayTime;   // Decay time of the FDN reverb in seconds, automatable by the host and owned by the processor.
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundOfLifeAudioProcessor)
 };
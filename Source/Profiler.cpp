@@ -0,0 +1,271 @@
+#include "Headers.h"
+
+#if defined (_M_X64) || defined (_M_IX86)
+ #include <intrin.h>
+#elif defined (__x86_64__) || defined (__i386__)
+ #include <x86intrin.h>
+#endif
+
+
+//================================================//
+// Timing of the stages of a repeated task.
+
+Profiler::Profiler()
+{
+    // Calibrates the cycle counter here, so the recording thread never has to.
+    m_SecondsPerTick = 1.0 / getTicksPerSecond();
+
+    for (int i = 0; i < 3; ++i)
+        m_Stats.getBuffer (i) = Stats();
+
+    resetWindow (getTicks());
+}
+
+Profiler::~Profiler() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Sets the time available to a single task, which the histograms are relative to.
+    Must not be called while tasks are being recorded.
+    @param deadline Deadline in seconds.
+ */
+
+void Profiler::setDeadline (double deadline)
+{
+    m_Deadline = juce::jmax (1.0e-9, deadline);
+    resetWindow (getTicks());
+}
+
+
+//================================================//
+// Getter methods.
+
+/**
+    Returns the current value of the CPU cycle counter, or of the high resolution clock
+    on processors without one.
+ */
+
+juce::int64 Profiler::getTicks()
+{
+   #if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+    return (juce::int64) __rdtsc();
+   #else
+    return juce::Time::getHighResolutionTicks();
+   #endif
+}
+
+/**
+    Returns the number of ticks of getTicks per second. The cycle counter is measured against
+    the high resolution clock the first time this is called, which takes a few milliseconds.
+ */
+
+double Profiler::getTicksPerSecond()
+{
+   #if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+    static const double ticksPerSecond = []
+    {
+        juce::int64 startTime = juce::Time::getHighResolutionTicks();
+        juce::int64 startTicks = getTicks();
+
+        juce::Thread::sleep (20);
+
+        juce::int64 numTicks = getTicks() - startTicks;
+        return (double) numTicks / juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTime);
+    }();
+
+    return ticksPerSecond;
+   #else
+    return (double) juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
+
+/**
+    Returns a short name for a stage.
+    @param stage Stage to name.
+ */
+
+const char* Profiler::getStageName (Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::controlValues:  return "Gain/pan";
+        case Stage::oscillators:    return "Oscillators/FM";
+        case Stage::filter:         return "Filter";
+        case Stage::distortion:     return "Tanh";
+        case Stage::convolution:    return "Convolution";
+        case Stage::reverb:         return "Reverb";
+        case Stage::limiter:        return "Limiter";
+        case Stage::block:          return "Block";
+        case Stage::gridStep:       return "Grid step";
+        case Stage::numStages:      break;
+    }
+
+    return "";
+}
+
+/**
+    Returns the mean time of a stage in seconds, or 0 if it was never measured.
+    @param stats Statistics of the stage.
+ */
+
+double Profiler::getMean (const StageStats& stats)
+{
+    return stats.count > 0 ? stats.total / stats.count : 0.0;
+}
+
+/**
+    Returns the time in seconds a given fraction of measurements of a stage stay below.
+    Measured to the resolution of the histogram, and never above the longest measurement.
+    @param stats Statistics of the stage.
+    @param deadline Deadline the histogram is relative to.
+    @param fraction Fraction of measurements in range [0,1], 0.99 gives the 99th percentile.
+ */
+
+double Profiler::getPercentile (const StageStats& stats, double deadline, double fraction)
+{
+    if (stats.count == 0)
+        return 0.0;
+
+    juce::uint32 target = (juce::uint32) std::ceil (fraction * stats.count);
+    juce::uint32 sum = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        sum += stats.histogram[bin];
+
+        if (sum >= target)
+            return juce::jmin (stats.maximum, (bin + 1) * deadline / binsPerDeadline);
+    }
+
+    return stats.maximum;
+}
+
+/**
+    Returns the statistics of the most recently finished window.
+    Must only be called from a single reader thread, and stays valid until the next call.
+ */
+
+const Profiler::Stats& Profiler::getStats()
+{
+    return m_Stats.getReadBuffer();
+}
+
+
+//================================================//
+// Recording methods.
+
+/**
+    Adds time to a stage of the current task. Stages can be recorded several times per task.
+    @param stage Stage to add to.
+    @param numTicks Ticks of getTicks spent in the stage.
+ */
+
+void Profiler::record (Stage stage, juce::int64 numTicks)
+{
+    m_TaskTicks[(int) stage] += numTicks;
+    m_TaskHasStage[(int) stage] = true;
+}
+
+/**
+    Folds the stages recorded since the last call into the window, and publishes the window
+    once it is long enough. Stages which didn't run, such as bypassed effects, are not counted.
+ */
+
+void Profiler::finishTask()
+{
+    Stats& stats = m_Stats.getWriteBuffer();
+
+    for (int stageIndex = 0; stageIndex < (int) Stage::numStages; ++stageIndex)
+    {
+        if (! m_TaskHasStage[stageIndex])
+            continue;
+
+        StageStats& stage = stats.stages[stageIndex];
+        double time = (double) m_TaskTicks[stageIndex] * m_SecondsPerTick;
+
+        int bin = juce::jlimit (0, numBins - 1, (int) (time / m_Deadline * binsPerDeadline));
+        ++stage.histogram[bin];
+
+        stage.minimum = stage.count == 0 ? time : juce::jmin (stage.minimum, time);
+        stage.maximum = juce::jmax (stage.maximum, time);
+        stage.total += time;
+        ++stage.count;
+
+        m_TaskTicks[stageIndex] = 0;
+        m_TaskHasStage[stageIndex] = false;
+    }
+
+    ++stats.numTasks;
+
+    juce::int64 now = getTicks();
+    stats.duration = (double) (now - m_WindowStart) * m_SecondsPerTick;
+
+    if (stats.duration >= Variables::profilerWindow)
+    {
+        m_Stats.publish();
+        resetWindow (now);
+    }
+}
+
+
+//================================================//
+// Export methods.
+
+/**
+    Returns the header line of the CSV produced by toCSV.
+ */
+
+juce::String Profiler::getCSVHeader()
+{
+    return "stage,count,min_us,mean_us,p99_us,max_us,deadline_us,tasks_per_second\n";
+}
+
+/**
+    Returns the statistics of a window as CSV, one line per measured stage, times in microseconds.
+    @param stats Statistics to export.
+ */
+
+juce::String Profiler::toCSV (const Stats& stats)
+{
+    juce::String csv;
+
+    for (int stageIndex = 0; stageIndex < (int) Stage::numStages; ++stageIndex)
+    {
+        const StageStats& stage = stats.stages[stageIndex];
+
+        if (stage.count == 0)
+            continue;
+
+        csv << getStageName ((Stage) stageIndex) << ","
+            << stage.count << ","
+            << stage.minimum * 1.0e6 << ","
+            << getMean (stage) * 1.0e6 << ","
+            << getPercentile (stage, stats.deadline, 0.99) * 1.0e6 << ","
+            << stage.maximum * 1.0e6 << ","
+            << stats.deadline * 1.0e6 << ","
+            << (stats.duration > 0.0 ? stats.numTasks / stats.duration : 0.0) << "\n";
+    }
+
+    return csv;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Clears the write buffer and starts a new window.
+    @param now Current value of getTicks.
+ */
+
+void Profiler::resetWindow (juce::int64 now)
+{
+    Stats& stats = m_Stats.getWriteBuffer();
+    stats = Stats();
+    stats.deadline = m_Deadline;
+
+    m_WindowStart = now;
+}
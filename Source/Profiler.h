@@ -0,0 +1,108 @@
+#pragma once
+
+
+//================================================//
+/// Lightweight timing of the stages of a repeated task, such as an audio block or a grid step.
+/// Stages are timed with the CPU cycle counter and folded into a histogram relative to the task's
+/// deadline. Every Variables::profilerWindow seconds the statistics of the finished window are
+/// published through a TripleBuffer, so the recording thread never locks and the reader always
+/// sees a complete window. Recording is done by a single thread, reading by another single thread.
+
+class Profiler
+{
+public:
+    /// Stages which can be timed. Each profiler only records the stages run by its own thread.
+    enum class Stage
+    {
+        controlValues,                                                      // Fades, gains and pans computed from the grid.
+        oscillators,                                                        // LFOs, frequency modulation and oscillator rendering.
+        filter,                                                             // Low pass filter.
+        distortion,                                                         // Tanh distortion.
+        convolution,                                                        // Convolution reverb.
+        reverb,                                                             // Reverb.
+        limiter,                                                            // True peak limiter.
+        block,                                                              // Whole audio block.
+        gridStep,                                                           // One generation of the grid.
+        numStages
+    };
+
+    static constexpr int numBins = 64;                                      // Number of histogram bins.
+    static constexpr int binsPerDeadline = 32;                              // Number of bins covering one deadline, later bins hold overruns.
+
+    /// Statistics of one stage over a window, in seconds.
+    struct StageStats
+    {
+        juce::uint32 histogram[numBins];                                    // Number of measurements per bin.
+        int count;                                                          // Number of measurements.
+        double minimum;                                                     // Shortest measurement.
+        double maximum;                                                     // Longest measurement.
+        double total;                                                       // Sum of all measurements.
+    };
+
+    /// Statistics of every stage over a window.
+    struct Stats
+    {
+        StageStats stages[(int) Stage::numStages];                          // Statistics of each stage.
+        double deadline;                                                    // Time available to a single task.
+        double duration;                                                    // Length of the window.
+        int numTasks;                                                       // Number of tasks finished during the window.
+    };
+
+    Profiler();
+    ~Profiler();
+
+    // Init methods.
+    void setDeadline (double deadline);
+
+    // Getter methods.
+    static juce::int64 getTicks();
+    static double getTicksPerSecond();
+    static const char* getStageName (Stage stage);
+    static double getMean (const StageStats& stats);
+    static double getPercentile (const StageStats& stats, double deadline, double fraction);
+    const Stats& getStats();
+
+    // Recording methods.
+    void record (Stage stage, juce::int64 numTicks);
+    void finishTask();
+
+    // Export methods.
+    static juce::String getCSVHeader();
+    static juce::String toCSV (const Stats& stats);
+
+    //================================================//
+    /// Scoped timer adding the time spent in its scope to a stage of the current task.
+
+    class Scope
+    {
+    public:
+        Scope (Profiler& profiler, Stage stage)
+            :   m_Profiler (profiler),
+                m_Stage (stage),
+                m_Start (getTicks())
+        {}
+
+        ~Scope()                                                    { m_Profiler.record (m_Stage, getTicks() - m_Start); }
+
+    private:
+        Profiler& m_Profiler;                                           // Profiler the time is added to.
+        Stage m_Stage;                                                  // Stage being timed.
+        juce::int64 m_Start;                                            // Cycle counter when the scope was entered.
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+
+private:
+    // Helper methods.
+    void resetWindow (juce::int64 now);
+
+    juce::int64 m_TaskTicks[(int) Stage::numStages] = {};                   // Ticks spent in each stage by the current task.
+    bool m_TaskHasStage[(int) Stage::numStages] = {};                       // Whether each stage ran during the current task.
+    juce::int64 m_WindowStart = 0;                                          // Cycle counter when the current window started.
+    double m_SecondsPerTick = 0.0;                                          // Length of a tick in seconds.
+    double m_Deadline = 1.0;                                                // Time available to a single task, in seconds.
+
+    TripleBuffer<Stats> m_Stats;                                            // Statistics of the current window and the published ones.
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Profiler)
+};
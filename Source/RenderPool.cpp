@@ -0,0 +1,155 @@
+#include "Headers.h"
+
+
+//================================================//
+// Pool of realtime worker threads sharing the tasks of an audio block.
+
+RenderPool::RenderPool() {}
+
+RenderPool::~RenderPool()
+{
+    setNumWorkers (0, false);
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Stops any existing workers and starts a new set of realtime worker threads.
+    Must not be called while a batch is running.
+    @param numWorkers Number of worker threads, not counting the audio thread.
+    @param useAffinity If true each worker is pinned to its own core.
+ */
+
+void RenderPool::setNumWorkers (int numWorkers, bool useAffinity)
+{
+    for (auto* worker : m_Workers)
+        worker->signalThreadShouldExit();
+    
+    for (auto* worker : m_Workers)
+        worker->stopThread (1000);
+    
+    m_Workers.clear();
+    
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = m_Workers.add (new Worker (*this));
+        
+        // Cores are taken from the top, away from the grid workers which start at core 1.
+        if (useAffinity)
+            worker->setAffinityMask ((juce::uint32) 1 << ((juce::SystemStats::getNumCpus() - 1 - i) % 32));
+        
+        worker->startRealtimeThread (juce::Thread::RealtimeOptions().withPriority (10));
+    }
+}
+
+
+//================================================//
+// Getter methods.
+
+int RenderPool::getNumWorkers()                                     { return m_Workers.size(); }
+
+
+//================================================//
+// Processing methods.
+
+/**
+    Runs a task for every index in [0, numTasks) across all workers and the calling thread.
+    Never blocks on a worker which has not started a task, since the calling thread claims every
+    task left over once it runs out of its own work. Returns once every task has finished.
+    @param job Job to run.
+    @param numTasks Number of tasks, at most 65535.
+ */
+
+void RenderPool::run (Job& job, int numTasks)
+{
+    jassert (numTasks <= 0xffff);
+    
+    if (numTasks <= 0)
+        return;
+    
+    // Without workers, or with a single task, there is nothing to share.
+    if (m_Workers.size() == 0 || numTasks == 1)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            job.processTask (i);
+        
+        return;
+    }
+    
+    m_Job.store (&job, std::memory_order_relaxed);
+    m_NumRemaining.store (numTasks, std::memory_order_relaxed);
+    m_LastRunTime.store (juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+    
+    // Publishing the batch word is all it takes to start the workers.
+    juce::uint64 batch = (getBatch (m_State.load (std::memory_order_relaxed)) + 1) & 0xffffffff;
+    m_State.store ((batch << 32) | ((juce::uint64) numTasks << 16), std::memory_order_release);
+    
+    processTasks (batch);
+    
+    // Every task has been claimed by now, so this only waits for tasks already running.
+    while (m_NumRemaining.load (std::memory_order_acquire) > 0)
+        ;
+}
+
+/**
+    Claims and runs tasks of a batch until none are left.
+    @param batch Batch number the tasks must belong to.
+ */
+
+void RenderPool::processTasks (juce::uint64 batch)
+{
+    juce::uint64 state = m_State.load (std::memory_order_acquire);
+    
+    while (getBatch (state) == batch && getNextTask (state) < getNumTasks (state))
+    {
+        if (! m_State.compare_exchange_weak (state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            continue;
+        
+        // The batch can't finish before this task does, so the job is still the one of the batch.
+        m_Job.load (std::memory_order_acquire)->processTask (getNextTask (state));
+        m_NumRemaining.fetch_sub (1, std::memory_order_release);
+        
+        state = m_State.load (std::memory_order_acquire);
+    }
+}
+
+
+//================================================//
+// Worker thread.
+
+RenderPool::Worker::Worker (RenderPool& pool)
+    :   juce::Thread ("Render Worker"),
+        m_Pool (pool)
+{
+}
+
+/**
+    Inherited from juce::Thread class.
+    Polls for new batches and helps process them. Polling keeps the wake-up latency far below
+    a block, which waiting on an event could not guarantee, so the worker only naps once no
+    batch has started for Variables::renderWorkerSpinTime.
+ */
+
+void RenderPool::Worker::run()
+{
+    juce::uint64 lastBatch = getBatch (m_Pool.m_State.load (std::memory_order_acquire));
+    
+    while (! threadShouldExit())
+    {
+        juce::uint64 batch = getBatch (m_Pool.m_State.load (std::memory_order_acquire));
+        
+        if (batch != lastBatch)
+        {
+            lastBatch = batch;
+            m_Pool.processTasks (batch);
+        }
+        
+        else if (juce::Time::getMillisecondCounter() - m_Pool.m_LastRunTime.load (std::memory_order_relaxed) < (juce::uint32) Variables::renderWorkerSpinTime)
+            yield();
+        
+        else
+            sleep (1);
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+
+//================================================//
+/// Pool of realtime worker threads which share the tasks of an audio block with the audio thread.
+/// Unlike WorkerPool, starting and finishing a batch never locks, allocates or waits on an event:
+/// workers poll a single atomic batch word and claim tasks from it with compare-and-swap. The audio
+/// thread claims tasks too, so any task a late worker has not picked up is rendered by the audio
+/// thread itself, and the audio thread only ever waits for tasks which are already running.
+
+class RenderPool
+{
+public:
+    //================================================//
+    /// Work shared across the pool, one call per task index.
+    
+    struct Job
+    {
+        virtual ~Job() {}
+        
+        /**
+            Runs a single task. Called concurrently for different task indices.
+            @param taskIndex Index of the task in range [0, numTasks).
+         */
+        
+        virtual void processTask (int taskIndex) = 0;
+    };
+    
+    RenderPool();
+    ~RenderPool();
+    
+    // Setter methods.
+    void setNumWorkers (int numWorkers, bool useAffinity);
+    
+    // Getter methods.
+    int getNumWorkers();
+    
+    // Processing methods.
+    void run (Job& job, int numTasks);
+
+private:
+    //================================================//
+    /// Worker thread which polls for new batches, and naps once audio has stopped for a while.
+    
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (RenderPool& pool);
+        
+        // Thread class methods.
+        void run() override;
+    
+    private:
+        RenderPool& m_Pool;                                                 // Pool the worker belongs to.
+    };
+    
+    // Processing methods.
+    void processTasks (juce::uint64 batch);
+    
+    // The batch word packs the batch number, the number of tasks and the next task to claim,
+    // so a late worker can never claim a task of a batch it has not seen start.
+    static juce::uint64 getBatch (juce::uint64 state)                   { return state >> 32; }
+    static int getNumTasks (juce::uint64 state)                         { return (int) ((state >> 16) & 0xffff); }
+    static int getNextTask (juce::uint64 state)                         { return (int) (state & 0xffff); }
+    
+    juce::OwnedArray<Worker> m_Workers;                                     // Worker threads.
+    std::atomic<juce::uint64> m_State { 0 };                                // Batch number, number of tasks and next task to claim.
+    std::atomic<Job*> m_Job { nullptr };                                    // Job of the current batch.
+    std::atomic<int> m_NumRemaining { 0 };                                  // Tasks of the current batch which have not finished.
+    std::atomic<juce::uint32> m_LastRunTime { 0 };                          // Millisecond counter when the last batch started.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderPool)
+};
@@ -0,0 +1,211 @@
+#include "Headers.h"
+
+#if defined (__AVX2__) || defined (__SSE2__) || defined (_M_X64)
+ #include <immintrin.h>
+#endif
+
+
+//================================================//
+// Oversampled tanh waveshaper.
+
+Saturator::Saturator()
+{
+    for (int order = minOversamplingOrder; order <= maxOversamplingOrder; ++order)
+        m_Oversamplers.add (new juce::dsp::Oversampling<float> (2, (size_t) order, juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple, true, true));
+}
+
+Saturator::~Saturator() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Prepares the oversampling filters of every order for a block size and clears them.
+    @param blockSize Largest number of samples passed to processStereo.
+ */
+
+void Saturator::prepareToPlay (int blockSize)
+{
+    for (auto* oversampler : m_Oversamplers)
+        oversampler->initProcessing ((size_t) blockSize);
+    
+    m_AppliedOrder = getOversamplingOrder();
+    reset();
+}
+
+/**
+    Clears the oversampling filters of every order.
+ */
+
+void Saturator::reset()
+{
+    for (auto* oversampler : m_Oversamplers)
+        oversampler->reset();
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the oversampling factor, used from the next block. Can be called from any thread,
+    but the latency changes with it, so the host should be told the new latency.
+    @param order Oversampling order in range [minOversamplingOrder, maxOversamplingOrder], the factor being 2^order.
+ */
+
+void Saturator::setOversamplingOrder (int order)
+{
+    m_OversamplingOrder.store (juce::jlimit (minOversamplingOrder, maxOversamplingOrder, order), std::memory_order_relaxed);
+}
+
+/**
+    Sets the gain applied before the tanh. Can be called from any thread.
+    @param drive Gain, 1 keeping quiet signals at their level.
+ */
+
+void Saturator::setDrive (float drive)
+{
+    m_Drive.store (juce::jmax (0.0f, drive), std::memory_order_relaxed);
+}
+
+
+//================================================//
+// Getter methods.
+
+int Saturator::getOversamplingOrder()                               { return m_OversamplingOrder.load (std::memory_order_relaxed); }
+float Saturator::getDrive()                                         { return m_Drive.load (std::memory_order_relaxed); }
+
+/**
+    Returns the delay in samples added by the oversampling filters of the current order.
+ */
+
+int Saturator::getLatencySamples()
+{
+    return juce::roundToInt (m_Oversamplers[getOversamplingOrder() - minOversamplingOrder]->getLatencyInSamples());
+}
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Saturates a stereo pair of buffers in place.
+    @param left Left channel.
+    @param right Right channel.
+    @param numSamples Number of samples, at most the block size given to prepareToPlay.
+ */
+
+void Saturator::processStereo (float* left, float* right, int numSamples)
+{
+    int order = getOversamplingOrder();
+    float drive = getDrive();
+    
+    // Filters of the other orders hold stale samples, so a newly selected order starts from silence.
+    if (order != m_AppliedOrder)
+    {
+        m_Oversamplers[order - minOversamplingOrder]->reset();
+        m_AppliedOrder = order;
+    }
+    
+    auto& oversampler = *m_Oversamplers[order - minOversamplingOrder];
+    
+    float* channels[2] = { left, right };
+    juce::dsp::AudioBlock<float> block (channels, 2, (size_t) numSamples);
+    juce::dsp::AudioBlock<float> oversampled = oversampler.processSamplesUp (block);
+    
+    for (size_t channel = 0; channel < oversampled.getNumChannels(); ++channel)
+        saturate (oversampled.getChannelPointer (channel), (int) oversampled.getNumSamples(), drive);
+    
+    oversampler.processSamplesDown (block);
+}
+
+
+//================================================//
+// Kernel methods.
+
+/**
+    Replaces samples by the tanh approximant of their driven value, using the widest vector unit available.
+    @param samples Samples to saturate.
+    @param numSamples Number of samples.
+    @param drive Gain applied before the tanh.
+ */
+
+void Saturator::saturate (float* samples, int numSamples, float drive)
+{
+   #if defined (__AVX2__)
+    const int numLanes = 8;
+   #elif defined (__SSE2__) || defined (_M_X64)
+    const int numLanes = 4;
+   #else
+    const int numLanes = 1;
+   #endif
+    
+    int vectorEnd = numSamples / numLanes * numLanes;
+   
+   #if defined (__AVX2__)
+    const __m256 gain = _mm256_set1_ps (drive);
+    const __m256 upper = _mm256_set1_ps (clampLevel);
+    const __m256 lower = _mm256_set1_ps (-clampLevel);
+    
+    for (int i = 0; i < vectorEnd; i += 8)
+    {
+        __m256 x = _mm256_min_ps (_mm256_max_ps (_mm256_mul_ps (_mm256_loadu_ps (samples + i), gain), lower), upper);
+        __m256 x2 = _mm256_mul_ps (x, x);
+        
+        __m256 numerator = _mm256_add_ps (_mm256_set1_ps (378.0f), x2);
+        numerator = _mm256_add_ps (_mm256_set1_ps (17325.0f), _mm256_mul_ps (x2, numerator));
+        numerator = _mm256_mul_ps (x, _mm256_add_ps (_mm256_set1_ps (135135.0f), _mm256_mul_ps (x2, numerator)));
+        
+        __m256 denominator = _mm256_add_ps (_mm256_set1_ps (3150.0f), _mm256_mul_ps (_mm256_set1_ps (28.0f), x2));
+        denominator = _mm256_add_ps (_mm256_set1_ps (62370.0f), _mm256_mul_ps (x2, denominator));
+        denominator = _mm256_add_ps (_mm256_set1_ps (135135.0f), _mm256_mul_ps (x2, denominator));
+        
+        _mm256_storeu_ps (samples + i, _mm256_div_ps (numerator, denominator));
+    }
+   #elif defined (__SSE2__) || defined (_M_X64)
+    const __m128 gain = _mm_set1_ps (drive);
+    const __m128 upper = _mm_set1_ps (clampLevel);
+    const __m128 lower = _mm_set1_ps (-clampLevel);
+    
+    for (int i = 0; i < vectorEnd; i += 4)
+    {
+        __m128 x = _mm_min_ps (_mm_max_ps (_mm_mul_ps (_mm_loadu_ps (samples + i), gain), lower), upper);
+        __m128 x2 = _mm_mul_ps (x, x);
+        
+        __m128 numerator = _mm_add_ps (_mm_set1_ps (378.0f), x2);
+        numerator = _mm_add_ps (_mm_set1_ps (17325.0f), _mm_mul_ps (x2, numerator));
+        numerator = _mm_mul_ps (x, _mm_add_ps (_mm_set1_ps (135135.0f), _mm_mul_ps (x2, numerator)));
+        
+        __m128 denominator = _mm_add_ps (_mm_set1_ps (3150.0f), _mm_mul_ps (_mm_set1_ps (28.0f), x2));
+        denominator = _mm_add_ps (_mm_set1_ps (62370.0f), _mm_mul_ps (x2, denominator));
+        denominator = _mm_add_ps (_mm_set1_ps (135135.0f), _mm_mul_ps (x2, denominator));
+        
+        _mm_storeu_ps (samples + i, _mm_div_ps (numerator, denominator));
+    }
+   #endif
+    
+    saturateScalar (samples + vectorEnd, numSamples - vectorEnd, drive);
+}
+
+/**
+    Replaces samples by the tanh approximant of their driven value one at a time. Used for the end
+    of each block and on targets without vector units, and gives the same results as the vector loops.
+    @param samples Samples to saturate.
+    @param numSamples Number of samples.
+    @param drive Gain applied before the tanh.
+ */
+
+void Saturator::saturateScalar (float* samples, int numSamples, float drive)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float x = juce::jlimit (-clampLevel, clampLevel, samples[i] * drive);
+        float x2 = x * x;
+        
+        float numerator = x * (135135.0f + x2 * (17325.0f + x2 * (378.0f + x2)));
+        float denominator = 135135.0f + x2 * (62370.0f + x2 * (3150.0f + 28.0f * x2));
+        
+        samples[i] = numerator / denominator;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+
+//================================================//
+/// Tanh waveshaper run at 2x, 4x or 8x the sample rate, so the harmonics of a hard drive are filtered out
+/// instead of folding back below the Nyquist frequency. Oversampling uses the polyphase half-band FIR
+/// stages of juce::dsp::Oversampling, with an integer latency which the host is told about.
+/// The tanh is a [7/6] Pade approximant on an input clamped to +-clampLevel, whose worst case error against
+/// std::tanh over the whole real line is below 7.1e-5, computed with AVX2 or SSE2 when the compiler targets them.
+/// Every oversampling factor is prepared up front, so switching factors never allocates.
+
+class Saturator
+{
+public:
+    static constexpr int minOversamplingOrder = 1;                          // Lowest oversampling, 2x.
+    static constexpr int maxOversamplingOrder = 3;                          // Highest oversampling, 8x.
+    static constexpr float clampLevel = 4.79f;                              // Input beyond which the approximant is held, where it is closest to 1.
+    
+    Saturator();
+    ~Saturator();
+    
+    // Init methods.
+    void prepareToPlay (int blockSize);
+    void reset();
+    
+    // Setter methods.
+    void setOversamplingOrder (int order);
+    void setDrive (float drive);
+    
+    // Getter methods.
+    int getOversamplingOrder();
+    float getDrive();
+    int getLatencySamples();
+    
+    // DSP methods.
+    void processStereo (float* left, float* right, int numSamples);
+    
+    // Kernel methods.
+    static void saturate (float* samples, int numSamples, float drive);
+    static void saturateScalar (float* samples, int numSamples, float drive);
+
+private:
+    juce::OwnedArray<juce::dsp::Oversampling<float>> m_Oversamplers;        // One oversampler per order, from minOversamplingOrder up.
+    
+    std::atomic<int> m_OversamplingOrder { Variables::saturationOversamplingOrder };   // Oversampling order set by the caller.
+    std::atomic<float> m_Drive { Variables::saturationDrive };              // Gain applied before the tanh, set by the caller.
+    int m_AppliedOrder = 0;                                                 // Oversampling order used by the last block.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Saturator)
+};
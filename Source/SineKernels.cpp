@@ -0,0 +1,350 @@
+#include "Headers.h"
+
+
+//================================================//
+// Sine implementations used by the oscillator bank.
+
+
+//================================================//
+// Init methods.
+
+/**
+    Makes sure the wavetable has been built. Called before audio starts so the audio thread never builds it.
+ */
+
+void SineKernels::prepareWavetable()
+{
+    getWavetableData();
+}
+
+
+//================================================//
+// Getter methods.
+
+/**
+    Returns the name of a sine implementation.
+    @param type Sine implementation.
+ */
+
+const char* SineKernels::getName (Type type)
+{
+    switch (type)
+    {
+        case Type::standard:    return "standard";
+        case Type::wavetable:   return "wavetable";
+        case Type::polynomial:  return "polynomial";
+        case Type::phasor:      return "phasor";
+    }
+    
+    return "";
+}
+
+
+//================================================//
+// Kernel methods.
+
+/**
+    Returns sin (2 pi phase) using std::sin on each lane.
+    @param phase Phases in range [0,1].
+ */
+
+SineKernels::Register SineKernels::getStandard (Register phase)
+{
+    Register sine;
+    
+    for (size_t lane = 0; lane < Register::SIMDNumElements; ++lane)
+        sine.set (lane, std::sin (juce::MathConstants<float>::twoPi * phase.get (lane)));
+    
+    return sine;
+}
+
+/**
+    Returns sin (2 pi phase) by linear interpolation in the wavetable.
+    SIMD registers can't gather, so the lookups are done lane by lane.
+    @param phase Phases in range [0,1].
+ */
+
+SineKernels::Register SineKernels::getWavetable (Register phase)
+{
+    const float* table = getWavetableData();
+    Register sine;
+    
+    for (size_t lane = 0; lane < Register::SIMDNumElements; ++lane)
+    {
+        float position = phase.get (lane) * (float) wavetableSize;
+        int index = juce::jlimit (0, wavetableSize - 1, (int) position);
+        float fraction = position - (float) index;
+        
+        sine.set (lane, table[index] + (table[index + 1] - table[index]) * fraction);
+    }
+    
+    return sine;
+}
+
+/**
+    Returns sin (2 pi phase) for phases in range [0,1], one per lane.
+    The phase is folded into a quarter period and evaluated with a degree 9 odd polynomial,
+    whose coefficients minimise the largest absolute error over [0, pi/2] (Remez exchange).
+    The coefficients are within 1.1e-8 of sin in exact arithmetic, so float rounding sets the error of the kernel.
+    @param phase Phases in range [0,1].
+ */
+
+SineKernels::Register SineKernels::getPolynomial (Register phase)
+{
+    const Register zero = Register::expand (0.0f);
+    const Register half = Register::expand (0.5f);
+    
+    // sin (2 pi phase) = -sin (2 pi x) with x in [-0.5,0.5], and sin is symmetric around x = 0.25.
+    Register x = phase - half;
+    Register::vMaskType isNegative = Register::lessThan (x, zero);
+    Register folded = Register::abs (x);
+    folded = Register::min (folded, half - folded);
+    
+    Register t = folded * juce::MathConstants<float>::twoPi;
+    Register t2 = t * t;
+    
+    Register sine = Register::expand (2.5904885e-6f);
+    sine = sine * t2 - 1.9800898e-4f;
+    sine = sine * t2 + 8.3328998e-3f;
+    sine = sine * t2 - 1.6666648e-1f;
+    sine = (sine * t2 + 0.99999998f) * t;
+    
+    // Restores the sign of x, then flips it back to the original phase.
+    Register negated = zero - sine;
+    return (negated & ~isNegative) | (sine & isNegative);
+}
+
+/**
+    Returns the cosine and sine of angles, used to rotate a phasor by one sample.
+    Only called once per register and render call, so std::cos and std::sin are used on each lane.
+    @param angle Angles in radians.
+    @param cosine Receives the cosine of each angle.
+    @param sine Receives the sine of each angle.
+ */
+
+void SineKernels::getRotation (Register angle, Register& cosine, Register& sine)
+{
+    for (size_t lane = 0; lane < Register::SIMDNumElements; ++lane)
+    {
+        cosine.set (lane, std::cos (angle.get (lane)));
+        sine.set (lane, std::sin (angle.get (lane)));
+    }
+}
+
+
+//================================================//
+// Benchmark methods.
+
+/**
+    Renders the same bank of partials with every sine implementation and reports the time
+    per partial and sample, and the largest difference from the standard implementation.
+    @param numPartials Number of partials to render.
+    @param numSamples Number of samples to render.
+ */
+
+juce::String SineKernels::runBenchmark (int numPartials, int numSamples)
+{
+    const int blockSize = Variables::controlPeriod;
+    const float sampleRate = 48000.0f;
+    const Type types[] = { Type::standard, Type::wavetable, Type::polynomial, Type::phasor };
+    
+    juce::HeapBlock<float> silence (blockSize, true);
+    const float* modulators[] = { silence.get() };
+    
+    juce::HeapBlock<float> reference ((size_t) numSamples * 2, true);
+    juce::HeapBlock<float> output ((size_t) numSamples * 2, true);
+    juce::String report;
+    
+    for (Type type : types)
+    {
+        OscillatorBank bank;
+        bank.prepareToPlay (numPartials, sampleRate, blockSize);
+        bank.setSineKernel (type);
+        
+        // Partials spread over the range the synthesis uses, at full gain and centred.
+        for (int partial = 0; partial < numPartials; ++partial)
+        {
+            bank.setFrequency (partial, Variables::startFrequency * (1.0f + partial * 0.37f));
+            bank.setTargets (partial, 1.0f, 0.0f);
+        }
+        
+        float* left = type == Type::standard ? reference.get() : output.get();
+        float* right = left + numSamples;
+        std::fill (left, left + numSamples * 2, 0.0f);
+        
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        
+        for (int start = 0; start < numSamples; start += blockSize)
+            bank.render (left + start, right + start, juce::jmin (blockSize, numSamples - start), modulators);
+        
+        double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        
+        float maxError = 0.0f;
+        
+        for (int i = 0; i < numSamples * 2; ++i)
+            maxError = juce::jmax (maxError, std::abs (left[i] - reference[i]) / (float) numPartials);
+        
+        report << getName (type) << ": " << juce::String (seconds * 1.0e9 / ((double) numPartials * numSamples), 3)
+               << " ns per partial sample, max error " << juce::String (maxError, 9) << "\n";
+    }
+    
+    return report;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Returns the wavetable, one period plus a guard point. The table is filled by a static
+    initialiser on the first call, which C++ runs exactly once however many banks share it.
+ */
+
+const float* SineKernels::getWavetableData()
+{
+    static const std::array<float, wavetableSize + 1> table = []
+    {
+        std::array<float, wavetableSize + 1> values;
+        
+        // One guard point past the end lets the interpolation read index + 1 without wrapping.
+        for (int i = 0; i <= wavetableSize; ++i)
+            values[(size_t) i] = (float) std::sin (2.0 * juce::MathConstants<double>::pi * i / wavetableSize);
+        
+        return values;
+    }();
+    
+    return table.data();
+}
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS
+
+/// Checks every sine implementation against std::sin, to the error bounds documented in SineKernels.h.
+
+class SineKernelsTests : public juce::UnitTest
+{
+public:
+    SineKernelsTests() : juce::UnitTest ("SineKernels", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        const int numLanes = (int) SineKernels::Register::SIMDNumElements;
+        const int numPhases = 1 << 16;
+        
+        for (int type = 0; type < SineKernels::numTypes; ++type)
+        {
+            beginTest (juce::String ("Error of the ") + SineKernels::getName ((SineKernels::Type) type) + " kernel");
+            
+            if ((SineKernels::Type) type == SineKernels::Type::phasor)
+            {
+                // The phasor only exists inside the bank, so it is checked against the bank rendered with std::sin.
+                expectLessThan (getPhasorError (64, 0.0f), 1.0e-5f, "Unmodulated phasor, control period 64");
+                expectLessThan (getPhasorError (256, 0.0f), 5.0e-5f, "Unmodulated phasor, control period 256");
+                expectLessThan (getPhasorError (64, 5.0f), 2.0e-4f, "Phasor under a 5 Hz vibrato, control period 64");
+                continue;
+            }
+            
+            float maxError = 0.0f;
+            
+            for (int start = 0; start <= numPhases; start += numLanes)
+            {
+                SineKernels::Register phase;
+                
+                for (int lane = 0; lane < numLanes; ++lane)
+                    phase.set ((size_t) lane, (float) juce::jmin (start + lane, numPhases) / (float) numPhases);
+                
+                SineKernels::Register sine = getSine ((SineKernels::Type) type, phase);
+                
+                for (int lane = 0; lane < numLanes; ++lane)
+                {
+                    double expected = std::sin (2.0 * juce::MathConstants<double>::pi * (double) phase.get ((size_t) lane));
+                    maxError = juce::jmax (maxError, (float) std::abs (sine.get ((size_t) lane) - expected));
+                }
+            }
+            
+            expectLessThan (maxError, getErrorBound ((SineKernels::Type) type), "Kernel error above its documented bound");
+        }
+    }
+
+private:
+    /**
+        Returns the sines of phases computed by a stateless implementation.
+        @param type Sine implementation, not the phasor.
+        @param phase Phases in range [0,1].
+     */
+    
+    static SineKernels::Register getSine (SineKernels::Type type, SineKernels::Register phase)
+    {
+        switch (type)
+        {
+            case SineKernels::Type::wavetable:      return SineKernels::getWavetable (phase);
+            case SineKernels::Type::polynomial:     return SineKernels::getPolynomial (phase);
+            default:                                return SineKernels::getStandard (phase);
+        }
+    }
+    
+    /**
+        Returns the documented error bound of a stateless implementation.
+        @param type Sine implementation, not the phasor.
+     */
+    
+    static float getErrorBound (SineKernels::Type type)
+    {
+        switch (type)
+        {
+            case SineKernels::Type::wavetable:      return 1.3e-6f;
+            case SineKernels::Type::polynomial:     return 2.0e-7f;
+            default:                                return 1.0e-6f;
+        }
+    }
+    
+    /**
+        Returns the largest difference between a partial rendered with the phasor and with std::sin.
+        @param controlPeriod Number of samples per render call.
+        @param vibratoRate Rate of the frequency modulation in Hz, 0 for none.
+     */
+    
+    static float getPhasorError (int controlPeriod, float vibratoRate)
+    {
+        const float sampleRate = 48000.0f;
+        const int numSamples = 1 << 16;
+        
+        juce::AudioBuffer<float> rendered[2] = { { 2, numSamples }, { 2, numSamples } };
+        juce::HeapBlock<float> modulation ((size_t) numSamples);
+        
+        for (int i = 0; i < numSamples; ++i)
+            modulation[i] = std::sin (juce::MathConstants<float>::twoPi * vibratoRate * (float) i / sampleRate);
+        
+        for (int index = 0; index < 2; ++index)
+        {
+            OscillatorBank bank;
+            bank.prepareToPlay (1, sampleRate, controlPeriod);
+            bank.setSineKernel (index == 0 ? SineKernels::Type::standard : SineKernels::Type::phasor);
+            bank.setFrequency (0, 3800.0f);
+            bank.setModulation (0, 0, 760.0f);
+            bank.setTargets (0, 1.0f, 0.0f);
+            rendered[index].clear();
+            
+            for (int start = 0; start < numSamples; start += controlPeriod)
+            {
+                const float* modulators[] = { modulation + start };
+                bank.render (rendered[index].getWritePointer (0, start), rendered[index].getWritePointer (1, start), controlPeriod, modulators);
+            }
+        }
+        
+        float maxError = 0.0f;
+        
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                maxError = juce::jmax (maxError, std::abs (rendered[1].getSample (channel, i) - rendered[0].getSample (channel, i)));
+        
+        return maxError;
+    }
+};
+
+static SineKernelsTests sineKernelsTests;
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+
+//================================================//
+/// Sine implementations used by the oscillator bank, each returning sin (2 pi phase) one SIMD register at a time.
+/// Worst case errors against sin, measured over [0,1] and checked by the unit tests:
+///     standard    std::sin per lane, the reference, below 1e-6.
+///     wavetable   linear interpolation in a 2048 point table, below 1.3e-6.
+///     polynomial  quarter period folding and a degree 9 minimax odd polynomial, below 2e-7.
+///     phasor      complex rotation resynchronised every render call, whose increment is fitted to the
+///                 modulation once per call. Against the standard kernel, below 1e-5 unmodulated at a 64
+///                 sample control period and 5e-5 at 256, and 2e-4 under a 5 Hz vibrato at 64.
+
+class SineKernels
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    
+    /// Sine implementations.
+    enum class Type
+    {
+        standard,                                                           // std::sin per lane.
+        wavetable,                                                          // Interpolated wavetable lookup.
+        polynomial,                                                         // Polynomial on a folded phase.
+        phasor                                                              // Rotating complex phasor.
+    };
+    
+    static constexpr int numTypes = 4;                                      // Number of sine implementations.
+    
+    // Init methods.
+    static void prepareWavetable();
+    
+    // Getter methods.
+    static const char* getName (Type type);
+    
+    // Kernel methods.
+    static Register getStandard (Register phase);
+    static Register getWavetable (Register phase);
+    static Register getPolynomial (Register phase);
+    static void getRotation (Register angle, Register& cosine, Register& sine);
+    
+    // Benchmark methods.
+    static juce::String runBenchmark (int numPartials, int numSamples);
+    
+private:
+    static constexpr int wavetableSize = 2048;                              // Number of points in one period of the wavetable.
+    static const float* getWavetableData();
+};
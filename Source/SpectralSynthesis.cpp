@@ -0,0 +1,255 @@
+#include "Headers.h"
+
+
+//================================================//
+// Inverse FFT additive synthesiser.
+
+SpectralSynthesis::SpectralSynthesis() {}
+
+SpectralSynthesis::~SpectralSynthesis() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Allocates storage for a number of partials and resets them to silence.
+    Partials start on scattered phases so they don't all peak together.
+    @param numPartials Number of partials.
+    @param sampleRate Sample rate to use.
+ */
+
+void SpectralSynthesis::prepareToPlay (int numPartials, float sampleRate)
+{
+    m_NumPartials = numPartials;
+    m_SampleRate = sampleRate;
+    m_FFTSize = 1 << Variables::spectralFFTOrder;
+    m_HopSize = m_FFTSize / Variables::spectralOverlap;
+    m_ReadPosition = m_HopSize;
+    m_NumSilentFrames = Variables::spectralOverlap;
+    
+    m_FFT = std::make_unique<juce::dsp::FFT> (Variables::spectralFFTOrder);
+    m_Spectrum.calloc ((size_t) m_FFTSize);
+    m_Frame.calloc ((size_t) m_FFTSize);
+    m_AccumulatorLeft.calloc ((size_t) m_FFTSize);
+    m_AccumulatorRight.calloc ((size_t) m_FFTSize);
+    
+    // Spectrum of a Hann window centred on sample 0, which is real since the window is symmetric.
+    const int numWindowValues = 2 * lobeHalfWidth * lobeOversampling + 2;
+    m_WindowSpectrum.calloc ((size_t) numWindowValues);
+    
+    for (int i = 0; i < numWindowValues; ++i)
+    {
+        double binOffset = (double) i / lobeOversampling - lobeHalfWidth;
+        double sum = 0.0;
+        
+        for (int n = 1 - m_FFTSize / 2; n < m_FFTSize / 2; ++n)
+        {
+            double angle = juce::MathConstants<double>::twoPi * n / m_FFTSize;
+            sum += (0.5 + 0.5 * std::cos (angle)) * std::cos (angle * binOffset);
+        }
+        
+        m_WindowSpectrum[i] = (float) sum;
+    }
+    
+    // Silent until setPartial is called.
+    m_Bins.calloc ((size_t) numPartials);
+    m_LeftGains.calloc ((size_t) numPartials);
+    m_RightGains.calloc ((size_t) numPartials);
+    m_PhaseReal.calloc ((size_t) numPartials);
+    m_PhaseImaginary.calloc ((size_t) numPartials);
+    m_RotationReal.calloc ((size_t) numPartials);
+    m_RotationImaginary.calloc ((size_t) numPartials);
+    
+    juce::Random random (numPartials);
+    
+    for (int partial = 0; partial < numPartials; ++partial)
+    {
+        float phase = random.nextFloat() * juce::MathConstants<float>::twoPi;
+        m_PhaseReal[partial] = std::cos (phase);
+        m_PhaseImaginary[partial] = std::sin (phase);
+        m_RotationReal[partial] = 1.0f;
+    }
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the frequency, gain and pan of a partial. Partials too close to Nyquist to be
+    rendered without aliasing stay silent.
+    @param partial Index of the partial.
+    @param frequency Frequency in Hz.
+    @param gain Gain applied to the amplitude passed to render.
+    @param pan Pan in range [-1,1], with the same law as Panner.
+ */
+
+void SpectralSynthesis::setPartial (int partial, float frequency, float gain, float pan)
+{
+    float bin = frequency * (float) m_FFTSize / m_SampleRate;
+    
+    if (bin <= 0.0f || bin >= (float) (m_FFTSize / 2 - lobeHalfWidth - 1))
+        gain = 0.0f;
+    
+    // Halves the amplitude shared by the positive and negative frequency lobes, and undoes
+    // the overlapping Hann windows summing to half the overlap factor.
+    gain /= (float) Variables::spectralOverlap;
+    
+    m_Bins[partial] = bin;
+    m_LeftGains[partial] = gain * (1.0f - juce::jmax (pan, 0.0f));
+    m_RightGains[partial] = gain * (1.0f + juce::jmin (pan, 0.0f));
+    
+    float rotation = juce::MathConstants<float>::twoPi * frequency * (float) m_HopSize / m_SampleRate;
+    m_RotationReal[partial] = std::cos (rotation);
+    m_RotationImaginary[partial] = std::sin (rotation);
+}
+
+
+//================================================//
+// Getter methods.
+
+int SpectralSynthesis::getNumPartials()                             { return m_NumPartials; }
+int SpectralSynthesis::getFFTSize()                                 { return m_FFTSize; }
+int SpectralSynthesis::getHopSize()                                 { return m_HopSize; }
+
+/**
+    Returns true once every frame overlapping the next hop was built without an audible partial.
+ */
+
+bool SpectralSynthesis::isSilent()
+{
+    return m_NumSilentFrames >= Variables::spectralOverlap;
+}
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Renders every partial and adds the result to a stereo pair of buffers.
+    Amplitudes are read once per hop, and successive frames crossfade between them.
+    @param left Left channel, numSamples samples are added to it.
+    @param right Right channel, numSamples samples are added to it.
+    @param numSamples Number of samples.
+    @param amplitudes Amplitude of each partial, zero for silent partials.
+ */
+
+void SpectralSynthesis::render (float* left, float* right, int numSamples, const float* amplitudes)
+{
+    while (numSamples > 0)
+    {
+        if (m_ReadPosition == m_HopSize)
+        {
+            synthesiseFrame (amplitudes);
+            m_ReadPosition = 0;
+        }
+        
+        int numReady = juce::jmin (numSamples, m_HopSize - m_ReadPosition);
+        
+        for (int i = 0; i < numReady; ++i)
+        {
+            left[i] += m_AccumulatorLeft[m_ReadPosition + i];
+            right[i] += m_AccumulatorRight[m_ReadPosition + i];
+        }
+        
+        left += numReady;
+        right += numReady;
+        numSamples -= numReady;
+        m_ReadPosition += numReady;
+    }
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Builds the spectrum of the next frame from every audible partial, turns it into a frame
+    with one inverse FFT and adds it to the accumulators. The left channel is kept in the real
+    part and the right channel in the imaginary part, so both come out of the same transform.
+    @param amplitudes Amplitude of each partial.
+ */
+
+void SpectralSynthesis::synthesiseFrame (const float* amplitudes)
+{
+    const int mask = m_FFTSize - 1;
+    
+    bool frameIsSilent = true;
+    
+    std::fill (m_Spectrum.get(), m_Spectrum.get() + m_FFTSize, Complex());
+    
+    for (int partial = 0; partial < m_NumPartials; ++partial)
+    {
+        float phaseReal = m_PhaseReal[partial];
+        float phaseImaginary = m_PhaseImaginary[partial];
+        float amplitude = amplitudes[partial];
+        
+        if (amplitude > 0.0f && m_Bins[partial] > 0.0f)
+        {
+            frameIsSilent = false;
+            
+            float leftGain = m_LeftGains[partial];
+            float rightGain = m_RightGains[partial];
+            float real = amplitude * phaseReal;
+            float imaginary = amplitude * phaseImaginary;
+            
+            // Positive and negative frequency lobes of both channels, pre-multiplied by left + i right.
+            Complex positive (leftGain * real - rightGain * imaginary, leftGain * imaginary + rightGain * real);
+            Complex negative (leftGain * real + rightGain * imaginary, rightGain * real - leftGain * imaginary);
+            
+            float bin = m_Bins[partial];
+            
+            for (int k = (int) std::ceil (bin - lobeHalfWidth); (float) k <= bin + lobeHalfWidth; ++k)
+            {
+                float window = getWindowSpectrum ((float) k - bin);
+                m_Spectrum[k & mask] += window * positive;
+                m_Spectrum[-k & mask] += window * negative;
+            }
+        }
+        
+        // Moves the phase on by one hop, pulling its magnitude back to 1 so rounding errors don't build up.
+        float nextReal = phaseReal * m_RotationReal[partial] - phaseImaginary * m_RotationImaginary[partial];
+        float nextImaginary = phaseReal * m_RotationImaginary[partial] + phaseImaginary * m_RotationReal[partial];
+        float correction = 1.5f - 0.5f * (nextReal * nextReal + nextImaginary * nextImaginary);
+        
+        m_PhaseReal[partial] = nextReal * correction;
+        m_PhaseImaginary[partial] = nextImaginary * correction;
+    }
+    
+    m_NumSilentFrames = frameIsSilent ? m_NumSilentFrames + 1 : 0;
+    
+    // The last hop has been rendered, so the accumulators move on by one hop.
+    std::memmove (m_AccumulatorLeft.get(), m_AccumulatorLeft + m_HopSize, sizeof (float) * (size_t) (m_FFTSize - m_HopSize));
+    std::memmove (m_AccumulatorRight.get(), m_AccumulatorRight + m_HopSize, sizeof (float) * (size_t) (m_FFTSize - m_HopSize));
+    std::fill (m_AccumulatorLeft + m_FFTSize - m_HopSize, m_AccumulatorLeft + m_FFTSize, 0.0f);
+    std::fill (m_AccumulatorRight + m_FFTSize - m_HopSize, m_AccumulatorRight + m_FFTSize, 0.0f);
+    
+    // An empty spectrum would only add zeros, so the transform is skipped.
+    if (frameIsSilent)
+        return;
+    
+    m_FFT->perform (m_Spectrum.get(), m_Frame.get(), true);
+    
+    // The frame is centred on index 0, so its first half wraps around the end.
+    for (int i = 0; i < m_FFTSize; ++i)
+    {
+        const Complex& sample = m_Frame[(i + m_FFTSize / 2) & mask];
+        m_AccumulatorLeft[i] += sample.real();
+        m_AccumulatorRight[i] += sample.imag();
+    }
+}
+
+/**
+    Returns the spectrum of the centred Hann window at a distance from its peak.
+    @param binOffset Distance in bins, in range [-lobeHalfWidth,lobeHalfWidth].
+ */
+
+float SpectralSynthesis::getWindowSpectrum (float binOffset)
+{
+    float position = (binOffset + (float) lobeHalfWidth) * (float) lobeOversampling;
+    int index = juce::jlimit (0, 2 * lobeHalfWidth * lobeOversampling, (int) position);
+    float fraction = position - (float) index;
+    
+    return m_WindowSpectrum[index] + fraction * (m_WindowSpectrum[index + 1] - m_WindowSpectrum[index]);
+}
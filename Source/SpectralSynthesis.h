@@ -0,0 +1,66 @@
+#pragma once
+
+
+//================================================//
+/// Additive synthesiser rendering a large number of sine partials with an inverse FFT.
+/// Every hop, each audible partial writes the spectrum of a Hann windowed sinusoid into a few bins
+/// around its frequency, and one inverse FFT turns the whole spectrum into a frame of both channels.
+/// Frames are overlap-added, so the cost grows with the FFT size and the number of audible partials,
+/// and no longer with the number of partials times the number of samples.
+
+class SpectralSynthesis
+{
+public:
+    using Complex = juce::dsp::Complex<float>;
+    
+    SpectralSynthesis();
+    ~SpectralSynthesis();
+    
+    // Init methods.
+    void prepareToPlay (int numPartials, float sampleRate);
+    
+    // Setter methods.
+    void setPartial (int partial, float frequency, float gain, float pan);
+    
+    // Getter methods.
+    int getNumPartials();
+    int getFFTSize();
+    int getHopSize();
+    bool isSilent();
+    
+    // DSP methods.
+    void render (float* left, float* right, int numSamples, const float* amplitudes);
+
+private:
+    // Helper methods.
+    void synthesiseFrame (const float* amplitudes);
+    float getWindowSpectrum (float binOffset);
+    
+    static constexpr int lobeHalfWidth = 4;                                 // Number of bins written on each side of a partial.
+    static constexpr int lobeOversampling = 64;                             // Number of window spectrum values stored per bin.
+    
+    std::unique_ptr<juce::dsp::FFT> m_FFT;                                  // Inverse FFT turning each spectrum into a frame.
+    juce::HeapBlock<Complex> m_Spectrum;                                    // Spectrum of the next frame, left channel real and right channel imaginary.
+    juce::HeapBlock<Complex> m_Frame;                                       // Output of the inverse FFT, centred on index 0.
+    juce::HeapBlock<float> m_WindowSpectrum;                                // Spectrum of the centred Hann window across the written bins.
+    
+    juce::HeapBlock<float> m_Bins;                                          // Frequency of each partial in bins.
+    juce::HeapBlock<float> m_LeftGains;                                     // Left gain of each partial, including pan and normalisation.
+    juce::HeapBlock<float> m_RightGains;                                    // Right gain of each partial, including pan and normalisation.
+    juce::HeapBlock<float> m_PhaseReal;                                     // Cosine of the phase of each partial at the next frame centre.
+    juce::HeapBlock<float> m_PhaseImaginary;                                // Sine of the phase of each partial at the next frame centre.
+    juce::HeapBlock<float> m_RotationReal;                                  // Cosine of the phase each partial moves by in one hop.
+    juce::HeapBlock<float> m_RotationImaginary;                             // Sine of the phase each partial moves by in one hop.
+    
+    juce::HeapBlock<float> m_AccumulatorLeft;                               // Left overlap-add accumulator, one FFT size long.
+    juce::HeapBlock<float> m_AccumulatorRight;                              // Right overlap-add accumulator, one FFT size long.
+    
+    int m_NumPartials = 0;                                                  // Number of partials.
+    int m_FFTSize = 0;                                                      // Number of samples in a frame.
+    int m_HopSize = 0;                                                      // Number of samples between two frames.
+    int m_ReadPosition = 0;                                                 // Samples of the current hop already rendered.
+    int m_NumSilentFrames = 0;                                              // Number of frames in a row without an audible partial.
+    float m_SampleRate = 44100.0f;                                          // Sample rate.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralSynthesis)
+};
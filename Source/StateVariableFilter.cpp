@@ -0,0 +1,159 @@
+#include "Headers.h"
+
+
+//================================================//
+// Topology-preserving transform state variable filter.
+
+StateVariableFilter::StateVariableFilter()
+{
+    reset();
+}
+
+StateVariableFilter::~StateVariableFilter() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Prepares the filter for a sample rate and clears its state.
+    @param sampleRate Sample rate to use.
+ */
+
+void StateVariableFilter::prepareToPlay (float sampleRate)
+{
+    m_SampleRate = sampleRate;
+    reset();
+}
+
+/**
+    Clears the state of the filter. The next block starts at its first cutoff rather than gliding to it.
+ */
+
+void StateVariableFilter::reset()
+{
+    m_Integrator1 = Register::expand (0.0f);
+    m_Integrator2 = Register::expand (0.0f);
+    m_GainIsSet = false;
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the resonance of the filter. Can be called from any thread.
+    @param resonance Q factor in range [minResonance, maxResonance], 0.7071 is the flattest low pass.
+ */
+
+void StateVariableFilter::setResonance (float resonance)
+{
+    m_Resonance.store (juce::jlimit (minResonance, maxResonance, resonance), std::memory_order_relaxed);
+}
+
+/**
+    Sets the output produced by the filter. Can be called from any thread.
+    @param output Output to produce.
+ */
+
+void StateVariableFilter::setOutput (Output output)
+{
+    m_Output.store (output, std::memory_order_relaxed);
+}
+
+
+//================================================//
+// Getter methods.
+
+float StateVariableFilter::getResonance()                           { return m_Resonance.load (std::memory_order_relaxed); }
+StateVariableFilter::Output StateVariableFilter::getOutput()        { return m_Output.load (std::memory_order_relaxed); }
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Filters a stereo pair of buffers in place.
+    @param left Left channel.
+    @param right Right channel.
+    @param cutoffs Cutoff frequency in Hz of every sample.
+    @param numSamples Number of samples.
+ */
+
+void StateVariableFilter::processStereo (float* left, float* right, const float* cutoffs, int numSamples)
+{
+    const float damping = 1.0f / getResonance();
+    const Output output = getOutput();
+    
+    // Every output is a mix of the input, the band pass and the low pass.
+    const Register inputMix = Register::expand (output == Output::highPass ? 1.0f : 0.0f);
+    const Register bandMix = Register::expand (output == Output::bandPass ? damping : output == Output::highPass ? -damping : 0.0f);
+    const Register lowMix = Register::expand (output == Output::lowPass ? 1.0f : output == Output::highPass ? -1.0f : 0.0f);
+    
+    alignas (Register::SIMDRegisterSize) float lanes[Register::SIMDNumElements] = {};
+    
+    Register integrator1 = m_Integrator1;
+    Register integrator2 = m_Integrator2;
+    
+    for (int start = 0; start < numSamples; start += Variables::filterControlPeriod)
+    {
+        int numToProcess = juce::jmin (Variables::filterControlPeriod, numSamples - start);
+        
+        // The gain is computed at the last sample of each period and ramped towards from the previous one.
+        float endGain = getGain (cutoffs[start + numToProcess - 1]);
+        
+        if (! m_GainIsSet)
+        {
+            m_Gain = endGain;
+            m_GainIsSet = true;
+        }
+        
+        float gainIncrement = (endGain - m_Gain) / (float) numToProcess;
+        
+        for (int i = start; i < start + numToProcess; ++i)
+        {
+            m_Gain += gainIncrement;
+            
+            float a1 = 1.0f / (1.0f + m_Gain * (m_Gain + damping));
+            float a2 = m_Gain * a1;
+            float a3 = m_Gain * a2;
+            
+            lanes[0] = left[i];
+            lanes[1] = right[i];
+            
+            Register input = Register::fromRawArray (lanes);
+            Register v3 = input - integrator2;
+            Register band = integrator1 * a1 + v3 * a2;
+            Register low = integrator2 + integrator1 * a2 + v3 * a3;
+            
+            integrator1 = band * 2.0f - integrator1;
+            integrator2 = low * 2.0f - integrator2;
+            
+            (input * inputMix + band * bandMix + low * lowMix).copyToRawArray (lanes);
+            
+            left[i] = lanes[0];
+            right[i] = lanes[1];
+        }
+        
+        m_Gain = endGain;
+    }
+    
+    m_Integrator1 = integrator1;
+    m_Integrator2 = integrator2;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Returns the prewarped integrator gain for a cutoff, which puts the cutoff of the
+    trapezoidal integrators exactly where the analogue filter would have it.
+    @param cutoff Cutoff in Hz, limited to [0, maxCutoff] times the sample rate.
+ */
+
+float StateVariableFilter::getGain (float cutoff)
+{
+    float normalisedCutoff = juce::jlimit (0.0f, maxCutoff, cutoff / m_SampleRate);
+    return std::tan (juce::MathConstants<float>::pi * normalisedCutoff);
+}
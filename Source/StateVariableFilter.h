@@ -0,0 +1,61 @@
+#pragma once
+
+
+//================================================//
+/// Stereo state variable filter built with the topology-preserving transform (trapezoidal integrators),
+/// so its cutoff can move every sample without zipper noise or the blow-ups of a modulated biquad.
+/// Both channels share one SIMD register, left in the first lane and right in the second, and share
+/// their coefficients. The cutoff is read per sample from a buffer, but the costly tan prewarping is only
+/// computed every Variables::filterControlPeriod samples, with the coefficient ramped linearly in between.
+/// The low pass, band pass and high pass outputs all come out of the same state, and can be switched freely.
+
+class StateVariableFilter
+{
+public:
+    using Register = juce::dsp::SIMDRegister<float>;
+    
+    /// Outputs the filter can produce.
+    enum class Output
+    {
+        lowPass,                                                            // 12 dB per octave low pass.
+        bandPass,                                                           // Band pass with a peak gain of 1.
+        highPass                                                            // 12 dB per octave high pass.
+    };
+    
+    static constexpr float minResonance = 0.1f;                             // Lowest resonance, as a Q factor.
+    static constexpr float maxResonance = 20.0f;                            // Highest resonance, as a Q factor.
+    static constexpr float maxCutoff = 0.49f;                               // Highest cutoff as a fraction of the sample rate.
+    
+    StateVariableFilter();
+    ~StateVariableFilter();
+    
+    // Init methods.
+    void prepareToPlay (float sampleRate);
+    void reset();
+    
+    // Setter methods.
+    void setResonance (float resonance);
+    void setOutput (Output output);
+    
+    // Getter methods.
+    float getResonance();
+    Output getOutput();
+    
+    // DSP methods.
+    void processStereo (float* left, float* right, const float* cutoffs, int numSamples);
+
+private:
+    // Helper methods.
+    float getGain (float cutoff);
+    
+    Register m_Integrator1;                                                 // State of the band pass integrator, left and right.
+    Register m_Integrator2;                                                 // State of the low pass integrator, left and right.
+    float m_Gain = 0.0f;                                                    // Prewarped integrator gain reached by the last sample.
+    bool m_GainIsSet = false;                                               // Whether the gain has been set since the filter was reset.
+    
+    std::atomic<float> m_Resonance { Variables::filterResonance };          // Resonance set by the caller.
+    std::atomic<Output> m_Output { Output::lowPass };                       // Output set by the caller.
+    float m_SampleRate = 44100.0f;                                          // Sample rate.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StateVariableFilter)
+};
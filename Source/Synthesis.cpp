@@ -12,12 +12,8 @@
 Synthesis::Synthesis (Grid& grid)
     :   m_Grid (grid)
 {
-    // Init oscillators.
-    m_Oscillators.ensureStorageAllocated (Variables::numOscillators);
-    m_Oscillators.ensureStorageAllocated (Variables::numLFOs);
-    
-    for (int i = 0; i < Variables::numOscillators; ++i)
-        m_Oscillators.add (new SineOscillator());
+    // Init LFOs, the oscillators themselves live in the oscillator bank.
+    m_LFOs.ensureStorageAllocated (Variables::numLFOs);
     
     for (int i = 0; i < Variables::numLFOs; ++i)
         m_LFOs.add (new SineOscillator);
@@ -32,77 +28,218 @@ Synthesis::~Synthesis() {}
 void Synthesis::setBlockSize (int blockSize)                        { m_BlockSize = blockSize; }
 void Synthesis::setSampleRate (float sampleRate)                    { m_SampleRate = sampleRate; }
 
+/**
+    Sets how often gains, pans and fades are computed. Values in between are smoothed.
+    @param controlPeriod Number of samples between two updates, 1 updates every sample.
+ */
+
+void Synthesis::setControlPeriod (int controlPeriod)
+{
+    m_ControlPeriod = juce::jmax (1, controlPeriod);
+}
+
+/**
+    Sets the engine used to render the grid. Both engines are prepared by prepareToPlay,
+    so switching never allocates.
+    @param engine Engine to use.
+ */
+
+void Synthesis::setEngine (Engine engine)
+{
+    m_Engine = engine;
+}
+
 
 //================================================//
 // Getter methods.
 
 int Synthesis::getBlockSize()                                       { return m_BlockSize; }
 float Synthesis::getSampleRate()                                    { return m_SampleRate; }
+int Synthesis::getControlPeriod()                                   { return m_ControlPeriod; }
+Synthesis::Engine Synthesis::getEngine()                            { return m_Engine; }
+
+/**
+    Returns the most recently published cell states and fade values, downsampled to at most
+    Variables::maxDisplayNumRows by Variables::maxDisplayNumColumns cells.
+    Never blocks, but must only be called from a single reader thread (the message thread),
+    which holds getDisplayLock for as long as it reads the snapshot.
+ */
+
+GridSnapshot& Synthesis::getDisplaySnapshot()
+{
+    return m_DisplaySnapshots.getReadBuffer();
+}
+
+/**
+    Returns the lock prepareToPlay holds while resizing the display snapshots. The reader of
+    getDisplaySnapshot holds it too, so a snapshot is never reallocated while it is being read.
+ */
+
+juce::CriticalSection& Synthesis::getDisplayLock()
+{
+    return m_DisplayLock;
+}
+
+/**
+    Returns the profiler timing each stage of processBlock.
+    Its statistics must only be read from a single reader thread (the message thread).
+ */
+
+Profiler& Synthesis::getProfiler()
+{
+    return m_Profiler;
+}
+
+/**
+    Returns the reverb, whose room size and decay time can be set from any thread.
+ */
+
+FDNReverb& Synthesis::getReverb()
+{
+    return m_Reverb;
+}
+
+/**
+    Returns the convolution reverb, which impulse responses can be loaded into from any thread but the audio thread.
+ */
+
+ConvolutionReverb& Synthesis::getConvolutionReverb()
+{
+    return m_ConvolutionReverb;
+}
+
+/**
+    Returns the filter, whose resonance and output can be set from any thread.
+ */
+
+StateVariableFilter& Synthesis::getFilter()
+{
+    return m_Filter;
+}
+
+/**
+    Returns the tanh distortion, whose drive and oversampling can be set from any thread.
+ */
+
+Saturator& Synthesis::getSaturator()
+{
+    return m_Saturator;
+}
+
+/**
+    Returns the oscillator bank, whose sine implementation can be set from any thread.
+ */
+
+OscillatorBank& Synthesis::getOscillatorBank()
+{
+    return m_OscillatorBank;
+}
+
+/**
+    Returns the limiter, whose ceiling can be set and whose gain reduction can be metered from any thread.
+ */
+
+TruePeakLimiter& Synthesis::getLimiter()
+{
+    return m_Limiter;
+}
+
+/**
+    Returns the delay in samples added to the output by the signal chain, to be reported to the host.
+ */
+
+int Synthesis::getLatencySamples()
+{
+    return m_Saturator.getLatencySamples() + m_Limiter.getLatencySamples();
+}
 
 
 //================================================//
 // Helper methods.
 
 /**
-    Returns a float representing a gain value for a given oscillator.
+    Returns the first grid column mapped to a given oscillator.
+    Columns are split into equal blocks derived from the current grid size.
+    @param oscillatorIndex Index of an oscillator.
+ */
+
+int Synthesis::getStartColumn (int oscillatorIndex)
+{
+    return oscillatorIndex * m_NumColumns / Variables::numOscillators;
+}
+
+/**
+    Returns the grid column after the last one mapped to a given oscillator.
     @param oscillatorIndex Index of an oscillator.
  */
 
+int Synthesis::getEndColumn (int oscillatorIndex)
+{
+    return (oscillatorIndex + 1) * m_NumColumns / Variables::numOscillators;
+}
+
+/**
+    Returns a float representing a gain value for a given oscillator.
+    Uses the sum of the oscillator's fades, kept up to date as they move.
+    @param oscillatorIndex Index of an oscillator.
+ */
 
 float Synthesis::getOscillatorGain (int oscillatorIndex)
 {
-    float gain = 0;
-    
-    float startColumn = oscillatorIndex * (Variables::numColumns / Variables::numOscillators);
-    float endColumn = startColumn + (Variables::numColumns / Variables::numOscillators);
+    int numRows = m_NumRows;
+    int startColumn = getStartColumn (oscillatorIndex);
+    int endColumn = getEndColumn (oscillatorIndex);
     
-    //Sum all fade values in a block of cells.
-    for (int column = startColumn; column < endColumn; ++column)
-    {
-        for (int row = 0; row < Variables::numRows; ++row)
-            gain += m_Grid.getCell (row, column)->getFade();
-    }
+    // Grids narrower than the number of oscillators leave some oscillators without cells.
+    if (endColumn == startColumn)
+        return 0;
     
     // Normalize value to range [0,1].
-    gain /= (float)Variables::numRows * (float)Variables::numColumns / (float)Variables::numOscillators;
-    
-    return gain;
+    return (float) (m_OscillatorFades[oscillatorIndex] / ((double) numRows * (double) (endColumn - startColumn)));
 }
 
 /**
     Returns a float representing the pan value for a given oscillator.
+    Top half of the grid pans left, bottom half pans right.
     @param oscillatorIndex Index of an oscillator.
  */
 
 float Synthesis::getOscillatorPan (int oscillatorIndex)
 {
-    float pan = 0;
-    
-    float startColumn = oscillatorIndex * (Variables::numColumns / Variables::numOscillators);
-    float endColumn = startColumn + (Variables::numColumns / Variables::numOscillators);
-    
-    for (int column = startColumn; column < endColumn; ++column)
-    {
-        for (int row = 0; row < Variables::numRows; ++row)
-        {
-            Cell& cell = *m_Grid.getCell (row, column);
-            
-            if (row < Variables::numRows / 2)
-                pan += cell.getFade();
-            
-            else
-                pan -= cell.getFade();
-        }
-    }
+    int numRows = m_NumRows;
+    int startColumn = getStartColumn (oscillatorIndex);
+    int endColumn = getEndColumn (oscillatorIndex);
     
-    pan /= Variables::numRows * (endColumn - startColumn) / 2.0;
+    if (endColumn == startColumn)
+        return 0;
     
-    if (pan > 1.0)
-        pan = 1.0;
-    else if (pan < -1.0)
-        pan = -1.0;
+    double pan = m_OscillatorPans[oscillatorIndex] / (numRows * (endColumn - startColumn) / 2.0);
     
-    return pan;
+    return (float) juce::jlimit (-1.0, 1.0, pan);
+}
+
+/**
+    Returns the number of grid rows in a tile, which is less than Variables::tileNumRows
+    for the bottom tiles of grids whose height isn't a multiple of it.
+    @param tileIndex Index of a tile.
+ */
+
+int Synthesis::getTileNumRows (int tileIndex)
+{
+    return juce::jmin (Variables::tileNumRows, m_NumRows - tileIndex / m_NumTileColumns * Variables::tileNumRows);
+}
+
+/**
+    Returns the first grid row or column behind a row or column of the display snapshots.
+    Grids no larger than the display map one to one, larger ones are split into nearly equal blocks.
+    @param displayIndex Index of a display row or column.
+    @param numDisplayCells Number of display rows or columns.
+    @param numCells Number of grid rows or columns.
+ */
+
+int Synthesis::getDisplayStart (int displayIndex, int numDisplayCells, int numCells)
+{
+    return (int) (((juce::int64) displayIndex * numCells + numDisplayCells - 1) / numDisplayCells);
 }
 
 /**
@@ -117,23 +254,210 @@ float Synthesis::getSpectralGainDecay (float gain, float frequency)
     return gain * Variables::startFrequency * (1.0f / frequency) ;
 }
 
+/**
+    Returns the frequency of the partial of a cell used by the spectral engine.
+    Columns glide between the frequencies of the oscillators they would be mapped to,
+    and rows detune them slightly around that.
+    @param oscillatorFrequencies Frequency of every oscillator, plus the one after the last.
+    @param row Row index.
+    @param column Column index.
+ */
+
+float Synthesis::getCellFrequency (const float* oscillatorFrequencies, int row, int column)
+{
+    float position = (float) column * Variables::numOscillators / (float) m_NumColumns;
+    int oscillatorIndex = juce::jmin ((int) position, Variables::numOscillators - 1);
+    float ratio = oscillatorFrequencies[oscillatorIndex + 1] / oscillatorFrequencies[oscillatorIndex];
+    
+    float frequency = oscillatorFrequencies[oscillatorIndex] * std::pow (ratio, position - (float) oscillatorIndex);
+    return frequency * (1.0f + Variables::spectralRowSpread * (((float) row + 0.5f) / (float) m_NumRows - 0.5f));
+}
+
 
 //================================================//
 // State methods.
 
 /**
-    Updates fade values of a block of cells given an oscillator.
+    Moves fades towards the cell states of the latest grid snapshot, for a control period.
+    Rows of fading tiles are taken in turn, each moved for as long as it was last moved,
+    until Variables::maxFadeCellsPerSample cells per sample of the period have been moved,
+    so the cost of a period doesn't grow with the grid. Rows left out catch up on later periods.
+    @param numSamples Number of samples in the control period.
+ */
+
+void Synthesis::updateFadeValues (int numSamples)
+{
+    m_FadeTime += numSamples;
+    
+    int numTiles = m_NumTileRows * m_NumTileColumns;
+    int numTileRows = numTiles * Variables::tileNumRows;
+    int numCellsLeft = Variables::maxFadeCellsPerSample * numSamples;
+    
+    // Stops after a whole lap, whether or not the budget is spent.
+    for (int numRowsVisited = 0; numRowsVisited < numTileRows && numCellsLeft > 0;)
+    {
+        int tileIndex = m_NextFadeRow / Variables::tileNumRows;
+        int row = tileIndex / m_NumTileColumns * Variables::tileNumRows + m_NextFadeRow % Variables::tileNumRows;
+        
+        // Settled tiles, and rows past the bottom of the grid, are skipped a tile at a time.
+        if (m_TileNumFadingRows[tileIndex] == 0 || row >= m_NumRows)
+        {
+            numRowsVisited += Variables::tileNumRows - m_NextFadeRow % Variables::tileNumRows;
+            m_NextFadeRow = (tileIndex + 1) % numTiles * Variables::tileNumRows;
+            continue;
+        }
+        
+        juce::int64& rowTime = m_RowFadeTimes[m_NextFadeRow];
+        juce::int64 endTime = juce::jmin (m_FadeTime, m_TileSettleTimes[tileIndex]);
+        
+        if (rowTime < endTime)
+        {
+            int tileNumColumns = Variables::tileNumWords * 64;
+            int startColumn = tileIndex % m_NumTileColumns * tileNumColumns;
+            
+            updateFadeRow (tileIndex, row, Variables::fadeAmount * (float) (endTime - rowTime));
+            numCellsLeft -= juce::jmin (tileNumColumns, m_NumColumns - startColumn);
+            
+            rowTime = endTime;
+            
+            if (rowTime == m_TileSettleTimes[tileIndex])
+                --m_TileNumFadingRows[tileIndex];
+        }
+        
+        ++numRowsVisited;
+        m_NextFadeRow = (m_NextFadeRow + 1) % numTileRows;
+    }
+}
+
+/**
+    Moves the fades of one row of a grid tile, and adds how much they moved to the sums of
+    the oscillators and display cells they belong to. The row is split wherever either changes.
+    @param tileIndex Index of the tile.
+    @param row Row index, within the grid.
+    @param fadeAmount Amount each fade moves by.
+ */
+
+void Synthesis::updateFadeRow (int tileIndex, int row, float fadeAmount)
+{
+    int tileNumColumns = Variables::tileNumWords * 64;
+    int tileStartColumn = tileIndex % m_NumTileColumns * tileNumColumns;
+    int tileEndColumn = juce::jmin (tileStartColumn + tileNumColumns, m_NumColumns);
+    
+    float* fades = m_Fades.getRow (row).data();
+    const juce::uint64* words = m_Snapshot->getRow (row);
+    double* displayFades = m_DisplayFades + (juce::int64) row * m_NumDisplayRows / m_NumRows * m_NumDisplayColumns;
+    
+    int oscillatorIndex = 0;
+    int displayColumn = (int) ((juce::int64) tileStartColumn * m_NumDisplayColumns / m_NumColumns);
+    
+    for (int startColumn = tileStartColumn; startColumn < tileEndColumn;)
+    {
+        // Oscillators without cells end where they start, and are stepped over.
+        while (getEndColumn (oscillatorIndex) <= startColumn)
+            ++oscillatorIndex;
+        
+        int displayEndColumn = getDisplayStart (displayColumn + 1, m_NumDisplayColumns, m_NumColumns);
+        int endColumn = juce::jmin (tileEndColumn, getEndColumn (oscillatorIndex), displayEndColumn);
+        
+        float change = FadeKernel::updateFades (fades, words, startColumn, endColumn, fadeAmount);
+        
+        m_OscillatorFades[oscillatorIndex] += change;
+        m_OscillatorPans[oscillatorIndex] += row < m_NumRows / 2 ? change : -change;
+        displayFades[displayColumn] += change;
+        
+        if (endColumn == displayEndColumn)
+            ++displayColumn;
+        
+        startColumn = endColumn;
+    }
+}
+
+/**
+    Sets the gain and pan an oscillator reaches at the end of a control period, from its
+    fades, which updateFadeValues has already moved forward by that period.
     @param oscillatorIndex Index of an oscillator.
  */
 
-void Synthesis::updateFadeValues (int oscillatorIndex)
+void Synthesis::updateControlValues (int oscillatorIndex)
 {
-    float startColumn = oscillatorIndex * (Variables::numColumns / Variables::numOscillators);
-    float endColumn = startColumn + (Variables::numColumns / Variables::numOscillators);
+    // The bank applies the spectral gain decay, which follows the modulated frequency.
+    m_OscillatorBank.setTargets (oscillatorIndex, getOscillatorGain (oscillatorIndex), getOscillatorPan (oscillatorIndex));
+}
+
+/**
+    Marks the tiles which changed in new grid generations as fading, until their fades have
+    had time to go all the way between 0 and 1. Uses the tile changes reported by the grid
+    when no generation was missed, otherwise every tile is marked.
+    Rows a fade update hadn't reached yet keep the time they are owed, which then moves them
+    towards the new cell states.
+ */
+
+void Synthesis::updateActiveTiles()
+{
+    juce::int64 generation = m_Snapshot->getGeneration();
+    
+    if (generation == m_LastGeneration)
+        return;
+    
+    bool hasMissedGenerations = generation != m_LastGeneration + 1;
     
-    for (int column = startColumn; column < endColumn; ++column)
-        for (int row = 0; row < Variables::numRows; ++row)
-            m_Grid.getCell (row, column)->updateFade();
+    for (int tileIndex = 0; tileIndex < m_NumTileRows * m_NumTileColumns; ++tileIndex)
+    {
+        if (! hasMissedGenerations && ! m_Snapshot->getTileChanged (tileIndex))
+            continue;
+        
+        for (int tileRow = 0; tileRow < Variables::tileNumRows; ++tileRow)
+        {
+            juce::int64& rowTime = m_RowFadeTimes[tileIndex * Variables::tileNumRows + tileRow];
+            rowTime = m_FadeTime - juce::jmax ((juce::int64) 0, juce::jmin (m_TileSettleTimes[tileIndex], m_FadeTime) - rowTime);
+        }
+        
+        m_TileSettleTimes[tileIndex] = m_FadeTime + m_NumFadeSamples;
+        m_TileNumFadingRows[tileIndex] = getTileNumRows (tileIndex);
+    }
+    
+    m_LastGeneration = generation;
+}
+
+/**
+    Publishes cell states and fade values to the editor at the UI refresh rate, at most
+    Variables::maxDisplayNumRows by Variables::maxDisplayNumColumns of them, so the cost doesn't
+    grow with the grid. Each display cell shows the mean fade of the cells behind it, whose sum
+    is kept up to date as fades move, and the state of the first of them.
+    @param numSamples Number of samples processed since the last call.
+ */
+
+void Synthesis::updateDisplaySnapshot (int numSamples)
+{
+    m_SamplesUntilDisplay -= numSamples;
+    
+    if (m_SamplesUntilDisplay > 0)
+        return;
+    
+    m_SamplesUntilDisplay += juce::roundToInt (m_SampleRate * Variables::uiRefreshRate / 1000.0f);
+    
+    GridSnapshot& display = m_DisplaySnapshots.getWriteBuffer();
+    display.setGeneration (m_Snapshot->getGeneration());
+    
+    for (int displayRow = 0; displayRow < m_NumDisplayRows; ++displayRow)
+    {
+        int startRow = getDisplayStart (displayRow, m_NumDisplayRows, m_NumRows);
+        int numRows = getDisplayStart (displayRow + 1, m_NumDisplayRows, m_NumRows) - startRow;
+        
+        const double* displayFades = m_DisplayFades + displayRow * m_NumDisplayColumns;
+        CellSpan<float> fades = display.getFades().getRow (displayRow);
+        
+        for (int displayColumn = 0; displayColumn < m_NumDisplayColumns; ++displayColumn)
+        {
+            int startColumn = getDisplayStart (displayColumn, m_NumDisplayColumns, m_NumColumns);
+            int numColumns = getDisplayStart (displayColumn + 1, m_NumDisplayColumns, m_NumColumns) - startColumn;
+            
+            fades[displayColumn] = juce::jlimit (0.0f, 1.0f, (float) (displayFades[displayColumn] / (numRows * numColumns)));
+            display.setCellIsAlive (displayRow, displayColumn, m_Snapshot->getCellIsAlive (startRow, startColumn));
+        }
+    }
+    
+    m_DisplaySnapshots.publish();
 }
 
 
@@ -146,40 +470,131 @@ void Synthesis::updateFadeValues (int oscillatorIndex)
     @param blockSize Block size to be used.
  */
 
-void Synthesis::prepareToPlay (float sampleRate, int blockSize)
+void Synthesis::prepareToPlay (float sampleRate, int blockSize, int numChannels)
 {
-    // Setup oscillators.
-    auto frequency = Variables::startFrequency;
+    // Setup oscillators, starting silent since every fade starts at zero.
+    float frequencies[Variables::numOscillators + 1];
+    frequencies[0] = Variables::startFrequency;
+    
+    // One partition per render thread. Workers poll between blocks, so each one has to be given enough
+    // registers to be worth a realtime core, which leaves small banks on the audio thread alone.
+    int numRegisters = (Variables::numOscillators + (int) OscillatorBank::Register::SIMDNumElements - 1) / (int) OscillatorBank::Register::SIMDNumElements;
+    int numRenderWorkers = Variables::numRenderWorkers;
+    
+    if (numRenderWorkers < 0)
+        numRenderWorkers = juce::jlimit (0, juce::SystemStats::getNumCpus() - 1, numRegisters / Variables::renderRegistersPerWorker - 1);
+    
+    m_RenderPool.setNumWorkers (numRenderWorkers, Variables::useRenderWorkerAffinity);
+    m_OscillatorBank.prepareToPlay (Variables::numOscillators, sampleRate, blockSize, numRenderWorkers + 1);
+    m_OscillatorBank.setGainDecay (Variables::startFrequency);
+    m_OscillatorBank.setCumulativePanning (Variables::useCumulativePanning && Variables::numOscillators == 16);
     
     for (int i = 0; i < Variables::numOscillators; ++i)
     {
-        m_Oscillators[i]->prepareToPlay (frequency, sampleRate, blockSize);
+        m_OscillatorBank.setFrequency (i, frequencies[i]);
+        m_OscillatorBank.setModulation (i, i, frequencies[i] / ((i + 1) * 5));
         
         // Harmonic series: https://en.wikipedia.org/wiki/Harmonic_series_(mathematics)
         // And also this: https://en.wikipedia.org/wiki/Inharmonicity
-        frequency += frequency / (i + 1.0f) * Variables::inharmonicity;
+        frequencies[i + 1] = frequencies[i] + frequencies[i] / (i + 1.0f) * Variables::inharmonicity;
     }
     
     // Setup LFOs.
     for (int i = 0; i < Variables::numLFOs; ++i)
         m_LFOs[i]->prepareToPlay (Variables::frequencyLFO[i], sampleRate, blockSize);
-
-    m_FilterModulator.prepareToPlay(0.1f, sampleRate, blockSize);
+    
+    m_FilterModulator.prepareToPlay (Variables::filterModulationRate, sampleRate, blockSize);
     
     // Set member variables.
     setBlockSize (blockSize);
     setSampleRate (sampleRate);
     
-    // Setup filter.
-    m_FilterLeft.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, Variables::filterCutoff));
-    m_FilterRight.setCoefficients (juce::IIRCoefficients::makeLowPass (sampleRate, Variables::filterCutoff));
+    // Scratch buffers used by processBlock, which never allocates.
+    m_Block.setSize (juce::jmax (2, numChannels), blockSize);
+    m_ModulationBuffer.calloc ((size_t) (Variables::numOscillators * blockSize));
+    m_FilterCutoffs.calloc ((size_t) blockSize);
+    
+    // Setup fade values and display snapshots for the current grid size.
+    m_NumRows = m_Grid.getNumRows();
+    m_NumColumns = m_Grid.getNumColumns();
+    m_Fades.setSize (m_NumRows, m_NumColumns);
+    
+    m_NumDisplayRows = juce::jmin (m_NumRows, Variables::maxDisplayNumRows);
+    m_NumDisplayColumns = juce::jmin (m_NumColumns, Variables::maxDisplayNumColumns);
+    m_DisplayFades.calloc ((size_t) (m_NumDisplayRows * m_NumDisplayColumns));
+    
+    // The audio thread isn't running, but the editor may be reading a snapshot, so it is locked out.
+    // Snapshots of the right size are kept, so restarting playback doesn't block the editor.
+    {
+        const juce::ScopedLock lock (m_DisplayLock);
+        
+        for (int i = 0; i < 3; ++i)
+        {
+            GridSnapshot& display = m_DisplaySnapshots.getBuffer (i);
+            
+            if (display.getNumRows() != m_NumDisplayRows || display.getNumColumns() != m_NumDisplayColumns)
+                display.setSize (m_NumDisplayRows, m_NumDisplayColumns, true);
+        }
+    }
+    
+    m_SamplesUntilDisplay = 0;
+    
+    // Setup partials of the spectral engine, one per fade value so fades can be used as
+    // amplitudes directly. Padding values past the last column stay at zero, and so silent.
+    // Gains are divided by the square root of the cells per oscillator, so a block of live
+    // cells has about the power of its oscillator, since partials add up incoherently.
+    int stride = m_Fades.getStride();
+    float cellGain = 1.0f / std::sqrt ((float) m_NumRows * juce::jmax (1.0f, (float) m_NumColumns / Variables::numOscillators));
+    
+    m_SpectralSynthesis.prepareToPlay (m_NumRows * stride, sampleRate);
+    
+    for (int row = 0; row < m_NumRows; ++row)
+    {
+        // Rows pan the same way as in getOscillatorPan.
+        float pan = (float) (m_NumRows - 2 * row - 1) / (float) m_NumRows;
+        
+        for (int column = 0; column < m_NumColumns; ++column)
+        {
+            float frequency = getCellFrequency (frequencies, row, column);
+            m_SpectralSynthesis.setPartial (row * stride + column, frequency, getSpectralGainDecay (cellGain, frequency), pan);
+        }
+    }
+    
+    // Every fade starts at zero, so every tile starts out fading.
+    m_NumTileRows = (m_NumRows + Variables::tileNumRows - 1) / Variables::tileNumRows;
+    m_NumTileColumns = ((m_NumColumns + 63) / 64 + Variables::tileNumWords - 1) / Variables::tileNumWords;
+    m_NumFadeSamples = (int) std::ceil (1.0f / Variables::fadeAmount) + 1;
+    m_FadeTime = 0;
+    m_NextFadeRow = 0;
+    
+    m_TileSettleTimes.calloc ((size_t) (m_NumTileRows * m_NumTileColumns));
+    m_TileNumFadingRows.calloc ((size_t) (m_NumTileRows * m_NumTileColumns));
+    m_RowFadeTimes.calloc ((size_t) (m_NumTileRows * m_NumTileColumns * Variables::tileNumRows));
+    
+    for (int tileIndex = 0; tileIndex < m_NumTileRows * m_NumTileColumns; ++tileIndex)
+    {
+        m_TileSettleTimes[tileIndex] = m_NumFadeSamples;
+        m_TileNumFadingRows[tileIndex] = getTileNumRows (tileIndex);
+    }
+    
+    for (int i = 0; i < Variables::numOscillators; ++i)
+        m_OscillatorFades[i] = m_OscillatorPans[i] = 0.0;
+    
+    m_LastGeneration = -1;
+    m_OutputIsSilent = true;
+    
+    m_Profiler.setDeadline (blockSize / sampleRate);
+    
+    // Setup filter and distortion.
+    m_Filter.prepareToPlay (sampleRate);
+    m_Saturator.prepareToPlay (blockSize);
     
-    // Setup reverb.
-    juce::Reverb::Parameters reverbParameters;
-    reverbParameters.dryLevel = 0.5f;
-    reverbParameters.wetLevel = 0.5f;
-    reverbParameters.roomSize = 1.0f;
-    m_Reverb.reset();
+    // Setup reverbs, whose tails then carry on from block to block.
+    m_ConvolutionReverb.prepareToPlay (sampleRate);
+    m_Reverb.prepareToPlay (sampleRate);
+    
+    // Setup limiter, whose lookahead depends on the sample rate.
+    m_Limiter.prepareToPlay (sampleRate);
 }
 
 
@@ -196,62 +611,106 @@ void Synthesis::processBlock (juce::AudioBuffer<float>& buffer)
     int numChannels = buffer.getNumChannels();
     int blockSize = buffer.getNumSamples();
     
-    float sample = 0;
-    float gain;
+    if (m_BlockSize <= 0)
+    {
+        buffer.clear();
+        return;
+    }
+    
+    // Scratch buffers are sized for the prepared block size and channel count, so anything
+    // larger is split into slices which refer to the caller's buffer without copying.
+    if (blockSize > m_BlockSize || numChannels > m_Block.getNumChannels())
+    {
+        jassert (numChannels <= m_Block.getNumChannels());
+        
+        for (int start = 0; start < blockSize; start += m_BlockSize)
+        {
+            juce::AudioBuffer<float> slice (buffer.getArrayOfWritePointers(), juce::jmin (numChannels, m_Block.getNumChannels()), start, juce::jmin (m_BlockSize, blockSize - start));
+            processBlock (slice);
+        }
+        
+        return;
+    }
+    
+    const AllocationTrap allocationTrap ("Synthesis::processBlock");
     
-    juce::AudioBuffer<float> block;
-    juce::Array<float> panValues;
+    // Latest grid state, published by the grid without locking.
+    m_Snapshot = &m_Grid.getSnapshot();
+    
+    if (m_Snapshot->getNumRows() != m_NumRows || m_Snapshot->getNumColumns() != m_NumColumns)
+    {
+        buffer.clear();
+        return;
+    }
     
-    block.setSize (numChannels, blockSize);
-    panValues.ensureStorageAllocated (m_BlockSize);
+    juce::int64 blockStart = Profiler::getTicks();
+    
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::controlValues);
+        updateActiveTiles();
+    }
+    
+    // Preallocated scratch space, shrunk to this block without reallocating.
+    juce::AudioBuffer<float>& block = m_Block;
+    block.setSize (juce::jmax (2, numChannels), blockSize, false, false, true);
     
     buffer.clear();
     block.clear();
     
-    for (int oscillatorIndex = 0; oscillatorIndex < Variables::numOscillators; ++oscillatorIndex)
+    // Stays true while every oscillator, or every partial, is culled.
+    bool blockIsSilent = true;
+    
+    // Every oscillator gets a block of its LFO of its own, so oscillators sharing an LFO
+    // each take the next block of it in turn, as when they were rendered one after another.
+    const float* modulators[Variables::numOscillators];
+    
     {
-        panValues.clearQuick();
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::oscillators);
         
-        for (int i = 0; i < blockSize; ++i)
-        {
-            auto modulator = m_LFOs[oscillatorIndex % Variables::numLFOs]->processSample();
-            
-            // Frequency modulation.
-            auto currentFrequency = m_Oscillators[oscillatorIndex]->getFrequency();
-            auto modulatedFrequency = currentFrequency + ((currentFrequency / ((oscillatorIndex + 1) * 5)) * modulator);
-            
-            m_Oscillators[oscillatorIndex]->setFrequency (modulatedFrequency);
-            m_Oscillators[oscillatorIndex]->updatePhaseDelta();
-            
-            // Sample to be further processed.
-            sample = m_Oscillators[oscillatorIndex]->processSample();
-            
-            // Gain to be applied.
-            gain = getOscillatorGain (oscillatorIndex);
-            gain *= getSpectralGainDecay (gain, m_Oscillators[oscillatorIndex]->getFrequency());
-            
-            // Pan to be applied.
-            panValues.add (getOscillatorPan (oscillatorIndex));
-            
-            // Update fade values for entire column.
-            updateFadeValues (oscillatorIndex);
+        for (int i = 0; i < Variables::numOscillators; ++i)
+            m_LFOs[i % Variables::numLFOs]->renderBlock (m_ModulationBuffer + i * blockSize, blockSize);
+    }
+    
+    for (int start = 0; start < blockSize; start += m_ControlPeriod)
+    {
+        int numSamples = juce::jmin (m_ControlPeriod, blockSize - start);
         
-            // Apply processing to sample.
-            sample *= gain;
-            
-            // Add to buffer.
-            for (int channel = 0; channel < numChannels; ++channel)
+        // Every cell is a partial of its own, its fade used as its amplitude.
+        if (m_Engine == Engine::Spectral)
+        {
             {
-                auto* channelData = block.getWritePointer (channel);
-                channelData[i] += sample;
+                const Profiler::Scope scope (m_Profiler, Profiler::Stage::controlValues);
+                updateFadeValues (numSamples);
             }
             
-            // Reset values.
-            m_Oscillators[oscillatorIndex]->setFrequency (currentFrequency);
+            const Profiler::Scope scope (m_Profiler, Profiler::Stage::oscillators);
+            m_SpectralSynthesis.render (block.getWritePointer (0, start), block.getWritePointer (1, start), numSamples, m_Fades.getData());
+            blockIsSilent = blockIsSilent && m_SpectralSynthesis.isSilent();
+            continue;
         }
         
-        // Apply pan to buffer.
-        m_Panner.processBlock (block, panValues);
+        // Gain, pan and fades only move at the start of each control period.
+        {
+            const Profiler::Scope scope (m_Profiler, Profiler::Stage::controlValues);
+            updateFadeValues (numSamples);
+            
+            for (int oscillatorIndex = 0; oscillatorIndex < Variables::numOscillators; ++oscillatorIndex)
+                updateControlValues (oscillatorIndex);
+        }
+        
+        for (int i = 0; i < Variables::numOscillators; ++i)
+            modulators[i] = m_ModulationBuffer + i * blockSize + start;
+        
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::oscillators);
+        m_OscillatorBank.render (block.getWritePointer (0, start), block.getWritePointer (1, start), numSamples, modulators, &m_RenderPool);
+        blockIsSilent = blockIsSilent && m_OscillatorBank.isSilent();
+    }
+    
+    // Nothing comes in and the tails of the effects have died out, so the effects are bypassed.
+    if (blockIsSilent && m_OutputIsSilent)
+    {
+        finishBlock (blockSize, blockStart);
+        return;
     }
     
     // Add to final audio buffer.
@@ -263,22 +722,218 @@ void Synthesis::processBlock (juce::AudioBuffer<float>& buffer)
     auto* rightChannel = buffer.getWritePointer (1);
     
     // Apply filter.
-    auto filterModulator = m_FilterModulator.processSample();
-    m_FilterLeft.setCoefficients (juce::IIRCoefficients::makeLowPass (m_SampleRate, Variables::filterCutoff * (filterModulator + 1.001f) * 100.0f));
-    m_FilterRight.setCoefficients (juce::IIRCoefficients::makeLowPass (m_SampleRate, Variables::filterCutoff * (filterModulator + 1.001f) * 100.0f));
-    
-    m_FilterLeft.processSamples (leftChannel, buffer.getNumSamples());
-    m_FilterRight.processSamples (rightChannel, buffer.getNumSamples());
-    
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::filter);
+        
+        // The modulator runs every sample, so its rate doesn't depend on the block size.
+        m_FilterModulator.renderBlock (m_FilterCutoffs, blockSize);
+        
+        for (int i = 0; i < blockSize; ++i)
+            m_FilterCutoffs[i] = Variables::filterCutoff * (m_FilterCutoffs[i] + 1.001f) * 100.0f;
+        
+        m_Filter.processStereo (leftChannel, rightChannel, m_FilterCutoffs, blockSize);
+    }
     
     // Apply distortion.
-    for (int i = 0; i < buffer.getNumSamples(); ++i)
     {
-        leftChannel[i] = std::tanhf (leftChannel[i] * 5.0f);
-        rightChannel[i] = std::tanhf (rightChannel[i] * 5.0f);
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::distortion);
+        
+        m_Saturator.processStereo (leftChannel, rightChannel, blockSize);
+    }
+    
+    // Apply convolution reverb.
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::convolution);
+        
+        m_ConvolutionReverb.processStereo (leftChannel, rightChannel, buffer.getNumSamples());
     }
     
     // Apply reverb.
-    m_Reverb.processStereo (leftChannel, rightChannel, buffer.getNumSamples());
-    m_Reverb.reset();
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::reverb);
+        
+        m_Reverb.processStereo (leftChannel, rightChannel, buffer.getNumSamples());
+    }
+    
+    // Apply limiter.
+    {
+        const Profiler::Scope scope (m_Profiler, Profiler::Stage::limiter);
+        
+        m_Limiter.processStereo (leftChannel, rightChannel, buffer.getNumSamples());
+    }
+    
+    // The limiter still holds a delay's worth of audio, so it has to be quiet as well before the effects are bypassed.
+    m_OutputIsSilent = buffer.getMagnitude (0, blockSize) < Variables::silenceThreshold && m_Limiter.isSilent();
+    
+    // While bypassed the limiter isn't run, so it starts again from unity gain rather than carrying on its release.
+    if (m_OutputIsSilent)
+        m_Limiter.reset();
+    
+    finishBlock (blockSize, blockStart);
 }
+
+/**
+    Finishes a block, whether or not the effects were bypassed.
+    @param numSamples Number of samples in the block.
+    @param blockStart Value of Profiler::getTicks when the block started.
+ */
+
+void Synthesis::finishBlock (int numSamples, juce::int64 blockStart)
+{
+    updateDisplaySnapshot (numSamples);
+    
+    m_Profiler.record (Profiler::Stage::block, Profiler::getTicks() - blockStart);
+    m_Profiler.finishTask();
+}
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS
+
+/// Checks that fades moved a budget of rows at a time keep up with the cell states,
+/// and that the sums of fades behind gains, pans and the display match the fades themselves.
+
+class SynthesisTests : public juce::UnitTest
+{
+public:
+    SynthesisTests() : juce::UnitTest ("Synthesis", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        // Neither dimension is a multiple of a tile, and a lap takes a few control periods.
+        Grid grid;
+        grid.stopStepping();
+        grid.setSize (130, 2100);
+        grid.setRandomSeed (0x5f1d);
+        grid.randomise();
+        grid.updateGridState();
+        
+        Synthesis synthesis (grid);
+        synthesis.prepareToPlay (48000.0f, 512, 2);
+        
+        juce::AudioBuffer<float> buffer (2, 512);
+        
+        int numCells = grid.getNumRows() * grid.getNumColumns();
+        int periodNumCells = Variables::maxFadeCellsPerSample * synthesis.getControlPeriod();
+        float lapFade = Variables::fadeAmount * (float) (synthesis.getControlPeriod() * ((numCells + periodNumCells - 1) / periodNumCells + 1));
+        
+        beginTest ("Fades lag the cell states by at most a lap of the grid");
+        
+        for (int i = 0; i < 20; ++i)
+            synthesis.processBlock (buffer);
+        
+        expectGreaterThan (numCells, periodNumCells * 2, "The grid fits in a single control period");
+        expectFadesFollow (synthesis, Variables::fadeAmount * (float) synthesis.m_FadeTime, lapFade);
+        
+        beginTest ("Sums of fades match the fades");
+        
+        // Tiles which changed start fading again from where their fades are.
+        for (int generation = 0; generation < 5; ++generation)
+        {
+            grid.updateGridState();
+            
+            for (int i = 0; i < 7; ++i)
+                synthesis.processBlock (buffer);
+        }
+        
+        expectSumsMatch (synthesis);
+    }
+
+private:
+    /**
+        Checks that the fades of live cells are no further than a lap behind a given fade,
+        and that dead cells are still silent.
+        @param synthesis Synthesis whose fades are checked.
+        @param fade Fade every live cell would have reached without a budget.
+        @param lapFade Amount fades move for during a lap of the grid.
+     */
+    
+    void expectFadesFollow (Synthesis& synthesis, float fade, float lapFade)
+    {
+        int numWrong = 0;
+        
+        for (int row = 0; row < synthesis.m_NumRows; ++row)
+        {
+            for (int column = 0; column < synthesis.m_NumColumns; ++column)
+            {
+                float cellFade = synthesis.m_Fades.getRow (row)[column];
+                
+                if (synthesis.m_Snapshot->getCellIsAlive (row, column))
+                    numWrong += cellFade > fade * 1.001f || cellFade < fade - lapFade;
+                else
+                    numWrong += cellFade != 0.0f;
+            }
+        }
+        
+        expectEquals (numWrong, 0, "Fades strayed from the cell states");
+    }
+    
+    /**
+        Checks the sums of fades of every oscillator against sums computed from scratch.
+        @param synthesis Synthesis whose sums are checked.
+     */
+    
+    void expectSumsMatch (Synthesis& synthesis)
+    {
+        for (int oscillatorIndex = 0; oscillatorIndex < Variables::numOscillators; ++oscillatorIndex)
+        {
+            double fades = 0.0;
+            double pans = 0.0;
+            
+            for (int row = 0; row < synthesis.m_NumRows; ++row)
+            {
+                for (int column = synthesis.getStartColumn (oscillatorIndex); column < synthesis.getEndColumn (oscillatorIndex); ++column)
+                {
+                    fades += synthesis.m_Fades.getRow (row)[column];
+                    pans += row < synthesis.m_NumRows / 2 ? synthesis.m_Fades.getRow (row)[column] : -synthesis.m_Fades.getRow (row)[column];
+                }
+            }
+            
+            expectWithinAbsoluteError (synthesis.m_OscillatorFades[oscillatorIndex], fades, 1.0e-3);
+            expectWithinAbsoluteError (synthesis.m_OscillatorPans[oscillatorIndex], pans, 1.0e-3);
+        }
+        
+        expectGreaterThan (synthesis.getOscillatorGain (0), 0.0f);
+        
+        // Display cells cover blocks of about 8 columns of this grid, and single rows.
+        int numWrong = 0;
+        
+        for (int displayRow = 0; displayRow < synthesis.m_NumDisplayRows; ++displayRow)
+        {
+            for (int displayColumn = 0; displayColumn < synthesis.m_NumDisplayColumns; ++displayColumn)
+            {
+                double fades = 0.0;
+                
+                for (int row = getDisplayStart (synthesis, displayRow, true); row < getDisplayStart (synthesis, displayRow + 1, true); ++row)
+                    for (int column = getDisplayStart (synthesis, displayColumn, false); column < getDisplayStart (synthesis, displayColumn + 1, false); ++column)
+                        fades += synthesis.m_Fades.getRow (row)[column];
+                
+                numWrong += std::abs (synthesis.m_DisplayFades[displayRow * synthesis.m_NumDisplayColumns + displayColumn] - fades) > 1.0e-4;
+            }
+        }
+        
+        expectEquals (synthesis.m_NumDisplayColumns, Variables::maxDisplayNumColumns);
+        expectEquals (numWrong, 0, "Sums of display fades strayed from the fades");
+    }
+    
+    /**
+        Returns the first grid row or column behind a display row or column.
+        @param synthesis Synthesis whose display is checked.
+        @param displayIndex Index of a display row or column.
+        @param isRow Whether the index is a row.
+     */
+    
+    static int getDisplayStart (Synthesis& synthesis, int displayIndex, bool isRow)
+    {
+        if (isRow)
+            return Synthesis::getDisplayStart (displayIndex, synthesis.m_NumDisplayRows, synthesis.m_NumRows);
+        
+        return Synthesis::getDisplayStart (displayIndex, synthesis.m_NumDisplayColumns, synthesis.m_NumColumns);
+    }
+};
+
+static SynthesisTests synthesisTests;
+
+#endif
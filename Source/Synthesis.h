@@ -7,47 +7,116 @@
 class Synthesis
 {
 public:
+    /// Engines available to render the grid.
+    enum class Engine
+    {
+        Oscillators,                                            // One oscillator per block of grid columns, see OscillatorBank.
+        Spectral                                                // One partial per cell, see SpectralSynthesis.
+    };
+    
     Synthesis(Grid& grid);
     ~Synthesis();
     
     // Setter methods.
     void setBlockSize (int blockSize);
     void setSampleRate (float sampleRate);
+    void setControlPeriod (int controlPeriod);
+    void setEngine (Engine engine);
     
     // Getter methods.
     int getBlockSize();
     float getSampleRate();
+    int getControlPeriod();
+    Engine getEngine();
+    GridSnapshot& getDisplaySnapshot();
+    juce::CriticalSection& getDisplayLock();
+    Profiler& getProfiler();
+    FDNReverb& getReverb();
+    ConvolutionReverb& getConvolutionReverb();
+    StateVariableFilter& getFilter();
+    Saturator& getSaturator();
+    OscillatorBank& getOscillatorBank();
+    TruePeakLimiter& getLimiter();
+    int getLatencySamples();
     
     // Helper methods.
+    int getStartColumn (int oscillatorIndex);
+    int getEndColumn (int oscillatorIndex);
+    int getTileNumRows (int tileIndex);
+    static int getDisplayStart (int displayIndex, int numDisplayCells, int numCells);
     float getOscillatorGain (int oscillatorIndex);
     float getOscillatorPan (int oscillatorIndex);
     float getSpectralGainDecay (float gain, float frequency);
+    float getCellFrequency (const float* oscillatorFrequencies, int row, int column);
     
     // State methods.
-    void updateFadeValues (int oscillatorIndex);
+    void updateFadeValues (int numSamples);
+    void updateFadeRow (int tileIndex, int row, float fadeAmount);
+    void updateControlValues (int oscillatorIndex);
+    void updateActiveTiles();
+    void updateDisplaySnapshot (int numSamples);
+    void finishBlock (int numSamples, juce::int64 blockStart);
     
     // Init methods.
-    void prepareToPlay (float sampleRate, int blockSize);
+    void prepareToPlay (float sampleRate, int blockSize, int numChannels);
     
     // DSP methods.
     void processBlock (juce::AudioBuffer<float>& buffer);
-    
+
 private:
-    juce::OwnedArray<SineOscillator> m_Oscillators;             // Array of oscillators.
+    friend class SynthesisTests;
+    
+    RenderPool m_RenderPool;                                    // Realtime threads sharing the oscillator partitions of each block.
+    OscillatorBank m_OscillatorBank;                            // Oscillators, one per block of grid columns.
+    SpectralSynthesis m_SpectralSynthesis;                      // Partials, one per cell, used by the spectral engine.
     juce::OwnedArray<SineOscillator> m_LFOs;                    // Array of LFOs.
     TriangleOscillator m_FilterModulator;                       // Oscillator used to modulate filter cutoff.
     
-    Panner m_Panner;                                            // Panner used to pan oscillators.
-    juce::Reverb m_Reverb;                                      // Reverb used at end of signal chain.
+    ConvolutionReverb m_ConvolutionReverb;                      // Convolution with a loaded impulse response, bypassed until one is loaded.
+    FDNReverb m_Reverb;                                         // Reverb used at end of signal chain, its tail kept across blocks.
     
-    juce::IIRFilter m_FilterLeft;                               // Filter for left channel.
-    juce::IIRFilter m_FilterRight;                              // Filter for right channel.
+    StateVariableFilter m_Filter;                               // Filter for both channels, its cutoff modulated every sample.
+    Saturator m_Saturator;                                      // Oversampled tanh distortion.
     
-    juce::dsp::Limiter<float> m_Limiter;                        // Limiter used at the end of signal chain.
+    TruePeakLimiter m_Limiter;                                  // Lookahead true peak limiter at the end of the signal chain.
     
     Grid& m_Grid;                                               // Reference to grid object.
+    const GridSnapshot* m_Snapshot = nullptr;                   // Grid snapshot used by the current block.
+    TripleBuffer<GridSnapshot> m_DisplaySnapshots;              // Downsampled snapshots of cell states and fades published to the editor.
+    juce::CriticalSection m_DisplayLock;                        // Held while the display snapshots are resized or read, never taken by the audio thread.
+    
+    CellPlane<float> m_Fades;                                   // Fade values used to fade between dead/live states, one per cell.
+    int m_NumRows = 0;                                          // Number of grid rows the fade values were allocated for.
+    int m_NumColumns = 0;                                       // Number of grid columns the fade values were allocated for.
+    int m_SamplesUntilDisplay = 0;                              // Samples left before the next display snapshot is published.
+    int m_NumDisplayRows = 0;                                   // Number of rows of the display snapshots.
+    int m_NumDisplayColumns = 0;                                // Number of columns of the display snapshots.
+    juce::HeapBlock<double> m_DisplayFades;                     // Sum of the fades of the cells behind each cell of the display snapshots.
+    
+    int m_NumTileRows = 0;                                      // Number of grid tiles along the rows.
+    int m_NumTileColumns = 0;                                   // Number of grid tiles along the columns.
+    juce::HeapBlock<juce::int64> m_TileSettleTimes;             // Fade time by which the fades of each grid tile have settled.
+    juce::HeapBlock<int> m_TileNumFadingRows;                   // Rows of each grid tile whose fades haven't been moved up to its settle time.
+    juce::HeapBlock<juce::int64> m_RowFadeTimes;                // Fade time each row of each grid tile has been moved up to, tile by tile.
+    juce::int64 m_FadeTime = 0;                                 // Samples the fades have moved for since prepareToPlay.
+    int m_NumFadeSamples = 0;                                   // Samples needed for a fade to go all the way between 0 and 1.
+    int m_NextFadeRow = 0;                                      // Row of a tile, counted tile by tile, the next fade update starts from.
+    juce::int64 m_LastGeneration = -1;                          // Generation of the last grid snapshot used.
+    double m_OscillatorFades[Variables::numOscillators] = {};  // Sum of the fades of the cells of each oscillator.
+    double m_OscillatorPans[Variables::numOscillators] = {};   // Sum of the fades of the top half of each oscillator's cells, minus the bottom half.
+    
+    bool m_OutputIsSilent = true;                               // True when the last block processed by the effects came out silent.
+    
+    int m_ControlPeriod = Variables::controlPeriod;             // Number of samples between two gain, pan and fade updates.
+    Engine m_Engine = Variables::useSpectralEngine ? Engine::Spectral : Engine::Oscillators;   // Engine used to render the grid.
+    
+    juce::AudioBuffer<float> m_Block;                           // Scratch buffer the oscillators are mixed into.
+    juce::HeapBlock<float> m_ModulationBuffer;                  // Scratch buffer holding a block of LFO for every oscillator.
+    juce::HeapBlock<float> m_FilterCutoffs;                     // Scratch buffer holding the filter cutoff of every sample of a block.
+    
+    Profiler m_Profiler;                                        // Timing of each stage of processBlock.
     
-    int m_BlockSize;                                            // Requested block size.
+    int m_BlockSize = 0;                                        // Requested block size.
     float m_SampleRate;                                         // Requested sample rate.
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Synthesis)
@@ -0,0 +1,67 @@
+#pragma once
+
+
+//================================================//
+/// Lock-free triple buffer used to hand the latest state from one writer thread to one reader thread.
+/// The writer fills the write buffer and publishes it; the reader always gets the most recently
+/// published buffer. Neither side ever blocks or sees a buffer the other side is using.
+
+template <typename Type>
+class TripleBuffer
+{
+public:
+    TripleBuffer() {}
+    ~TripleBuffer() {}
+    
+    // Getter methods.
+    
+    /**
+        Returns one of the three buffers so it can be allocated.
+        Must only be called while neither the writer nor the reader is active.
+        @param index Index of the buffer in range [0,2].
+     */
+    
+    Type& getBuffer (int index)                                     { return m_Buffers[index]; }
+    
+    /**
+        Returns the buffer owned by the writer. Only call from the writer thread.
+     */
+    
+    Type& getWriteBuffer()                                          { return m_Buffers[m_WriteIndex]; }
+    
+    /**
+        Returns the most recently published buffer. Only call from the reader thread.
+        The returned buffer stays valid until the next call.
+     */
+    
+    Type& getReadBuffer()
+    {
+        if ((m_SharedIndex.load (std::memory_order_relaxed) & newDataFlag) != 0)
+            m_ReadIndex = m_SharedIndex.exchange (m_ReadIndex, std::memory_order_acq_rel) & indexMask;
+        
+        return m_Buffers[m_ReadIndex];
+    }
+    
+    // State methods.
+    
+    /**
+        Publishes the write buffer to the reader and hands the writer a free buffer.
+        Only call from the writer thread.
+     */
+    
+    void publish()
+    {
+        m_WriteIndex = m_SharedIndex.exchange (m_WriteIndex | newDataFlag, std::memory_order_acq_rel) & indexMask;
+    }
+    
+private:
+    static constexpr int indexMask = 3;                             // Bits of the shared index holding a buffer index.
+    static constexpr int newDataFlag = 4;                           // Bit set when the shared buffer has not been read yet.
+    
+    Type m_Buffers[3];                                              // Buffers cycled between writer, reader and the shared slot.
+    int m_WriteIndex = 0;                                           // Buffer owned by the writer.
+    int m_ReadIndex = 1;                                            // Buffer owned by the reader.
+    std::atomic<int> m_SharedIndex { 2 };                           // Buffer waiting to be picked up, plus the new data flag.
+    
+    JUCE_DECLARE_NON_COPYABLE (TripleBuffer)
+};
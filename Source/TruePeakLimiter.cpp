@@ -0,0 +1,327 @@
+#include "Headers.h"
+
+
+//================================================//
+// Lookahead true peak limiter.
+
+TruePeakLimiter::TruePeakLimiter()
+{
+    // Phase k interpolates k / oversamplingFactor of the way from the sample detectorDelay samples old to the next one.
+    for (int phase = 1; phase < oversamplingFactor; ++phase)
+    {
+        float* coefficients = m_Coefficients + (phase - 1) * numTaps;
+        float fraction = (float) phase / (float) oversamplingFactor;
+        float sum = 0.0f;
+        
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            float distance = (float) (numTaps - 1 - tap - detectorDelay) + fraction;
+            float sinc = std::sin (juce::MathConstants<float>::pi * distance) / (juce::MathConstants<float>::pi * distance);
+            float window = 0.5f + 0.5f * std::cos (juce::MathConstants<float>::pi * distance / (float) detectorDelay);
+            
+            coefficients[tap] = sinc * window;
+            sum += coefficients[tap];
+        }
+        
+        // Each phase passes DC untouched.
+        for (int tap = 0; tap < numTaps; ++tap)
+            coefficients[tap] /= sum;
+    }
+    
+    prepareToPlay (44100.0f);
+}
+
+TruePeakLimiter::~TruePeakLimiter() {}
+
+
+//================================================//
+// Init methods.
+
+/**
+    Sizes the lookahead, delay and release for a sample rate and clears the limiter.
+    @param sampleRate Sample rate to use.
+ */
+
+void TruePeakLimiter::prepareToPlay (float sampleRate)
+{
+    m_LookaheadSamples = juce::jmax (1, juce::roundToInt (Variables::limiterLookahead * sampleRate));
+    
+    // The peak of each output sample enters the averaged gains a whole window before the sample is output.
+    m_DelaySamples = m_LookaheadSamples - 1 + detectorDelay;
+    
+    m_History.calloc ((size_t) (2 * 2 * numTaps));
+    
+    m_QueueCapacity = m_LookaheadSamples + 1;
+    m_PeakValues.calloc ((size_t) m_QueueCapacity);
+    m_PeakTimes.calloc ((size_t) m_QueueCapacity);
+    
+    m_Gains.calloc ((size_t) m_LookaheadSamples);
+    m_Delay.calloc ((size_t) (2 * m_DelaySamples));
+    
+    m_ReleaseCoefficient = 1.0f - std::exp (-1.0f / (Variables::limiterReleaseTime * sampleRate));
+    
+    reset();
+}
+
+/**
+    Clears the delayed audio and the detected peaks, and brings the gain back to unity.
+ */
+
+void TruePeakLimiter::reset()
+{
+    juce::FloatVectorOperations::clear (m_History, 2 * 2 * numTaps);
+    juce::FloatVectorOperations::clear (m_Delay, 2 * m_DelaySamples);
+    juce::FloatVectorOperations::fill (m_Gains, 1.0f, m_LookaheadSamples);
+    
+    m_HistoryPosition = 0;
+    m_QueueFront = 0;
+    m_QueueSize = 0;
+    m_SampleIndex = 0;
+    m_GainSum = (double) m_LookaheadSamples;
+    m_GainPosition = 0;
+    m_ReleasedGain = 1.0f;
+    m_DelayPosition = 0;
+    m_QuietSamples = m_DelaySamples + numTaps;
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Sets the level the true peak of the output is held below. Can be called from any thread.
+    @param ceiling Ceiling in dB, in range [minCeiling, maxCeiling].
+ */
+
+void TruePeakLimiter::setCeiling (float ceiling)
+{
+    m_Ceiling.store (juce::jlimit (minCeiling, maxCeiling, ceiling), std::memory_order_relaxed);
+}
+
+
+//================================================//
+// Getter methods.
+
+float TruePeakLimiter::getCeiling()                                 { return m_Ceiling.load (std::memory_order_relaxed); }
+int TruePeakLimiter::getLatencySamples()                            { return m_DelaySamples; }
+
+/**
+    Returns the largest gain reduction in dB applied since the last call, and starts a new measurement.
+    Lock free, meant to be polled by a single reader such as the editor.
+ */
+
+float TruePeakLimiter::getGainReduction()
+{
+    return m_GainReduction.exchange (0.0f, std::memory_order_relaxed);
+}
+
+/**
+    Returns true when every sample still held by the limiter is below the silence threshold.
+ */
+
+bool TruePeakLimiter::isSilent()
+{
+    return m_QuietSamples >= m_DelaySamples + numTaps;
+}
+
+
+//================================================//
+// DSP methods.
+
+/**
+    Limits a stereo pair of buffers in place, delaying them by getLatencySamples.
+    @param left Left channel.
+    @param right Right channel.
+    @param numSamples Number of samples.
+ */
+
+void TruePeakLimiter::processStereo (float* left, float* right, int numSamples)
+{
+    const float ceilingGain = juce::Decibels::decibelsToGain (getCeiling());
+    const float averageScale = 1.0f / (float) m_LookaheadSamples;
+    
+    float* leftHistory = m_History;
+    float* rightHistory = m_History + 2 * numTaps;
+    float* leftDelay = m_Delay;
+    float* rightDelay = m_Delay + m_DelaySamples;
+    
+    float minimumGain = 1.0f;
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        m_HistoryPosition = m_HistoryPosition + 1 == numTaps ? 0 : m_HistoryPosition + 1;
+        leftHistory[m_HistoryPosition] = leftHistory[m_HistoryPosition + numTaps] = left[i];
+        rightHistory[m_HistoryPosition] = rightHistory[m_HistoryPosition + numTaps] = right[i];
+        
+        bool isQuiet = std::abs (left[i]) < Variables::silenceThreshold && std::abs (right[i]) < Variables::silenceThreshold;
+        m_QuietSamples = isQuiet ? juce::jmin (m_QuietSamples + 1, m_DelaySamples + numTaps) : 0;
+        
+        float peak = juce::jmax (getTruePeak (leftHistory + m_HistoryPosition + 1), getTruePeak (rightHistory + m_HistoryPosition + 1));
+        pushPeak (peak);
+        
+        // Gain needed for the largest peak of the window, falling at once and rising back slowly.
+        float windowPeak = getWindowPeak();
+        float targetGain = windowPeak > ceilingGain ? ceilingGain / windowPeak : 1.0f;
+        
+        if (targetGain < m_ReleasedGain)
+            m_ReleasedGain = targetGain;
+        else
+            m_ReleasedGain += (targetGain - m_ReleasedGain) * m_ReleaseCoefficient;
+        
+        // Every gain averaged was computed with the output sample in its window, so the average never lets it through.
+        m_GainSum += (double) m_ReleasedGain - (double) m_Gains[m_GainPosition];
+        m_Gains[m_GainPosition] = m_ReleasedGain;
+        m_GainPosition = m_GainPosition + 1 == m_LookaheadSamples ? 0 : m_GainPosition + 1;
+        
+        float gain = (float) m_GainSum * averageScale;
+        minimumGain = juce::jmin (minimumGain, gain);
+        
+        float delayedLeft = leftDelay[m_DelayPosition];
+        float delayedRight = rightDelay[m_DelayPosition];
+        leftDelay[m_DelayPosition] = left[i];
+        rightDelay[m_DelayPosition] = right[i];
+        m_DelayPosition = m_DelayPosition + 1 == m_DelaySamples ? 0 : m_DelayPosition + 1;
+        
+        left[i] = delayedLeft * gain;
+        right[i] = delayedRight * gain;
+        
+        ++m_SampleIndex;
+    }
+    
+    // Only ever raised here and cleared by the reader, so the meter holds the largest reduction between two reads.
+    float reduction = -juce::Decibels::gainToDecibels (minimumGain, -100.0f);
+    float published = m_GainReduction.load (std::memory_order_relaxed);
+    
+    while (reduction > published && ! m_GainReduction.compare_exchange_weak (published, reduction, std::memory_order_relaxed)) {}
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Returns the largest magnitude of a channel between the sample detectorDelay samples old and the next one,
+    including the points interpolated in between.
+    @param history Last numTaps samples of the channel, oldest first.
+ */
+
+float TruePeakLimiter::getTruePeak (const float* history)
+{
+    float peak = std::abs (history[numTaps - 1 - detectorDelay]);
+    
+    for (int phase = 1; phase < oversamplingFactor; ++phase)
+    {
+        const float* coefficients = m_Coefficients + (phase - 1) * numTaps;
+        float value = 0.0f;
+        
+        for (int tap = 0; tap < numTaps; ++tap)
+            value += coefficients[tap] * history[tap];
+        
+        peak = juce::jmax (peak, std::abs (value));
+    }
+    
+    return peak;
+}
+
+/**
+    Adds the peak of the newest sample to the monotonic queue, after dropping the peaks leaving the window.
+    Peaks smaller than a newer one can never be the largest again, so they are dropped from the back,
+    which keeps the largest peak of the window at the front.
+    @param peak True peak of the newest sample.
+ */
+
+void TruePeakLimiter::pushPeak (float peak)
+{
+    // The window holds the peaks of the last m_LookaheadSamples + 1 samples. Expired peaks go first,
+    // so the queue never holds more than the window, including the peak being added.
+    while (m_QueueSize > 0 && m_PeakTimes[m_QueueFront] < m_SampleIndex - m_LookaheadSamples)
+    {
+        m_QueueFront = m_QueueFront + 1 == m_QueueCapacity ? 0 : m_QueueFront + 1;
+        --m_QueueSize;
+    }
+    
+    while (m_QueueSize > 0 && m_PeakValues[(m_QueueFront + m_QueueSize - 1) % m_QueueCapacity] <= peak)
+        --m_QueueSize;
+    
+    jassert (m_QueueSize < m_QueueCapacity);
+    
+    int back = (m_QueueFront + m_QueueSize) % m_QueueCapacity;
+    m_PeakValues[back] = peak;
+    m_PeakTimes[back] = m_SampleIndex;
+    ++m_QueueSize;
+}
+
+/**
+    Returns the largest true peak of the window, which ends at the newest sample.
+ */
+
+float TruePeakLimiter::getWindowPeak()
+{
+    return m_PeakValues[m_QueueFront];
+}
+
+
+//================================================//
+// Unit tests.
+
+#if JUCE_UNIT_TESTS
+
+/// Checks the window peak kept by the monotonic queue against the maximum of the window found by brute force.
+
+class TruePeakLimiterTests : public juce::UnitTest
+{
+public:
+    TruePeakLimiterTests() : juce::UnitTest ("TruePeakLimiter", "SoundOfLife") {}
+    
+    void runTest() override
+    {
+        juce::Random random (0x5a17);
+        
+        for (int lookahead : { 1, 4, 220 })
+        {
+            beginTest ("Window peak, lookahead " + juce::String (lookahead));
+            
+            // Falling runs fill the queue, rising ones empty it, and random peaks mix both.
+            juce::Array<float> peaks;
+            
+            for (int run = 0; run < 4; ++run)
+            {
+                for (int i = 0; i < 3 * lookahead + 10; ++i)
+                    peaks.add ((float) (3 * lookahead + 10 - i));
+                
+                for (int i = 0; i < lookahead + 3; ++i)
+                    peaks.add ((float) i);
+                
+                for (int i = 0; i < 4 * lookahead; ++i)
+                    peaks.add (random.nextFloat());
+            }
+            
+            TruePeakLimiter limiter;
+            limiter.prepareToPlay ((float) lookahead / Variables::limiterLookahead);
+            expectEquals (limiter.m_LookaheadSamples, lookahead);
+            
+            int numWrong = 0;
+            
+            for (int i = 0; i < peaks.size(); ++i)
+            {
+                limiter.pushPeak (peaks[i]);
+                
+                float windowPeak = 0.0f;
+                
+                for (int j = juce::jmax (0, i - lookahead); j <= i; ++j)
+                    windowPeak = juce::jmax (windowPeak, peaks[j]);
+                
+                if (limiter.getWindowPeak() != windowPeak || limiter.m_QueueSize > limiter.m_QueueCapacity)
+                    ++numWrong;
+                
+                ++limiter.m_SampleIndex;
+            }
+            
+            expectEquals (numWrong, 0, "Window peak differs from the brute force maximum");
+        }
+    }
+};
+
+static TruePeakLimiterTests truePeakLimiterTests;
+
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+
+//================================================//
+/// Stereo lookahead limiter holding the true peak of the output below a ceiling.
+/// Peaks between samples are found by interpolating 4x with a windowed sinc, as in ITU-R BS.1770.
+/// The largest peak over the lookahead window is tracked with a monotonic queue, so each sample costs
+/// O(1) however long the window is. The gain needed for that peak, released exponentially, is smoothed
+/// by a moving average as long as the window, and the audio is delayed so that the gain has fully
+/// come down by the time the peak is output. The delay is reported by getLatencySamples.
+/// The gain reduction is published through an atomic, so the editor can meter it without locking.
+
+class TruePeakLimiter
+{
+public:
+    static constexpr int oversamplingFactor = 4;                            // Number of points the peak detector looks at per sample.
+    static constexpr int numTaps = 12;                                      // Taps of each interpolation phase.
+    static constexpr int detectorDelay = numTaps / 2;                       // Delay in samples of the interpolated peaks.
+    static constexpr float minCeiling = -24.0f;                             // Lowest ceiling in dB.
+    static constexpr float maxCeiling = 0.0f;                               // Highest ceiling in dB.
+    
+    TruePeakLimiter();
+    ~TruePeakLimiter();
+    
+    // Init methods.
+    void prepareToPlay (float sampleRate);
+    void reset();
+    
+    // Setter methods.
+    void setCeiling (float ceiling);
+    
+    // Getter methods.
+    float getCeiling();
+    int getLatencySamples();
+    float getGainReduction();
+    bool isSilent();
+    
+    // DSP methods.
+    void processStereo (float* left, float* right, int numSamples);
+
+private:
+    friend class TruePeakLimiterTests;
+    
+    // Helper methods.
+    float getTruePeak (const float* history);
+    void pushPeak (float peak);
+    float getWindowPeak();
+    
+    float m_Coefficients[(oversamplingFactor - 1) * numTaps] = {};          // Interpolation taps of every phase between two samples, oldest sample first.
+    
+    juce::HeapBlock<float> m_History;                                       // Last numTaps samples of each channel, stored twice in a row so they can be read in one go.
+    int m_HistoryPosition = 0;                                              // Position of the newest sample in the history.
+    
+    juce::HeapBlock<float> m_PeakValues;                                    // Peaks of the monotonic queue, decreasing from front to back.
+    juce::HeapBlock<juce::int64> m_PeakTimes;                               // Sample at which each peak of the queue was detected.
+    int m_QueueFront = 0;                                                   // Position of the largest peak in the queue.
+    int m_QueueSize = 0;                                                    // Number of peaks in the queue.
+    int m_QueueCapacity = 0;                                                // Number of peaks the queue can hold, the length of the window.
+    juce::int64 m_SampleIndex = 0;                                          // Number of samples processed since the limiter was reset.
+    
+    juce::HeapBlock<float> m_Gains;                                         // Last released gains, averaged into the applied gain.
+    double m_GainSum = 0.0;                                                 // Sum of the last released gains.
+    int m_GainPosition = 0;                                                 // Position of the oldest released gain.
+    float m_ReleasedGain = 1.0f;                                            // Gain needed for the window's peak, released exponentially.
+    float m_ReleaseCoefficient = 1.0f;                                      // Fraction of the distance back to unity gain covered each sample.
+    
+    juce::HeapBlock<float> m_Delay;                                         // Delay lines of both channels, one after the other.
+    int m_DelayPosition = 0;                                                // Sample of the delay lines read and written next.
+    int m_QuietSamples = 0;                                                 // Number of input samples in a row below the silence threshold.
+    
+    int m_LookaheadSamples = 1;                                             // Length of the window peaks are looked for in.
+    int m_DelaySamples = 0;                                                 // Delay of the audio, the lookahead plus the delay of the peak detector.
+    
+    std::atomic<float> m_Ceiling { Variables::limiterCeiling };             // Ceiling set by the caller, in dB.
+    std::atomic<float> m_GainReduction { 0.0f };                            // Largest gain reduction in dB since the meter was last read.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TruePeakLimiter)
+};
@@ -7,20 +7,85 @@ struct Variables
     static const int windowWidth = 1024.0;                                                      // Width of plugin window.
     static const bool useColour = true;                                                         // If false UI will be black/white else will be black/red and will use fade value.
     
-    static const int numRows = 16;                                                              // Number of rows for Game of Life simulation.
-    static const int numColumns = 16;                                                           // Number of columns for Game of Life simulation.
+    static const int numRows = 16;                                                              // Default number of rows for Game of Life simulation.
+    static const int numColumns = 16;                                                           // Default number of columns for Game of Life simulation.
+    static const int maxNumRows = 4096;                                                         // Maximum number of rows the grid can be resized to.
+    static const int maxNumColumns = 4096;                                                      // Maximum number of columns the grid can be resized to.
+    
+    static const int cellPlaneAlignment = 64;                                                   // Alignment in bytes of each row of cell planes.
+    
+    static const bool useBitwiseEngine = true;                                                  // If true the grid is updated with the bit-packed engine instead of one byte per cell.
+    static const int tileNumRows = 64;                                                          // Number of rows in a tile updated by a single task.
+    static const int tileNumWords = 16;                                                         // Number of 64 cell words in a tile updated by a single task.
+    static const int numGridWorkers = -1;                                                       // Number of threads helping to update the grid, -1 uses one per spare core.
+    static const bool useGridWorkerAffinity = false;                                            // If true each grid worker thread is pinned to its own core.
+    static const int hashLifeMaxNodes = 1 << 23;                                                // Number of HashLife nodes above which unreachable nodes are collected, doubled if the pattern outgrows it.
+    static const int hashLifeNumBuckets = 1 << 16;                                              // Initial number of buckets in the HashLife node table.
+    static const int hashLifeMaxStepLog = 48;                                                   // Largest power of two generations HashLife can advance in one step.
+    static const int maxSteppedFastForwardLog = 6;                                              // Largest power of two generations other engines fast-forward by, one generation at a time.
+    static const int fastForwardLog = 10;                                                       // Power of two generations the editor's fast-forward key asks for.
     
     static const int gridRefreshRate = 5000;                                                    // Grid refresh rate in ms.
+    static const bool useSimulationThread = true;                                               // If true the grid is stepped by a thread of its own, otherwise by a message thread timer every gridRefreshRate ms.
+    static constexpr double gridStepRate = 1000.0 / gridRefreshRate;                            // Generations per second the simulation thread starts out computing.
     static const int uiRefreshRate = 33;                                                        // UI refresh rate in ms.
+    static const int maxDisplayNumRows = 256;                                                   // Most rows of fades published to the editor, larger grids are averaged down to it.
+    static const int maxDisplayNumColumns = 256;                                                // Most columns of fades published to the editor, larger grids are averaged down to it.
+    
+    static constexpr double profilerWindow = 1.0;                                               // Length in seconds of the windows profiling statistics are gathered over.
+    static const bool showProfiler = false;                                                     // If true the profiling overlay is shown when the editor opens.
     
     static const int lowRandomRange = 0;                                                        // Value used to set the amount of randomness used to init the grid.
     static constexpr float fadeAmount = 0.0000005f;                                             // Value used to increment fade values in cells.
+    static const int maxFadeCellsPerSample = 1024;                                              // Fade values moved per sample of a control period at most, the others catch up on later periods.
+    static const int controlPeriod = 64;                                                        // Number of samples between two updates of fades, gains and pans.
+    static const bool useOnePoleSmoothing = false;                                              // If true gains and pans ease towards each update instead of ramping linearly.
+    static constexpr float onePoleSmoothingTime = 0.005f;                                       // Time constant of one-pole smoothing in seconds.
     
     static const int numOscillators = 16;                                                       // Number of oscillators to instantiate.
+    static const bool useCumulativePanning = false;                                             // If true, and with exactly 16 oscillators, each pan also applies to every oscillator before it, as in the original mix.
     static const int numLFOs = 4;                                                               // Number of LFOs to instantiate
+    static constexpr float silenceThreshold = 0.0001f;                                          // Gain below which oscillators are culled, and level below which the output counts as silent.
+    static const int numRenderWorkers = -1;                                                     // Number of threads helping to render oscillators, -1 adds one per renderRegistersPerWorker registers past the first, up to the spare cores.
+    static const int renderRegistersPerWorker = 32;                                             // Registers of partials each render thread needs before another one pays for its fan-out, about 100 us per 64 samples.
+    static const bool useRenderWorkerAffinity = false;                                          // If true each render worker thread is pinned to its own core.
+    static const int renderWorkerSpinTime = 100;                                                // Time in ms render workers keep polling for blocks after the last one before napping.
+        
+    static const bool useSpectralEngine = false;                                                // If true every cell drives a partial of its own, rendered with an inverse FFT.
+    static const int spectralFFTOrder = 10;                                                     // Log2 of the FFT size used by the spectral engine.
+    static const int spectralOverlap = 4;                                                       // Number of overlapping frames of the spectral engine.
+    static constexpr float spectralRowSpread = 0.01f;                                           // Relative detune between the top and bottom rows of the spectral engine.
         
     static constexpr float startFrequency = 50.0f;                                              // Frequency used for the first oscillator.
     static constexpr float inharmonicity = 1.01f;                                               // Value used to diverge the frequency of oscillators.
     static constexpr float frequencyLFO[4] = {0.01f, 0.002f, 0.023f, 0.001f};                   // Array containing LFO frequencies.
     static constexpr float filterCutoff = 100.0f;                                               // Cutoff value for the filter.
+    static constexpr float filterResonance = 0.7071f;                                           // Resonance of the filter as a Q factor, 0.7071 being the flattest.
+    static constexpr float filterModulationRate = 0.1f;                                         // Frequency in Hz of the triangle LFO modulating the filter cutoff.
+    static const int filterControlPeriod = 16;                                                  // Number of samples between two exact computations of the filter coefficients.
+    static constexpr float saturationDrive = 5.0f;                                              // Gain applied before the tanh distortion.
+    static const int saturationOversamplingOrder = 2;                                           // Oversampling of the tanh distortion as a power of two, in range [1,3].
+        
+    static const int reverbNumLines = 16;                                                       // Number of delay lines in the reverb, a multiple of the SIMD register size.
+    static constexpr float reverbRoomSize = 1.0f;                                               // Scale of the reverb delay lines, in range [0.25,2].
+    static constexpr float reverbDecayTime = 30.0f;                                             // Time in seconds the reverb tail takes to decay by 60 dB.
+    static constexpr float reverbMinDelay = 0.043f;                                             // Shortest reverb delay line in seconds at room size 1.
+    static constexpr float reverbMaxDelay = 0.197f;                                             // Longest reverb delay line in seconds at room size 1.
+    static constexpr float reverbModulationDepth = 0.0005f;                                     // Depth in seconds of the reverb delay modulation.
+    static constexpr float reverbModulationRate = 0.3f;                                         // Average rate in Hz of the reverb delay modulation.
+    static constexpr float reverbDampingFrequency = 6000.0f;                                    // Cutoff of the low pass damping each reverb delay line.
+    static constexpr float reverbSmoothingTime = 0.5f;                                          // Time constant in seconds of reverb room size and decay changes.
+    static constexpr float reverbDryLevel = 0.5f;                                               // Gain of the signal going through the reverb untouched.
+    static constexpr float reverbWetLevel = 0.5f;                                               // Gain of the reverb tail.
+    
+    static const int convolutionHeadSize = 256;                                                 // Samples per partition convolved on the audio thread, which is also the delay of the wet signal.
+    static const int convolutionTailSize = 4096;                                                // Samples per partition convolved on the tail thread, a multiple of the head size.
+    static constexpr float convolutionMaxLength = 20.0f;                                        // Longest impulse response in seconds, longer ones are truncated.
+    static constexpr float convolutionWetLevel = 0.5f;                                          // Gain of the convolved signal added to the dry one.
+    
+    static constexpr float limiterCeiling = -1.0f;                                              // Level in dB the true peak of the output is held below.
+    static constexpr float limiterLookahead = 0.005f;                                           // Time in seconds the limiter looks ahead, which it delays the output by.
+    static constexpr float limiterReleaseTime = 0.1f;                                           // Time constant in seconds of the limiter gain rising back.
+    static constexpr float limiterMeterRange = 12.0f;                                           // Gain reduction in dB filling the whole limiter meter.
+    static constexpr float limiterMeterFalloff = 0.5f;                                          // Gain reduction in dB the limiter meter falls by each UI refresh.
 };
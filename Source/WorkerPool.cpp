@@ -0,0 +1,224 @@
+#include "Headers.h"
+
+
+//================================================//
+// Pool of worker threads which run a batch of indexed tasks with work stealing.
+
+WorkerPool::WorkerPool()
+{
+    // The calling thread always owns the first queue.
+    m_Queues.add (new TaskQueue());
+}
+
+WorkerPool::~WorkerPool()
+{
+    stopWorkers();
+}
+
+
+//================================================//
+// Setter methods.
+
+/**
+    Stops any existing workers and sets how many are started with the next batch which has tasks to share.
+    Must not be called while a batch is running.
+    @param numWorkers Number of worker threads, not counting the calling thread.
+    @param useAffinity If true each worker is pinned to its own core.
+ */
+
+void WorkerPool::setNumWorkers (int numWorkers, bool useAffinity)
+{
+    stopWorkers();
+    
+    m_NumWorkers = juce::jmax (0, numWorkers);
+    m_UseAffinity = useAffinity;
+}
+
+
+//================================================//
+// Getter methods.
+
+int WorkerPool::getNumWorkers()                                     { return m_NumWorkers; }
+
+
+//================================================//
+// Processing methods.
+
+/**
+    Runs a job's task for every index in [0, numTasks) across all workers and the calling thread.
+    Blocks until every task has finished. The job is only referred to, so nothing is allocated per batch.
+    @param job Job whose tasks are run.
+    @param numTasks Number of tasks.
+ */
+
+void WorkerPool::run (Job& job, int numTasks)
+{
+    if (numTasks <= 0)
+        return;
+    
+    // Without workers, or with a single task, there is nothing to share.
+    if (m_NumWorkers == 0 || numTasks == 1)
+    {
+        for (int i = 0; i < numTasks; ++i)
+            job.processTask (i);
+        
+        return;
+    }
+    
+    if (m_Workers.isEmpty())
+        startWorkers();
+    
+    m_Job = &job;
+    m_NumRemaining.store (numTasks);
+    
+    // Contiguous ranges keep neighbouring tiles on the same thread until stealing kicks in.
+    int numQueues = m_Queues.size();
+    
+    for (int queueIndex = 0; queueIndex < numQueues; ++queueIndex)
+    {
+        TaskQueue& queue = *m_Queues[queueIndex];
+        const juce::SpinLock::ScopedLockType lock (queue.lock);
+        
+        queue.tasks.clearQuick();
+        queue.stealIndex = 0;
+        
+        int start = queueIndex * numTasks / numQueues;
+        int end = (queueIndex + 1) * numTasks / numQueues;
+        
+        for (int taskIndex = end - 1; taskIndex >= start; --taskIndex)
+            queue.tasks.add (taskIndex);
+    }
+    
+    for (auto* worker : m_Workers)
+        worker->notify();
+    
+    processTasks (0);
+    m_Finished.wait();
+    m_Job = nullptr;
+}
+
+/**
+    Gets a task from a queue, stealing from the other queues once it is empty.
+    @param queueIndex Index of the queue owned by the calling thread.
+    @param taskIndex Set to the index of the task to run.
+    Returns false once every queue is empty.
+ */
+
+bool WorkerPool::getNextTask (int queueIndex, int& taskIndex)
+{
+    int numQueues = m_Queues.size();
+    
+    for (int i = 0; i < numQueues; ++i)
+    {
+        TaskQueue& queue = *m_Queues[(queueIndex + i) % numQueues];
+        const juce::SpinLock::ScopedLockType lock (queue.lock);
+        
+        if (queue.tasks.size() <= queue.stealIndex)
+            continue;
+        
+        // The owner pops from the back, thieves take from the front.
+        if (i == 0)
+        {
+            taskIndex = queue.tasks.getLast();
+            queue.tasks.removeLast();
+        }
+        
+        else
+        {
+            taskIndex = queue.tasks[queue.stealIndex++];
+        }
+        
+        return true;
+    }
+    
+    return false;
+}
+
+/**
+    Runs tasks until every queue is empty.
+    @param queueIndex Index of the queue owned by the calling thread.
+ */
+
+void WorkerPool::processTasks (int queueIndex)
+{
+    int taskIndex;
+    
+    while (getNextTask (queueIndex, taskIndex))
+    {
+        m_Job->processTask (taskIndex);
+        
+        if (m_NumRemaining.fetch_sub (1) == 1)
+            m_Finished.signal();
+    }
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Starts the worker threads set by setNumWorkers, each with a queue of its own.
+ */
+
+void WorkerPool::startWorkers()
+{
+    for (int i = 0; i < m_NumWorkers; ++i)
+    {
+        m_Queues.add (new TaskQueue());
+        auto* worker = m_Workers.add (new Worker (*this, i + 1));
+        
+        // Core 0 is left to the calling thread.
+        if (m_UseAffinity)
+            worker->setAffinityMask ((juce::uint32) 1 << ((i + 1) % 32));
+        
+        worker->startThread();
+    }
+}
+
+/**
+    Stops the worker threads and removes their queues.
+ */
+
+void WorkerPool::stopWorkers()
+{
+    for (auto* worker : m_Workers)
+        worker->signalThreadShouldExit();
+    
+    for (auto* worker : m_Workers)
+    {
+        worker->notify();
+        worker->stopThread (1000);
+    }
+    
+    m_Workers.clear();
+    m_Queues.removeLast (m_Queues.size() - 1);
+}
+
+
+//================================================//
+// Worker thread.
+
+WorkerPool::Worker::Worker (WorkerPool& pool, int queueIndex)
+    :   juce::Thread ("Grid Worker"),
+        m_Pool (pool),
+        m_QueueIndex (queueIndex)
+{
+}
+
+/**
+    Inherited from juce::Thread class.
+    Sleeps until notified of a new batch, then helps process it.
+ */
+
+void WorkerPool::Worker::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (-1);
+        
+        if (threadShouldExit())
+            break;
+        
+        m_Pool.processTasks (m_QueueIndex);
+    }
+}
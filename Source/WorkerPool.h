@@ -0,0 +1,85 @@
+#pragma once
+
+
+//================================================//
+/// Pool of worker threads which run a batch of indexed tasks with work stealing.
+/// Each worker owns a queue of task indices and steals from the other queues once its own is empty.
+/// The calling thread takes part in the batch and returns once every task has finished.
+/// Threads are only started by the first batch which has tasks to share, so a pool whose owner
+/// never runs such a batch costs nothing.
+
+class WorkerPool
+{
+public:
+    //================================================//
+    /// Work shared across the pool, one call per task index.
+    
+    struct Job
+    {
+        virtual ~Job() {}
+        
+        /**
+            Runs a single task. Called concurrently for different task indices.
+            @param taskIndex Index of the task in range [0, numTasks).
+         */
+        
+        virtual void processTask (int taskIndex) = 0;
+    };
+    
+    WorkerPool();
+    ~WorkerPool();
+    
+    // Setter methods.
+    void setNumWorkers (int numWorkers, bool useAffinity);
+    
+    // Getter methods.
+    int getNumWorkers();
+    
+    // Processing methods.
+    void run (Job& job, int numTasks);
+    
+private:
+    //================================================//
+    /// Worker thread which sleeps until a batch is started.
+    
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker (WorkerPool& pool, int queueIndex);
+        
+        // Thread class methods.
+        void run() override;
+        
+    private:
+        WorkerPool& m_Pool;                                                 // Pool the worker belongs to.
+        int m_QueueIndex;                                                   // Index of the queue owned by the worker.
+    };
+    
+    //================================================//
+    /// Queue of task indices which can be popped by its owner and stolen from by other threads.
+    
+    struct TaskQueue
+    {
+        juce::Array<int> tasks;                                             // Task indices, popped from the back and stolen from the front.
+        int stealIndex = 0;                                                 // Index of the next task to steal.
+        juce::SpinLock lock;                                                // Protects the queue while popping or stealing.
+    };
+    
+    // Helper methods.
+    void startWorkers();
+    void stopWorkers();
+    
+    // Processing methods.
+    bool getNextTask (int queueIndex, int& taskIndex);
+    void processTasks (int queueIndex);
+    
+    juce::OwnedArray<Worker> m_Workers;                                     // Worker threads.
+    juce::OwnedArray<TaskQueue> m_Queues;                                   // One queue per worker plus one for the calling thread.
+    Job* m_Job = nullptr;                                                   // Job of the current batch.
+    int m_NumWorkers = 0;                                                   // Number of worker threads to start with the first shared batch.
+    bool m_UseAffinity = false;                                             // Whether each worker is pinned to its own core.
+    std::atomic<int> m_NumRemaining { 0 };                                  // Tasks of the current batch which have not finished.
+    juce::WaitableEvent m_Finished;                                         // Signalled when the last task of a batch finishes.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WorkerPool)
+};
@@ -0,0 +1,235 @@
+#include "../../../Source/Headers.h"
+#include "BenchmarkRunner.h"
+
+#include <map>
+
+
+//================================================//
+// Timing and reporting of benchmark cases.
+
+/**
+    Creates a runner.
+    @param timePerCase Time in seconds spent measuring each case, not counting calibration.
+    @param filter Only cases whose name contains this string are run, all of them if empty.
+ */
+
+BenchmarkRunner::BenchmarkRunner (double timePerCase, const juce::String& filter)
+    :   m_TimePerCase (timePerCase),
+        m_Filter (filter)
+{
+}
+
+BenchmarkRunner::~BenchmarkRunner() {}
+
+
+//================================================//
+// Benchmark methods.
+
+/**
+    Measures a case and adds its result. The function is first called in doubling batches until a
+    batch lasts minimumBatchTime, which also warms caches and branch predictors, then batches of
+    that size are timed until the time per case has passed.
+    @param name Name of the code being measured.
+    @param parameters Parameters the case is run with.
+    @param unit What one operation is.
+    @param operationsPerCall Number of operations done by one call of the function.
+    @param function Function doing the work.
+ */
+
+void BenchmarkRunner::run (const juce::String& name, const juce::NamedValueSet& parameters, const juce::String& unit,
+                           int operationsPerCall, const std::function<void()>& function)
+{
+    if (m_Filter.isNotEmpty() && ! name.containsIgnoreCase (m_Filter))
+        return;
+    
+    auto timeBatch = [&function] (juce::int64 numCalls)
+    {
+        juce::int64 start = juce::Time::getHighResolutionTicks();
+        
+        for (juce::int64 call = 0; call < numCalls; ++call)
+            function();
+        
+        return juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start);
+    };
+    
+    juce::int64 numCalls = 1;
+    
+    while (timeBatch (numCalls) < minimumBatchTime)
+        numCalls *= 2;
+    
+    std::vector<double> times;
+    double elapsed = 0.0;
+    
+    while ((elapsed < m_TimePerCase || (int) times.size() < minimumNumBatches) && (int) times.size() < maximumNumBatches)
+    {
+        double time = timeBatch (numCalls);
+        elapsed += time;
+        times.push_back (time * 1.0e9 / ((double) numCalls * operationsPerCall));
+    }
+    
+    std::sort (times.begin(), times.end());
+    
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.unit = unit;
+    result.numBatches = (int) times.size();
+    result.numOperations = (juce::int64) times.size() * numCalls * operationsPerCall;
+    result.minimum = times.front();
+    result.median = times.size() % 2 == 1 ? times[times.size() / 2] : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+    
+    for (double time : times)
+        result.mean += time;
+    
+    result.mean /= (double) times.size();
+    
+    for (double time : times)
+        result.deviation += (time - result.mean) * (time - result.mean);
+    
+    result.deviation = std::sqrt (result.deviation / (double) times.size());
+    
+    m_Results.add (result);
+    
+    std::cerr << getKey (name, parameters) << ": " << juce::String (result.median, 2) << " ns/" << unit << "\n";
+}
+
+
+//================================================//
+// Getter methods.
+
+const juce::Array<BenchmarkRunner::Result>& BenchmarkRunner::getResults()  { return m_Results; }
+
+
+//================================================//
+// Export methods.
+
+/**
+    Returns every result as a JSON object, along with the machine the results were measured on.
+ */
+
+juce::var BenchmarkRunner::toJSON()
+{
+    juce::Array<juce::var> results;
+    
+    for (const Result& result : m_Results)
+    {
+        auto* parameters = new juce::DynamicObject();
+        
+        for (const auto& parameter : result.parameters)
+            parameters->setProperty (parameter.name, parameter.value);
+        
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("name", result.name);
+        object->setProperty ("parameters", juce::var (parameters));
+        object->setProperty ("unit", result.unit);
+        object->setProperty ("operations", result.numOperations);
+        object->setProperty ("batches", result.numBatches);
+        object->setProperty ("median_ns", result.median);
+        object->setProperty ("min_ns", result.minimum);
+        object->setProperty ("mean_ns", result.mean);
+        object->setProperty ("stddev_ns", result.deviation);
+        
+        results.add (juce::var (object));
+    }
+    
+    auto* machine = new juce::DynamicObject();
+    machine->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+    machine->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    machine->setProperty ("cpus", juce::SystemStats::getNumCpus());
+    
+    auto* json = new juce::DynamicObject();
+    json->setProperty ("version", 1);
+    json->setProperty ("date", juce::Time::getCurrentTime().toISO8601 (true));
+    json->setProperty ("machine", juce::var (machine));
+    json->setProperty ("results", results);
+    
+    return juce::var (json);
+}
+
+/**
+    Compares results against a baseline by their median time, adding the baseline median and the
+    relative change to each result which has a match. Prints a line for every change beyond the
+    threshold, and returns the number of regressions.
+    @param json Results produced by toJSON.
+    @param baseline Results of an earlier run, as read from its JSON file.
+    @param threshold Relative change counted as a regression or an improvement, 0.1 is 10%.
+ */
+
+int BenchmarkRunner::compareWithBaseline (juce::var& json, const juce::var& baseline, double threshold)
+{
+    std::map<juce::String, double> baselineMedians;
+    
+    if (auto* baselineResults = baseline["results"].getArray())
+        for (const juce::var& result : *baselineResults)
+            baselineMedians[getKey (result)] = (double) result["median_ns"];
+    
+    int numRegressions = 0;
+    int numMatched = 0;
+    
+    if (auto* results = json["results"].getArray())
+    {
+        for (juce::var& result : *results)
+        {
+            auto match = baselineMedians.find (getKey (result));
+            
+            if (match == baselineMedians.end() || match->second <= 0.0)
+                continue;
+            
+            double median = (double) result["median_ns"];
+            double change = median / match->second - 1.0;
+            
+            result.getDynamicObject()->setProperty ("baseline_median_ns", match->second);
+            result.getDynamicObject()->setProperty ("change", change);
+            ++numMatched;
+            
+            if (std::abs (change) <= threshold)
+                continue;
+            
+            if (change > 0.0)
+                ++numRegressions;
+            
+            std::cerr << (change > 0.0 ? "REGRESSION  " : "improvement ") << getKey (result) << ": "
+                      << juce::String (match->second, 2) << " -> " << juce::String (median, 2) << " ns ("
+                      << (change > 0.0 ? "+" : "") << juce::String (change * 100.0, 1) << "%)\n";
+        }
+    }
+    
+    std::cerr << numMatched << " results compared with the baseline, " << numRegressions << " regressions.\n";
+    
+    return numRegressions;
+}
+
+
+//================================================//
+// Helper methods.
+
+/**
+    Returns a string identifying a case, such as "Synthesis::processBlock blockSize=512 sampleRate=48000".
+    @param name Name of the case.
+    @param parameters Parameters of the case, in the order they were set.
+ */
+
+juce::String BenchmarkRunner::getKey (const juce::String& name, const juce::NamedValueSet& parameters)
+{
+    juce::String key = name;
+    
+    for (const auto& parameter : parameters)
+        key << " " << parameter.name.toString() << "=" << parameter.value.toString();
+    
+    return key;
+}
+
+/**
+    Returns the string identifying a case read back from JSON.
+    @param result Result object of a case.
+ */
+
+juce::String BenchmarkRunner::getKey (const juce::var& result)
+{
+    juce::NamedValueSet parameters;
+    
+    if (auto* object = result["parameters"].getDynamicObject())
+        parameters = object->getProperties();
+    
+    return getKey (result["name"].toString(), parameters);
+}
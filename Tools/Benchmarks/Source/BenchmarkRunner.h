@@ -0,0 +1,67 @@
+#pragma once
+
+
+//================================================//
+/// Times benchmark cases and reports them as JSON.
+/// Each case is called in batches long enough for the clock to resolve, and the time per operation
+/// of every batch is kept, so results report the median and spread rather than a single run.
+/// Results can be compared against a baseline written by an earlier run, matched by name and parameters.
+
+class BenchmarkRunner
+{
+public:
+    /// Timing of a single case, in nanoseconds per operation.
+    struct Result
+    {
+        juce::String name;                                                  // Name of the code being measured.
+        juce::NamedValueSet parameters;                                     // Parameters the case was run with.
+        juce::String unit;                                                  // What one operation is, such as a sample or a block.
+        juce::int64 numOperations = 0;                                      // Operations measured across all batches.
+        int numBatches = 0;                                                 // Number of batches measured.
+        double median = 0.0;                                                // Median time of the batches.
+        double minimum = 0.0;                                               // Fastest batch.
+        double mean = 0.0;                                                  // Mean time of the batches.
+        double deviation = 0.0;                                             // Standard deviation of the batches.
+    };
+    
+    BenchmarkRunner (double timePerCase, const juce::String& filter);
+    ~BenchmarkRunner();
+    
+    // Benchmark methods.
+    void run (const juce::String& name, const juce::NamedValueSet& parameters, const juce::String& unit,
+              int operationsPerCall, const std::function<void()>& function);
+    
+    /**
+        Stores a value where the compiler can't prove it unused, so the work producing it is kept.
+        @param value Value to keep.
+     */
+    
+    template <typename Type>
+    static void keep (Type value)
+    {
+        static volatile Type sink;
+        sink = value;
+    }
+    
+    // Getter methods.
+    const juce::Array<Result>& getResults();
+    
+    // Export methods.
+    juce::var toJSON();
+    int compareWithBaseline (juce::var& json, const juce::var& baseline, double threshold);
+
+private:
+    // Helper methods.
+    static juce::String getKey (const juce::String& name, const juce::NamedValueSet& parameters);
+    static juce::String getKey (const juce::var& result);
+    
+    static constexpr double minimumBatchTime = 0.002;                       // Shortest batch in seconds, well above the clock resolution.
+    static constexpr int minimumNumBatches = 10;                            // Batches measured per case even when they run past the time per case.
+    static constexpr int maximumNumBatches = 1000;                          // Batches measured per case at most.
+    
+    juce::Array<Result> m_Results;                                          // Results of every case run so far.
+    double m_TimePerCase;                                                   // Time in seconds spent measuring each case.
+    juce::String m_Filter;                                                  // Only cases whose name contains this are run.
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkRunner)
+};
@@ -0,0 +1,557 @@
+#include "../../../Source/Headers.h"
+#include "BenchmarkRunner.h"
+
+
+//================================================//
+// Benchmarks of the grid and synthesis hot paths, written as JSON. Every case is parameterised over
+// the grid sizes, oscillator counts, block sizes and sample rates given on the command line, and
+// a JSON file from an earlier run can be passed as a baseline to report regressions.
+
+namespace
+{
+    constexpr juce::int64 gridSeed = 0x5eed;                                // Seed of the random grids, so every run times the same cells.
+    
+    /**
+        Prints the usage of the benchmarks.
+     */
+    
+    void printUsage()
+    {
+        std::cout << "Usage: Benchmarks [options]\n"
+                     "  --grid-sizes     Grid sizes as rows x columns (default 16x16,64x64,256x256).\n"
+                     "  --oscillators    Partial counts of the oscillator bank (default 16,64,256).\n"
+                     "  --block-sizes    Block sizes (default 64,512).\n"
+                     "  --sample-rates   Sample rates (default 48000,96000).\n"
+                     "  --time           Seconds spent measuring each case (default 0.2).\n"
+                     "  --filter         Only runs cases whose name contains this.\n"
+                     "  -o, --output     JSON file to write, printed to stdout if missing.\n"
+                     "  --baseline       JSON file of an earlier run to compare with.\n"
+                     "  --threshold      Change in percent counted as a regression (default 10).\n"
+                     "  --test           Runs the unit tests instead of the benchmarks.\n";
+    }
+    
+    /**
+        Runs the unit tests of the SoundOfLife sources, which are only compiled with JUCE_UNIT_TESTS.
+        Returns the exit code, non-zero if any test failed.
+     */
+    
+    int runUnitTests()
+    {
+       #if JUCE_UNIT_TESTS
+        juce::UnitTestRunner testRunner;
+        testRunner.setAssertOnFailure (false);
+        testRunner.runTestsInCategory ("SoundOfLife");
+        
+        int numFailures = 0;
+        
+        for (int i = 0; i < testRunner.getNumResults(); ++i)
+            numFailures += testRunner.getResult (i)->failures;
+        
+        return numFailures > 0 ? 1 : 0;
+       #else
+        std::cerr << "Unit tests need JUCE_UNIT_TESTS to be enabled.\n";
+        return 1;
+       #endif
+    }
+    
+    /**
+        Returns the value given to an option, written either as --option=value or as --option value,
+        or a default value if the option wasn't given. juce::ArgumentList::getValueForOption only
+        reads the next argument for short options, so long options are handled here.
+        @param args Command line arguments.
+        @param option Option names separated by a bar, such as "--output|-o".
+        @param defaultValue Value returned when the option is missing.
+     */
+    
+    juce::String getOptionValue (const juce::ArgumentList& args, juce::StringRef option, const juce::String& defaultValue)
+    {
+        int index = args.indexOfOption (option);
+        
+        if (index < 0)
+            return defaultValue;
+        
+        if (args[index].isLongOption() && args[index].text.containsChar ('='))
+            return args[index].getLongOptionValue();
+        
+        if (index + 1 < args.size() && ! args[index + 1].isOption())
+            return args[index + 1].text;
+        
+        return {};
+    }
+    
+    /**
+        Returns the integers in a comma separated option, or the default list if the option wasn't given.
+        @param args Command line arguments.
+        @param option Name of the option.
+        @param defaultValue Comma separated list used when the option is missing.
+     */
+    
+    juce::Array<int> getIntegerList (const juce::ArgumentList& args, juce::StringRef option, const juce::String& defaultValue)
+    {
+        juce::String value = getOptionValue (args, option, defaultValue);
+        juce::Array<int> values;
+        
+        for (const juce::String& token : juce::StringArray::fromTokens (value, ",", ""))
+            if (token.getIntValue() > 0)
+                values.add (token.getIntValue());
+        
+        return values;
+    }
+    
+    /**
+        Returns the parameters of a case.
+        @param parameters Names and values of the parameters, in the order they are reported.
+     */
+    
+    juce::NamedValueSet makeParameters (std::initializer_list<std::pair<const char*, juce::var>> parameters)
+    {
+        juce::NamedValueSet set;
+        
+        for (const auto& parameter : parameters)
+            set.set (parameter.first, parameter.second);
+        
+        return set;
+    }
+    
+    /**
+        Returns the name of a grid engine.
+        @param engine Engine to name.
+     */
+    
+    const char* getEngineName (Grid::Engine engine)
+    {
+        switch (engine)
+        {
+            case Grid::Engine::Cells:       return "cells";
+            case Grid::Engine::Bitwise:     return "bitwise";
+            case Grid::Engine::HashLife:    return "hashlife";
+        }
+        
+        return "";
+    }
+    
+    
+    //================================================//
+    // Cases.
+    
+    /**
+        Times a generation with every grid engine, and the neighbour count of every cell.
+        @param runner Runner timing the cases.
+        @param numRows Number of grid rows.
+        @param numColumns Number of grid columns.
+     */
+    
+    void runGridCases (BenchmarkRunner& runner, int numRows, int numColumns)
+    {
+        Grid grid;
+        grid.stopStepping();
+        grid.setSize (numRows, numColumns);
+        
+        for (Grid::Engine engine : { Grid::Engine::Cells, Grid::Engine::Bitwise, Grid::Engine::HashLife })
+        {
+            // Each engine starts from the same fresh random state, since a settled grid is cheaper for HashLife.
+            grid.setEngine (engine);
+            grid.setRandomSeed (gridSeed);
+            grid.randomise();
+            
+            runner.run ("Grid::updateGridState", makeParameters ({ { "rows", numRows }, { "columns", numColumns }, { "engine", getEngineName (engine) } }),
+                        "generation", 1, [&grid] { grid.updateGridState(); });
+        }
+        
+        grid.setEngine (Grid::Engine::Cells);
+        grid.setRandomSeed (gridSeed);
+        grid.randomise();
+        
+        runner.run ("Grid::getNumAlive", makeParameters ({ { "rows", numRows }, { "columns", numColumns } }),
+                    "cell", numRows * numColumns, [&grid, numRows, numColumns]
+                    {
+                        int numAlive = 0;
+                        
+                        for (int row = 0; row < numRows; ++row)
+                            for (int column = 0; column < numColumns; ++column)
+                                numAlive += grid.getNumAlive (row, column);
+                        
+                        BenchmarkRunner::keep (numAlive);
+                    });
+    }
+    
+    /**
+        Times the gain and pan of every oscillator, and whole blocks of every synthesis engine.
+        Gains and pans are timed just after a generation, while the changed cells are fading.
+        @param runner Runner timing the cases.
+        @param numRows Number of grid rows.
+        @param numColumns Number of grid columns.
+        @param blockSizes Block sizes to time whole blocks with.
+        @param sampleRates Sample rates to time whole blocks with.
+     */
+    
+    void runSynthesisCases (BenchmarkRunner& runner, int numRows, int numColumns, const juce::Array<int>& blockSizes, const juce::Array<int>& sampleRates)
+    {
+        Grid grid;
+        grid.stopStepping();
+        grid.setSize (numRows, numColumns);
+        
+        {
+            Synthesis synthesis (grid);
+            synthesis.prepareToPlay (48000.0f, 512, 2);
+            
+            juce::AudioBuffer<float> buffer (2, 512);
+            synthesis.processBlock (buffer);
+            grid.updateGridState();
+            synthesis.processBlock (buffer);
+            
+            runner.run ("Synthesis::getOscillatorGain", makeParameters ({ { "rows", numRows }, { "columns", numColumns } }),
+                        "oscillator", Variables::numOscillators, [&synthesis]
+                        {
+                            float gain = 0.0f;
+                            
+                            for (int i = 0; i < Variables::numOscillators; ++i)
+                                gain += synthesis.getOscillatorGain (i);
+                            
+                            BenchmarkRunner::keep (gain);
+                        });
+            
+            runner.run ("Synthesis::getOscillatorPan", makeParameters ({ { "rows", numRows }, { "columns", numColumns } }),
+                        "oscillator", Variables::numOscillators, [&synthesis]
+                        {
+                            float pan = 0.0f;
+                            
+                            for (int i = 0; i < Variables::numOscillators; ++i)
+                                pan += synthesis.getOscillatorPan (i);
+                            
+                            BenchmarkRunner::keep (pan);
+                        });
+        }
+        
+        for (Synthesis::Engine engine : { Synthesis::Engine::Oscillators, Synthesis::Engine::Spectral })
+        {
+            for (int sampleRate : sampleRates)
+            {
+                for (int blockSize : blockSizes)
+                {
+                    Synthesis synthesis (grid);
+                    synthesis.setEngine (engine);
+                    synthesis.prepareToPlay ((float) sampleRate, blockSize, 2);
+                    
+                    juce::AudioBuffer<float> buffer (2, blockSize);
+                    
+                    runner.run ("Synthesis::processBlock",
+                                makeParameters ({ { "rows", numRows }, { "columns", numColumns }, { "engine", engine == Synthesis::Engine::Spectral ? "spectral" : "oscillators" },
+                                                  { "blockSize", blockSize }, { "sampleRate", sampleRate } }),
+                                "block", 1, [&synthesis, &buffer]
+                                {
+                                    juce::ScopedNoDenormals noDenormals;
+                                    synthesis.processBlock (buffer);
+                                });
+                }
+            }
+        }
+    }
+    
+    /**
+        Times the output of an oscillator one virtual call per sample, and rendered a block at a time.
+        @param runner Runner timing the cases.
+        @param name Name of the waveform.
+        @param blockSize Number of samples per call.
+        @param sampleRate Sample rate.
+     */
+    
+    template <typename OscillatorType>
+    void runOscillatorCases (BenchmarkRunner& runner, const char* name, int blockSize, int sampleRate)
+    {
+        OscillatorType oscillator;
+        oscillator.prepareToPlay (Variables::startFrequency, (float) sampleRate, blockSize);
+        
+        juce::HeapBlock<float> samples ((size_t) blockSize, true);
+        Oscillator& base = oscillator;
+        
+        runner.run ("Oscillator::output", makeParameters ({ { "waveform", name }, { "blockSize", blockSize }, { "sampleRate", sampleRate } }),
+                    "sample", blockSize, [&base, &samples, blockSize]
+                    {
+                        float phase = base.getPhase();
+                        const float phaseDelta = base.getPhaseDelta();
+                        
+                        for (int i = 0; i < blockSize; ++i)
+                        {
+                            samples[i] = base.output (phase);
+                            phase += phaseDelta;
+                            
+                            if (phase > 1.0f)
+                                phase -= 1.0f;
+                        }
+                        
+                        base.setPhase (phase);
+                        BenchmarkRunner::keep (samples[blockSize - 1]);
+                    });
+        
+        runner.run ("BlockOscillator::renderBlock", makeParameters ({ { "waveform", name }, { "blockSize", blockSize }, { "sampleRate", sampleRate } }),
+                    "sample", blockSize, [&oscillator, &samples, blockSize]
+                    {
+                        oscillator.renderBlock (samples, blockSize);
+                        BenchmarkRunner::keep (samples[blockSize - 1]);
+                    });
+    }
+    
+    /**
+        Times panning a stereo block with a constant pan and with a pan per sample.
+        @param runner Runner timing the cases.
+        @param blockSize Number of samples per block.
+     */
+    
+    void runPannerCases (BenchmarkRunner& runner, int blockSize)
+    {
+        Panner panner;
+        panner.setPan (0.3f);
+        
+        juce::AudioBuffer<float> buffer (2, blockSize);
+        juce::HeapBlock<float> panValues ((size_t) blockSize);
+        
+        for (int i = 0; i < blockSize; ++i)
+        {
+            buffer.setSample (0, i, 0.5f);
+            buffer.setSample (1, i, 0.5f);
+            panValues[i] = std::sin ((float) i / (float) blockSize);
+        }
+        
+        // Repeated panning decays the samples, so denormals are flushed as on the audio thread.
+        runner.run ("Panner::processBlock", makeParameters ({ { "pan", "constant" }, { "blockSize", blockSize } }),
+                    "sample", blockSize, [&panner, &buffer]
+                    {
+                        juce::ScopedNoDenormals noDenormals;
+                        panner.processBlock (buffer);
+                    });
+        
+        runner.run ("Panner::processBlock", makeParameters ({ { "pan", "perSample" }, { "blockSize", blockSize } }),
+                    "sample", blockSize, [&panner, &buffer, &panValues]
+                    {
+                        juce::ScopedNoDenormals noDenormals;
+                        panner.processBlock (buffer, panValues);
+                    });
+    }
+    
+    /**
+        Times the tanh kernel against std::tanh, and the whole distortion at every oversampling factor.
+        @param runner Runner timing the cases.
+        @param blockSize Number of samples per block.
+     */
+    
+    void runSaturatorCases (BenchmarkRunner& runner, int blockSize)
+    {
+        juce::HeapBlock<float> input ((size_t) blockSize);
+        juce::HeapBlock<float> left ((size_t) blockSize);
+        juce::HeapBlock<float> right ((size_t) blockSize);
+        
+        for (int i = 0; i < blockSize; ++i)
+            input[i] = 0.8f * std::sin (0.05f * (float) i);
+        
+        runner.run ("std::tanh", makeParameters ({ { "blockSize", blockSize } }),
+                    "sample", blockSize, [&input, &left, blockSize]
+                    {
+                        for (int i = 0; i < blockSize; ++i)
+                            left[i] = std::tanh (input[i] * Variables::saturationDrive);
+                        
+                        BenchmarkRunner::keep (left[blockSize - 1]);
+                    });
+        
+        runner.run ("Saturator::saturate", makeParameters ({ { "blockSize", blockSize } }),
+                    "sample", blockSize, [&input, &left, blockSize]
+                    {
+                        std::copy (input.get(), input.get() + blockSize, left.get());
+                        Saturator::saturate (left, blockSize, Variables::saturationDrive);
+                        BenchmarkRunner::keep (left[blockSize - 1]);
+                    });
+        
+        for (int order = Saturator::minOversamplingOrder; order <= Saturator::maxOversamplingOrder; ++order)
+        {
+            Saturator saturator;
+            saturator.setOversamplingOrder (order);
+            saturator.prepareToPlay (blockSize);
+            
+            runner.run ("Saturator::processStereo", makeParameters ({ { "oversampling", 1 << order }, { "blockSize", blockSize } }),
+                        "sample", blockSize, [&saturator, &input, &left, &right, blockSize]
+                        {
+                            std::copy (input.get(), input.get() + blockSize, left.get());
+                            std::copy (input.get(), input.get() + blockSize, right.get());
+                            saturator.processStereo (left, right, blockSize);
+                            BenchmarkRunner::keep (left[blockSize - 1]);
+                        });
+        }
+    }
+    
+    /**
+        Times the true peak limiter on a signal loud enough to be limited all the time.
+        @param runner Runner timing the cases.
+        @param blockSize Number of samples per block.
+        @param sampleRate Sample rate, which sets the length of the lookahead window.
+     */
+    
+    void runLimiterCases (BenchmarkRunner& runner, int blockSize, int sampleRate)
+    {
+        juce::HeapBlock<float> left ((size_t) blockSize);
+        juce::HeapBlock<float> right ((size_t) blockSize);
+        
+        TruePeakLimiter limiter;
+        limiter.prepareToPlay ((float) sampleRate);
+        
+        runner.run ("TruePeakLimiter::processStereo", makeParameters ({ { "blockSize", blockSize }, { "sampleRate", sampleRate } }),
+                    "sample", blockSize, [&limiter, &left, &right, blockSize]
+                    {
+                        for (int i = 0; i < blockSize; ++i)
+                            left[i] = right[i] = 2.0f * std::sin (0.05f * (float) i);
+                        
+                        limiter.processStereo (left, right, blockSize);
+                        BenchmarkRunner::keep (left[blockSize - 1]);
+                    });
+    }
+    
+    /**
+        Times the oscillator bank with every sine kernel, rendering one control period per call as the synthesis does.
+        @param runner Runner timing the cases.
+        @param numPartials Number of partials in the bank.
+        @param blockSize Number of samples per block.
+        @param sampleRate Sample rate.
+     */
+    
+    void runOscillatorBankCases (BenchmarkRunner& runner, int numPartials, int blockSize, int sampleRate)
+    {
+        juce::HeapBlock<float> silence ((size_t) blockSize, true);
+        const float* modulators[] = { silence.get() };
+        
+        juce::HeapBlock<float> left ((size_t) blockSize, true);
+        juce::HeapBlock<float> right ((size_t) blockSize, true);
+        
+        for (SineKernels::Type type : { SineKernels::Type::standard, SineKernels::Type::wavetable, SineKernels::Type::polynomial, SineKernels::Type::phasor })
+        {
+            OscillatorBank bank;
+            bank.prepareToPlay (numPartials, (float) sampleRate, Variables::controlPeriod);
+            bank.setSineKernel (type);
+            
+            for (int partial = 0; partial < numPartials; ++partial)
+            {
+                bank.setFrequency (partial, Variables::startFrequency * (1.0f + partial * 0.37f));
+                bank.setTargets (partial, 1.0f, 0.0f);
+            }
+            
+            runner.run ("OscillatorBank::render",
+                        makeParameters ({ { "oscillators", numPartials }, { "kernel", SineKernels::getName (type) }, { "blockSize", blockSize }, { "sampleRate", sampleRate } }),
+                        "sample", blockSize, [&bank, &left, &right, &modulators, blockSize]
+                        {
+                            for (int start = 0; start < blockSize; start += Variables::controlPeriod)
+                            {
+                                int numSamples = juce::jmin (Variables::controlPeriod, blockSize - start);
+                                std::fill (left.get() + start, left.get() + start + numSamples, 0.0f);
+                                std::fill (right.get() + start, right.get() + start + numSamples, 0.0f);
+                                bank.render (left + start, right + start, numSamples, modulators);
+                            }
+                            
+                            BenchmarkRunner::keep (left[blockSize - 1]);
+                        });
+        }
+    }
+}
+
+
+//================================================//
+// Entry point.
+
+int main (int argc, char* argv[])
+{
+    // Grid is a timer, so the message manager must exist even though it never runs.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    
+    juce::ArgumentList args (argc, argv);
+    
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+    
+    if (args.containsOption ("--test"))
+        return runUnitTests();
+    
+    juce::StringArray gridSizes = juce::StringArray::fromTokens (getOptionValue (args, "--grid-sizes", "16x16,64x64,256x256"), ",", "");
+    juce::Array<int> oscillatorCounts = getIntegerList (args, "--oscillators", "16,64,256");
+    juce::Array<int> blockSizes = getIntegerList (args, "--block-sizes", "64,512");
+    juce::Array<int> sampleRates = getIntegerList (args, "--sample-rates", "48000,96000");
+    double timePerCase = getOptionValue (args, "--time", "0.2").getDoubleValue();
+    double threshold = getOptionValue (args, "--threshold", "10").getDoubleValue() / 100.0;
+    
+    BenchmarkRunner runner (timePerCase, getOptionValue (args, "--filter", {}));
+    
+    for (const juce::String& gridSize : gridSizes)
+    {
+        int numRows = gridSize.upToFirstOccurrenceOf ("x", false, true).getIntValue();
+        int numColumns = gridSize.fromFirstOccurrenceOf ("x", false, true).getIntValue();
+        
+        if (numRows <= 0 || numRows > Variables::maxNumRows || numColumns <= 0 || numColumns > Variables::maxNumColumns)
+        {
+            std::cerr << "Skipping invalid grid size " << gridSize << ".\n";
+            continue;
+        }
+        
+        runGridCases (runner, numRows, numColumns);
+        runSynthesisCases (runner, numRows, numColumns, blockSizes, sampleRates);
+    }
+    
+    for (int sampleRate : sampleRates)
+    {
+        for (int blockSize : blockSizes)
+        {
+            runOscillatorCases<SineOscillator> (runner, "sine", blockSize, sampleRate);
+            runOscillatorCases<SquareOscillator> (runner, "square", blockSize, sampleRate);
+            runOscillatorCases<PulseOscillator> (runner, "pulse", blockSize, sampleRate);
+            runOscillatorCases<TriangleOscillator> (runner, "triangle", blockSize, sampleRate);
+            runOscillatorCases<SawtoothOscillator> (runner, "sawtooth", blockSize, sampleRate);
+            
+            for (int numPartials : oscillatorCounts)
+                runOscillatorBankCases (runner, numPartials, blockSize, sampleRate);
+            
+            runLimiterCases (runner, blockSize, sampleRate);
+        }
+    }
+    
+    for (int blockSize : blockSizes)
+    {
+        runPannerCases (runner, blockSize);
+        runSaturatorCases (runner, blockSize);
+    }
+    
+    juce::var json = runner.toJSON();
+    int numRegressions = 0;
+    
+    if (args.containsOption ("--baseline"))
+    {
+        juce::File baselineFile = juce::File::getCurrentWorkingDirectory().getChildFile (getOptionValue (args, "--baseline", {}));
+        juce::var baseline = juce::JSON::parse (baselineFile);
+        
+        if (baseline.isVoid())
+        {
+            std::cerr << "Can't read baseline " << baselineFile.getFullPathName() << ".\n";
+            return 1;
+        }
+        
+        numRegressions = runner.compareWithBaseline (json, baseline, threshold);
+    }
+    
+    juce::String text = juce::JSON::toString (json);
+    
+    if (args.containsOption ("--output|-o"))
+    {
+        juce::File outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (getOptionValue (args, "--output|-o", {}));
+        
+        if (! outputFile.replaceWithText (text))
+        {
+            std::cerr << "Can't write " << outputFile.getFullPathName() << ".\n";
+            return 1;
+        }
+    }
+    
+    else
+    {
+        std::cout << text << "\n";
+    }
+    
+    // A non-zero exit code lets scripts fail on regressions.
+    return numRegressions > 0 ? 2 : 0;
+}
@@ -0,0 +1,244 @@
+#include "../../../Source/Headers.h"
+
+
+//================================================//
+// Headless renderer writing the output of the grid and synthesis to an audio file, faster than
+// real time. There is no audio device or editor: the grid is stepped in audio time instead of by
+// its timer, so a render is deterministic in its timing and unaffected by the speed of the machine.
+
+namespace
+{
+    /**
+        Prints the usage of the renderer.
+     */
+
+    void printUsage()
+    {
+        std::cout << "Usage: OfflineRenderer --output file.wav|file.flac [options]\n"
+                     "  -o, --output       Output file, the format is chosen from its extension.\n"
+                     "  -m, --minutes      Length of the render in minutes (default 1).\n"
+                     "  -r, --sample-rate  Sample rate in Hz (default 48000).\n"
+                     "  -b, --block-size   Samples per processBlock call (default 512).\n"
+                     "  --bits             Bit depth of the file, 16 or 24 (default 24).\n"
+                     "  --rows             Number of grid rows (default " << Variables::numRows << ").\n"
+                     "  --columns          Number of grid columns (default " << Variables::numColumns << ").\n"
+                     "  --engine           Synthesis engine, oscillators or spectral.\n"
+                     "  --grid-engine      Grid engine, cells, bitwise or hashlife.\n"
+                     "  --step-rate        Generations per second of the grid (default " << Variables::gridStepRate << ").\n"
+                     "  --sine-kernel      Sine implementation of the oscillators, standard, wavetable, polynomial or phasor.\n"
+                     "  --oversampling     Oversampling of the distortion, 2, 4 or 8 (default " << (1 << Variables::saturationOversamplingOrder) << ").\n"
+                     "  --impulse          Impulse response convolved after the distortion, a WAV, AIFF or FLAC file.\n"
+                     "  --room-size        Room size of the reverb, " << FDNReverb::minRoomSize << " to " << FDNReverb::maxRoomSize << " (default " << Variables::reverbRoomSize << ").\n"
+                     "  --decay-time       Decay time of the reverb in seconds, " << FDNReverb::minDecayTime << " to " << FDNReverb::maxDecayTime << " (default " << Variables::reverbDecayTime << ").\n"
+                     "  --profile          Prints the stage timings of the last profiler window.\n";
+    }
+
+    /**
+        Returns the value given to an option, written either as --option=value or as --option value,
+        or a default value if the option wasn't given. juce::ArgumentList::getValueForOption only
+        reads the next argument for short options, so long options are handled here.
+        @param args Command line arguments.
+        @param option Option names separated by a bar, such as "--minutes|-m".
+        @param defaultValue Value returned when the option is missing.
+     */
+
+    juce::String getOptionValue (const juce::ArgumentList& args, juce::StringRef option, const juce::String& defaultValue)
+    {
+        int index = args.indexOfOption (option);
+
+        if (index < 0)
+            return defaultValue;
+
+        if (args[index].isLongOption() && args[index].text.containsChar ('='))
+            return args[index].getLongOptionValue();
+
+        if (index + 1 < args.size() && ! args[index + 1].isOption())
+            return args[index + 1].text;
+
+        return {};
+    }
+
+    /**
+        Creates a writer for an output file, replacing any existing file.
+        Returns nullptr if the file can't be written or the format doesn't support the settings.
+        @param file File to write.
+        @param sampleRate Sample rate of the file.
+        @param bitDepth Bit depth of the file.
+     */
+
+    std::unique_ptr<juce::AudioFormatWriter> createWriter (const juce::File& file, double sampleRate, int bitDepth)
+    {
+        std::unique_ptr<juce::AudioFormat> format;
+
+        if (file.hasFileExtension ("flac"))
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            format = std::make_unique<juce::WavAudioFormat>();
+
+        file.deleteFile();
+        std::unique_ptr<juce::FileOutputStream> stream (file.createOutputStream());
+
+        if (stream == nullptr)
+            return nullptr;
+
+        std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, 2, bitDepth, {}, 0));
+
+        // The writer owns the stream from here on.
+        if (writer != nullptr)
+            stream.release();
+
+        return writer;
+    }
+}
+
+
+//================================================//
+// Entry point.
+
+int main (int argc, char* argv[])
+{
+    // Grid is a timer, so the message manager must exist even though it never runs.
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args (argc, argv);
+
+    if (! args.containsOption ("--output|-o") || args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::File file = juce::File::getCurrentWorkingDirectory().getChildFile (getOptionValue (args, "--output|-o", {}));
+    double minutes = getOptionValue (args, "--minutes|-m", "1").getDoubleValue();
+    double sampleRate = getOptionValue (args, "--sample-rate|-r", "48000").getDoubleValue();
+    int blockSize = getOptionValue (args, "--block-size|-b", "512").getIntValue();
+    int bitDepth = getOptionValue (args, "--bits", "24").getIntValue();
+    int numRows = getOptionValue (args, "--rows", juce::String (Variables::numRows)).getIntValue();
+    int numColumns = getOptionValue (args, "--columns", juce::String (Variables::numColumns)).getIntValue();
+    juce::String engine = getOptionValue (args, "--engine", "").toLowerCase();
+    juce::String gridEngine = getOptionValue (args, "--grid-engine", "").toLowerCase();
+    double stepRate = getOptionValue (args, "--step-rate", juce::String (Variables::gridStepRate)).getDoubleValue();
+    juce::String sineKernel = getOptionValue (args, "--sine-kernel", "").toLowerCase();
+    juce::String impulse = getOptionValue (args, "--impulse", "");
+    int oversampling = getOptionValue (args, "--oversampling", juce::String (1 << Variables::saturationOversamplingOrder)).getIntValue();
+    float roomSize = getOptionValue (args, "--room-size", juce::String (Variables::reverbRoomSize)).getFloatValue();
+    float decayTime = getOptionValue (args, "--decay-time", juce::String (Variables::reverbDecayTime)).getFloatValue();
+
+    if (minutes <= 0.0 || sampleRate <= 0.0 || blockSize <= 0
+        || (oversampling != 2 && oversampling != 4 && oversampling != 8)
+        || numRows <= 0 || numRows > Variables::maxNumRows
+        || numColumns <= 0 || numColumns > Variables::maxNumColumns)
+    {
+        printUsage();
+        return 1;
+    }
+
+    juce::File impulseFile = impulse.isNotEmpty() ? juce::File::getCurrentWorkingDirectory().getChildFile (impulse) : juce::File();
+
+    if (impulse.isNotEmpty() && ! impulseFile.existsAsFile())
+    {
+        std::cerr << "Can't find " << impulseFile.getFullPathName() << ".\n";
+        return 1;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer = createWriter (file, sampleRate, bitDepth);
+
+    if (writer == nullptr)
+    {
+        std::cerr << "Can't write " << file.getFullPathName() << " at " << sampleRate << " Hz, " << bitDepth << " bits.\n";
+        return 1;
+    }
+
+    // The grid is stepped below in audio time, never by its simulation thread.
+    Grid grid;
+    grid.stopStepping();
+    grid.setSize (numRows, numColumns);
+
+    if (gridEngine == "cells")
+        grid.setEngine (Grid::Engine::Cells);
+    else if (gridEngine == "bitwise")
+        grid.setEngine (Grid::Engine::Bitwise);
+    else if (gridEngine == "hashlife")
+        grid.setEngine (Grid::Engine::HashLife);
+
+    Synthesis synthesis (grid);
+
+    if (engine == "oscillators")
+        synthesis.setEngine (Synthesis::Engine::Oscillators);
+    else if (engine == "spectral")
+        synthesis.setEngine (Synthesis::Engine::Spectral);
+
+    for (int type = 0; type < SineKernels::numTypes; ++type)
+        if (sineKernel == SineKernels::getName ((SineKernels::Type) type))
+            synthesis.getOscillatorBank().setSineKernel ((SineKernels::Type) type);
+
+    synthesis.getSaturator().setOversamplingOrder (oversampling == 2 ? 1 : oversampling == 4 ? 2 : 3);
+    synthesis.getReverb().setRoomSize (roomSize);
+    synthesis.getReverb().setDecayTime (decayTime);
+
+    // Rendering offline, the impulse response is loaded by prepareToPlay and its tail convolved inline.
+    synthesis.getConvolutionReverb().setNonRealtime (true);
+
+    if (impulse.isNotEmpty())
+        synthesis.getConvolutionReverb().loadImpulseResponse (impulseFile);
+
+    synthesis.prepareToPlay ((float) sampleRate, blockSize, 2);
+
+    juce::AudioBuffer<float> buffer (2, blockSize);
+    juce::int64 numSamples = (juce::int64) std::llround (minutes * 60.0 * sampleRate);
+    juce::int64 samplesPerStep = juce::jmax ((juce::int64) 1, (juce::int64) std::llround (sampleRate / juce::jmax (1.0e-3, stepRate)));
+    juce::int64 samplesUntilStep = samplesPerStep;
+    int lastPercent = -1;
+
+    juce::int64 startTime = juce::Time::getHighResolutionTicks();
+
+    for (juce::int64 position = 0; position < numSamples; position += blockSize)
+    {
+        int numBlockSamples = (int) juce::jmin ((juce::int64) blockSize, numSamples - position);
+
+        // Steps happen on block boundaries, in audio time rather than on the simulation thread.
+        if (samplesUntilStep <= 0)
+        {
+            grid.step();
+            samplesUntilStep += samplesPerStep;
+        }
+
+        buffer.setSize (2, numBlockSamples, false, false, true);
+        buffer.clear();
+
+        {
+            juce::ScopedNoDenormals noDenormals;
+            synthesis.processBlock (buffer);
+        }
+
+        if (! writer->writeFromAudioSampleBuffer (buffer, 0, numBlockSamples))
+        {
+            std::cerr << "Failed writing " << file.getFullPathName() << ".\n";
+            return 1;
+        }
+
+        samplesUntilStep -= numBlockSamples;
+
+        int percent = (int) (100 * (position + numBlockSamples) / numSamples);
+
+        if (percent != lastPercent)
+        {
+            std::cout << "\rRendering " << percent << "%" << std::flush;
+            lastPercent = percent;
+        }
+    }
+
+    writer.reset();
+
+    double renderTime = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTime);
+    double audioTime = (double) numSamples / sampleRate;
+
+    std::cout << "\nRendered " << audioTime << " s of audio in " << renderTime << " s, "
+              << (renderTime > 0.0 ? audioTime / renderTime : 0.0) << "x real time, "
+              << grid.getGeneration() << " generations.\n";
+
+    if (args.containsOption ("--profile"))
+        std::cout << Profiler::getCSVHeader() << Profiler::toCSV (synthesis.getProfiler().getStats());
+
+    return 0;
+}